@@ -32,6 +32,8 @@ void setup() {
     while (1);
   }
   Serial.println("RF433MHz receiver initialized.");
+  // The transmitter repeats each message, so try to recover corrupted copies by combining them
+  rfDriver.setCombining(true);
 
   lcd.begin();
   lcd.backlight();
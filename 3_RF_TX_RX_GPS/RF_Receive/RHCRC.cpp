@@ -45,6 +45,8 @@
 #define lo8(x) ((x)&0xff) 
 #define hi8(x) ((x)>>8)
 
+#ifdef RH_CRC_NO_TABLES
+
 uint16_t RHcrc16_update(uint16_t crc, uint8_t a)
 {
     int i;
@@ -76,7 +78,8 @@ uint16_t RHcrc_xmodem_update (uint16_t crc, uint8_t data)
     return crc;
 }
 
-uint16_t RHcrc_ccitt_update (uint16_t crc, uint8_t data)
+// RH_ASK calls this from its interrupt handler
+uint16_t RH_INTERRUPT_ATTR RHcrc_ccitt_update (uint16_t crc, uint8_t data)
 {
     data ^= lo8 (crc);
     data ^= data << 4;
@@ -85,6 +88,210 @@ uint16_t RHcrc_ccitt_update (uint16_t crc, uint8_t data)
 	    ^ ((uint16_t)data << 3));
 }
 
+uint16_t RHcrc16_block(uint16_t crc, const uint8_t* buf, uint16_t len)
+{
+    while (len--)
+	crc = RHcrc16_update(crc, *buf++);
+    return crc;
+}
+
+uint16_t RHcrc_xmodem_block(uint16_t crc, const uint8_t* buf, uint16_t len)
+{
+    while (len--)
+	crc = RHcrc_xmodem_update(crc, *buf++);
+    return crc;
+}
+
+uint16_t RHcrc_ccitt_block(uint16_t crc, const uint8_t* buf, uint16_t len)
+{
+    while (len--)
+	crc = RHcrc_ccitt_update(crc, *buf++);
+    return crc;
+}
+
+#else // RH_CRC_NO_TABLES
+
+// Table entries are generated by the compiler from these, one bit at a time,
+// exactly as the bitwise routines above do at run time.
+// Entry n of a reflected (LSBit first) table is the CRC register after shifting n through it
+static constexpr uint16_t RHcrc_reflected(uint16_t crc, uint16_t poly, uint8_t bits)
+{
+    return bits ? RHcrc_reflected((crc & 1) ? ((crc >> 1) ^ poly) : (crc >> 1), poly, bits - 1) : crc;
+}
+
+// Entry n of a normal (MSBit first) table
+static constexpr uint16_t RHcrc_normal(uint16_t crc, uint16_t poly, uint8_t bits)
+{
+    return bits ? RHcrc_normal((crc & 0x8000) ? (uint16_t)((crc << 1) ^ poly) : (uint16_t)(crc << 1), poly, bits - 1) : crc;
+}
+
+// Feed a zero octet through a reflected CRC register
+static constexpr uint16_t RHcrc_reflected_zero(uint16_t crc, uint16_t poly)
+{
+    return (crc >> 8) ^ RHcrc_reflected(crc & 0xff, poly, 8);
+}
+
+// Entry n of slice k of a reflected table: the CRC of octet n followed by k zero octets
+static constexpr uint16_t RHcrc_reflected_slice(uint16_t n, uint16_t poly, uint8_t k)
+{
+    return k ? RHcrc_reflected_zero(RHcrc_reflected_slice(n, poly, k - 1), poly) : RHcrc_reflected(n, poly, 8);
+}
+
+// Feed a zero octet through a normal CRC register
+static constexpr uint16_t RHcrc_normal_zero(uint16_t crc, uint16_t poly)
+{
+    return (uint16_t)(crc << 8) ^ RHcrc_normal(crc & 0xff00, poly, 8);
+}
+
+// Entry n of slice k of a normal table
+static constexpr uint16_t RHcrc_normal_slice(uint16_t n, uint16_t poly, uint8_t k)
+{
+    return k ? RHcrc_normal_zero(RHcrc_normal_slice(n, poly, k - 1), poly) : RHcrc_normal((uint16_t)(n << 8), poly, 8);
+}
+
+#define RH_CRC_CCITT_POLY  0x8408 // Reflected 0x1021
+#define RH_CRC_16_POLY     0xa001 // Reflected 0x8005
+#define RH_CRC_XMODEM_POLY 0x1021
+
+// Expand f(n, k) for n = 0 to 255
+#define RH_CRC_T4(f, n, k)   f((n), k), f((n) + 1, k), f((n) + 2, k), f((n) + 3, k)
+#define RH_CRC_T16(f, n, k)  RH_CRC_T4(f, n, k), RH_CRC_T4(f, (n) + 4, k), RH_CRC_T4(f, (n) + 8, k), RH_CRC_T4(f, (n) + 12, k)
+#define RH_CRC_T64(f, n, k)  RH_CRC_T16(f, n, k), RH_CRC_T16(f, (n) + 16, k), RH_CRC_T16(f, (n) + 32, k), RH_CRC_T16(f, (n) + 48, k)
+#define RH_CRC_T256(f, k)    { RH_CRC_T64(f, 0, k), RH_CRC_T64(f, 64, k), RH_CRC_T64(f, 128, k), RH_CRC_T64(f, 192, k) }
+
+#define RH_CRC_CCITT_ENTRY(n, k)  RHcrc_reflected_slice((n), RH_CRC_CCITT_POLY, (k))
+#define RH_CRC_16_ENTRY(n, k)     RHcrc_reflected_slice((n), RH_CRC_16_POLY, (k))
+#define RH_CRC_XMODEM_ENTRY(n, k) RHcrc_normal_slice((n), RH_CRC_XMODEM_POLY, (k))
+
+// The tables live in flash on AVR, so they must be read with pgm_read_word.
+// Elsewhere they are ordinary const data, so that the routines are safe to call from interrupt
+// handlers on processors like ESP8266 where flash is not always accessible
+#if defined(__AVR__)
+ #include <avr/pgmspace.h>
+ #define RH_CRC_PROGMEM PROGMEM
+ #define RH_CRC_TABLE(t, i) pgm_read_word(&(t)[(i)])
+#else
+ #define RH_CRC_PROGMEM
+ #define RH_CRC_TABLE(t, i) ((t)[(i)])
+#endif
+
+// Slice k of a table is t[k][]. Slice 0 is the ordinary byte-at-a-time table
+RH_CRC_PROGMEM static const uint16_t ccitt_table[RH_CRC_SLICES][256] =
+{
+    RH_CRC_T256(RH_CRC_CCITT_ENTRY, 0),
+#if RH_CRC_SLICES > 1
+    RH_CRC_T256(RH_CRC_CCITT_ENTRY, 1), RH_CRC_T256(RH_CRC_CCITT_ENTRY, 2), RH_CRC_T256(RH_CRC_CCITT_ENTRY, 3),
+#endif
+#if RH_CRC_SLICES > 4
+    RH_CRC_T256(RH_CRC_CCITT_ENTRY, 4), RH_CRC_T256(RH_CRC_CCITT_ENTRY, 5), 
+    RH_CRC_T256(RH_CRC_CCITT_ENTRY, 6), RH_CRC_T256(RH_CRC_CCITT_ENTRY, 7),
+#endif
+};
+
+RH_CRC_PROGMEM static const uint16_t crc16_table[RH_CRC_SLICES][256] =
+{
+    RH_CRC_T256(RH_CRC_16_ENTRY, 0),
+#if RH_CRC_SLICES > 1
+    RH_CRC_T256(RH_CRC_16_ENTRY, 1), RH_CRC_T256(RH_CRC_16_ENTRY, 2), RH_CRC_T256(RH_CRC_16_ENTRY, 3),
+#endif
+#if RH_CRC_SLICES > 4
+    RH_CRC_T256(RH_CRC_16_ENTRY, 4), RH_CRC_T256(RH_CRC_16_ENTRY, 5), 
+    RH_CRC_T256(RH_CRC_16_ENTRY, 6), RH_CRC_T256(RH_CRC_16_ENTRY, 7),
+#endif
+};
+
+RH_CRC_PROGMEM static const uint16_t xmodem_table[RH_CRC_SLICES][256] =
+{
+    RH_CRC_T256(RH_CRC_XMODEM_ENTRY, 0),
+#if RH_CRC_SLICES > 1
+    RH_CRC_T256(RH_CRC_XMODEM_ENTRY, 1), RH_CRC_T256(RH_CRC_XMODEM_ENTRY, 2), RH_CRC_T256(RH_CRC_XMODEM_ENTRY, 3),
+#endif
+#if RH_CRC_SLICES > 4
+    RH_CRC_T256(RH_CRC_XMODEM_ENTRY, 4), RH_CRC_T256(RH_CRC_XMODEM_ENTRY, 5), 
+    RH_CRC_T256(RH_CRC_XMODEM_ENTRY, 6), RH_CRC_T256(RH_CRC_XMODEM_ENTRY, 7),
+#endif
+};
+
+uint16_t RHcrc16_update(uint16_t crc, uint8_t a)
+{
+    return (crc >> 8) ^ RH_CRC_TABLE(crc16_table[0], lo8(crc ^ a));
+}
+
+uint16_t RHcrc_xmodem_update (uint16_t crc, uint8_t data)
+{
+    return (crc << 8) ^ RH_CRC_TABLE(xmodem_table[0], hi8(crc) ^ data);
+}
+
+// RH_ASK calls this from its interrupt handler
+uint16_t RH_INTERRUPT_ATTR RHcrc_ccitt_update (uint16_t crc, uint8_t data)
+{
+    return (crc >> 8) ^ RH_CRC_TABLE(ccitt_table[0], lo8(crc ^ data));
+}
+
+// Process a block with a reflected 16 bit CRC. With slicing, the 2 CRC octets are
+// folded into the first 2 data octets, and each of the N octets is then looked up in the
+// slice that accounts for the number of octets that follow it
+static uint16_t RHcrc_reflected_block(const uint16_t (*t)[256], uint16_t crc, const uint8_t* buf, uint16_t len)
+{
+#if RH_CRC_SLICES > 1
+    while (len >= RH_CRC_SLICES)
+    {
+	crc ^= buf[0] | ((uint16_t)buf[1] << 8);
+ #if RH_CRC_SLICES > 4
+	crc = t[7][lo8(crc)] ^ t[6][hi8(crc)] ^ t[5][buf[2]] ^ t[4][buf[3]]
+	    ^ t[3][buf[4]] ^ t[2][buf[5]] ^ t[1][buf[6]] ^ t[0][buf[7]];
+ #else
+	crc = t[3][lo8(crc)] ^ t[2][hi8(crc)] ^ t[1][buf[2]] ^ t[0][buf[3]];
+ #endif
+	buf += RH_CRC_SLICES;
+	len -= RH_CRC_SLICES;
+    }
+#endif
+    while (len--)
+	crc = (crc >> 8) ^ RH_CRC_TABLE(t[0], lo8(crc ^ *buf++));
+    return crc;
+}
+
+// Process a block with a normal 16 bit CRC. The same as RHcrc_reflected_block, but the
+// CRC octets are folded in the other way round, high octet first
+static uint16_t RHcrc_normal_block(const uint16_t (*t)[256], uint16_t crc, const uint8_t* buf, uint16_t len)
+{
+#if RH_CRC_SLICES > 1
+    while (len >= RH_CRC_SLICES)
+    {
+	crc ^= ((uint16_t)buf[0] << 8) | buf[1];
+ #if RH_CRC_SLICES > 4
+	crc = t[7][hi8(crc)] ^ t[6][lo8(crc)] ^ t[5][buf[2]] ^ t[4][buf[3]]
+	    ^ t[3][buf[4]] ^ t[2][buf[5]] ^ t[1][buf[6]] ^ t[0][buf[7]];
+ #else
+	crc = t[3][hi8(crc)] ^ t[2][lo8(crc)] ^ t[1][buf[2]] ^ t[0][buf[3]];
+ #endif
+	buf += RH_CRC_SLICES;
+	len -= RH_CRC_SLICES;
+    }
+#endif
+    while (len--)
+	crc = (crc << 8) ^ RH_CRC_TABLE(t[0], hi8(crc) ^ *buf++);
+    return crc;
+}
+
+uint16_t RHcrc16_block(uint16_t crc, const uint8_t* buf, uint16_t len)
+{
+    return RHcrc_reflected_block(crc16_table, crc, buf, len);
+}
+
+uint16_t RHcrc_xmodem_block(uint16_t crc, const uint8_t* buf, uint16_t len)
+{
+    return RHcrc_normal_block(xmodem_table, crc, buf, len);
+}
+
+uint16_t RHcrc_ccitt_block(uint16_t crc, const uint8_t* buf, uint16_t len)
+{
+    return RHcrc_reflected_block(ccitt_table, crc, buf, len);
+}
+
+#endif // RH_CRC_NO_TABLES
+
 uint8_t RHcrc_ibutton_update(uint8_t crc, uint8_t data)
 {
     uint8_t i;
@@ -100,5 +307,3 @@ uint8_t RHcrc_ibutton_update(uint8_t crc, uint8_t data)
     
     return crc;
 }
-
-
@@ -11,9 +11,41 @@
 
 #include "RadioHead.h"
 
+// The CRC routines are table driven, using 256 entry lookup tables that are generated
+// at compile time (and placed in PROGMEM on AVR). Compilers without C++11 constexpr support fall back
+// to the original bit-by-bit routines, as does any build that defines RH_CRC_NO_TABLES
+// (eg to save 512 octets of flash per CRC type on very small processors).
+// RHcrc_ccitt_update is safe to call from interrupt handlers.
+#if !defined(RH_CRC_NO_TABLES) && (__cplusplus < 201103L || defined(RH_PLATFORM_ATTINY))
+ #define RH_CRC_NO_TABLES
+#endif
+
+// The block routines can process several octets per step with 'slice-by-N' tables
+// (N tables of 256 entries). This is only worth the memory on larger processors, so it
+// is enabled by default only on Linux and friends. 
+// Define RH_CRC_SLICES to 1, 4 or 8 to override.
+#ifndef RH_CRC_SLICES
+ #if !defined(RH_CRC_NO_TABLES) && ((RH_PLATFORM == RH_PLATFORM_UNIX) || (RH_PLATFORM == RH_PLATFORM_RASPI))
+  #define RH_CRC_SLICES 8
+ #else
+  #define RH_CRC_SLICES 1
+ #endif
+#endif
+#if (RH_CRC_SLICES != 1) && (RH_CRC_SLICES != 4) && (RH_CRC_SLICES != 8)
+ #error RH_CRC_SLICES must be 1, 4 or 8
+#elif (RH_CRC_SLICES != 1) && (defined(RH_CRC_NO_TABLES) || defined(__AVR__))
+ #error RH_CRC_SLICES greater than 1 needs tables in RAM
+#endif
+
 extern uint16_t RHcrc16_update(uint16_t crc, uint8_t a);
 extern uint16_t RHcrc_xmodem_update (uint16_t crc, uint8_t data);
 extern uint16_t RHcrc_ccitt_update (uint16_t crc, uint8_t data);
 extern uint8_t  RHcrc_ibutton_update(uint8_t crc, uint8_t data);
 
+// Block versions of the above. Each gives the same result as calling the corresponding
+// _update routine for each of the len octets in buf, but faster.
+extern uint16_t RHcrc16_block(uint16_t crc, const uint8_t* buf, uint16_t len);
+extern uint16_t RHcrc_xmodem_block(uint16_t crc, const uint8_t* buf, uint16_t len);
+extern uint16_t RHcrc_ccitt_block(uint16_t crc, const uint8_t* buf, uint16_t len);
+
 #endif
@@ -36,6 +36,18 @@ bool RHDatagram::sendto(uint8_t* buf, uint8_t len, uint8_t address)
     return _driver.send(buf, len);
 }
 
+bool RHDatagram::sendtoAsync(uint8_t* buf, uint8_t len, uint8_t address,
+			     RHGenericDriver::SendCallback callback, void* context)
+{
+    setHeaderTo(address);
+    return _driver.sendAsync(buf, len, callback, context);
+}
+
+void RHDatagram::service()
+{
+    _driver.service();
+}
+
 bool RHDatagram::recvfrom(uint8_t* buf, uint8_t* len, uint8_t* from, uint8_t* to, uint8_t* id, uint8_t* flags)
 {
     if (_driver.recv(buf, len))
@@ -49,6 +61,25 @@ bool RHDatagram::recvfrom(uint8_t* buf, uint8_t* len, uint8_t* from, uint8_t* to
     return false;
 }
 
+bool RHDatagram::recvfromView(const uint8_t** buf, uint8_t* len, uint8_t* from, uint8_t* to, uint8_t* id, uint8_t* flags,
+			      uint8_t* copy, uint8_t copyLen)
+{
+    if (_driver.recvView(buf, len, copy, copyLen))
+    {
+	if (from)  *from =  headerFrom();
+	if (to)    *to =    headerTo();
+	if (id)    *id =    headerId();
+	if (flags) *flags = headerFlags();
+	return true;
+    }
+    return false;
+}
+
+void RHDatagram::release()
+{
+    _driver.release();
+}
+
 bool RHDatagram::available()
 {
     return _driver.available();
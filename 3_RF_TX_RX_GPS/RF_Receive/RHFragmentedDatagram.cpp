@@ -0,0 +1,495 @@
+// RHFragmentedDatagram.cpp
+//
+// Define fragmented datagram
+//
+// Transfers longer than one message are split into fragments, reassembled by the receiver
+// in any order, and only the fragments the receiver reports missing are retransmitted.
+//
+// Contributed to the RadioHead project
+
+#include "RHFragmentedDatagram.h"
+
+////////////////////////////////////////////////////////////////////
+// Constructors
+RHFragmentedDatagram::RHFragmentedDatagram(RHGenericDriver& driver, uint8_t thisAddress)
+    : RHDatagram(driver, thisAddress)
+{
+    _timeout = RH_FRAGMENT_DEFAULT_TIMEOUT;
+    _retries = RH_FRAGMENT_DEFAULT_RETRIES;
+    _retransmissions = 0;
+    _lastTransferId = 0;
+    _txActive = false;
+    _rxActive = false;
+    _rxComplete = false;
+    _rxReady = false;
+    _streamCallback = NULL;
+    _streamContext = NULL;
+    setReceiveBuffer(NULL, 0);
+}
+
+////////////////////////////////////////////////////////////////////
+// Public methods
+void RHFragmentedDatagram::setTimeout(uint16_t timeout)
+{
+    _timeout = timeout;
+}
+
+////////////////////////////////////////////////////////////////////
+void RHFragmentedDatagram::setRetries(uint8_t retries)
+{
+    _retries = retries;
+}
+
+////////////////////////////////////////////////////////////////////
+void RHFragmentedDatagram::setReceiveBuffer(uint8_t* buf, uint16_t size)
+{
+#if RH_FRAGMENT_POOL_SIZE
+    if (!buf)
+    {
+	buf = _pool;
+	size = sizeof(_pool);
+    }
+#endif
+    _rxBuf = buf;
+    _rxBufSize = buf ? size : 0;
+}
+
+////////////////////////////////////////////////////////////////////
+void RHFragmentedDatagram::setStreamCallback(StreamCallback callback, void* context)
+{
+    _streamCallback = callback;
+    _streamContext = context;
+}
+
+////////////////////////////////////////////////////////////////////
+uint8_t RHFragmentedDatagram::fragmentSize()
+{
+    uint8_t max = _driver.maxMessageLength();
+    return max > RH_FRAGMENT_HEADER_LEN ? max - RH_FRAGMENT_HEADER_LEN : 0;
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHFragmentedDatagram::sendtoWait(const uint8_t* buf, uint16_t len, uint8_t address)
+{
+    return sendTransfer(buf, NULL, NULL, len, address);
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHFragmentedDatagram::sendtoWait(SourceCallback source, void* context, uint16_t len, uint8_t address)
+{
+    return sendTransfer(NULL, source, context, len, address);
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHFragmentedDatagram::recvfromTransfer(const uint8_t** buf, uint16_t* len, uint8_t* from)
+{
+    if (!_rxReady && RHDatagram::available())
+	receive();
+    if (!_rxReady)
+	return false;
+    _rxReady = false;
+    if (buf)  *buf = _rxOrigin ? NULL : _rxBuf;
+    if (len)  *len = _rxTotal;
+    if (from) *from = _rxFrom;
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHFragmentedDatagram::recvfromTransferTimeout(const uint8_t** buf, uint16_t* len, uint16_t timeout, uint8_t* from)
+{
+    unsigned long starttime = millis();
+    int32_t timeLeft;
+    while ((timeLeft = timeout - (millis() - starttime)) > 0)
+    {
+	if (_rxReady || waitAvailableTimeout(timeLeft))
+	{
+	    if (recvfromTransfer(buf, len, from))
+		return true;
+	}
+	YIELD;
+    }
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////
+uint32_t RHFragmentedDatagram::retransmissions()
+{
+    return _retransmissions;
+}
+
+////////////////////////////////////////////////////////////////////
+void RHFragmentedDatagram::resetRetransmissions()
+{
+    _retransmissions = 0;
+}
+
+////////////////////////////////////////////////////////////////////
+// Sending
+bool RHFragmentedDatagram::sendTransfer(const uint8_t* buf, SourceCallback source, void* context, uint16_t len, uint8_t address)
+{
+    uint8_t fragSize = fragmentSize();
+    if (!len || !fragSize)
+	return false;
+
+    _txAddress = address;
+    _txId = ++_lastTransferId;
+    _txLen = len;
+    _txFragSize = fragSize;
+    _txFragments = ((uint32_t)len + fragSize - 1) / fragSize;
+    _txSent = 0;
+    // Until the receiver says otherwise, assume it has room for a whole window
+    _txBase = 0;
+    _txCount = _txFragments < RH_FRAGMENT_WINDOW ? _txFragments : RH_FRAGMENT_WINDOW;
+    memset(_txBits, 0, sizeof(_txBits));
+    _txActive = true;
+
+    uint8_t stalled = 0;
+    while (_txBase < _txFragments)
+    {
+	// Send what the receiver is missing and has room for. Status reports that arrive meanwhile
+	// move the window along, so on a good link the sender never has to stop
+	uint16_t had = reportedFragments();
+	uint16_t i = _txBase;
+	while ((i = nextMissing(i)) < _txBase + _txCount)
+	{
+	    // Ask for a status report after the last one, and after the first one of the transfer
+	    // so the sender soon learns how many the receiver really has room for
+	    bool poll =    address != RH_BROADCAST_ADDRESS
+			&& (i == 0 || nextMissing(i + 1) >= _txBase + _txCount);
+	    sendFragment(buf, source, context, i++, poll);
+	    if (RHDatagram::available())
+		receive();
+	}
+
+	// Never wait for status reports from broadcasts
+	if (address == RH_BROADCAST_ADDRESS)
+	{
+	    _txBase += _txCount;
+	    _txCount = (_txFragments - _txBase) < RH_FRAGMENT_WINDOW ? (_txFragments - _txBase) : RH_FRAGMENT_WINDOW;
+	    continue;
+	}
+
+	if (!waitStatus())
+	    break; // Receiver gone away
+	if (_txBase >= _txFragments)
+	    break; // Its all there
+	if (_txCount == 0)
+	    break; // Receiver cant take it
+	if (reportedFragments() > had)
+	    stalled = 0;
+	else if (++stalled > _retries)
+	    break;
+	YIELD;
+    }
+    _txActive = false;
+    return _txBase >= _txFragments;
+}
+
+////////////////////////////////////////////////////////////////////
+uint16_t RHFragmentedDatagram::nextMissing(uint16_t index)
+{
+    if (index < _txBase)
+	index = _txBase;
+    while (index < _txBase + _txCount)
+    {
+	uint16_t bit = index - _txBase;
+	if (!(_txBits[bit >> 3] & (1 << (bit & 7))))
+	    break;
+	index++;
+    }
+    return index;
+}
+
+////////////////////////////////////////////////////////////////////
+uint16_t RHFragmentedDatagram::reportedFragments()
+{
+    uint16_t count = _txBase;
+    for (uint8_t i = 0; i < sizeof(_txBits); i++)
+	for (uint8_t bits = _txBits[i]; bits; bits &= bits - 1)
+	    count++;
+    return count;
+}
+
+////////////////////////////////////////////////////////////////////
+void RHFragmentedDatagram::sendFragment(const uint8_t* buf, SourceCallback source, void* context, uint16_t index, bool poll)
+{
+    uint8_t frame[RH_MAX_MESSAGE_LEN];
+    uint16_t offset = index * _txFragSize;
+    uint8_t len = (_txLen - offset) < _txFragSize ? (_txLen - offset) : _txFragSize;
+    frame[0] = RH_FRAGMENT_TYPE_DATA | (poll ? RH_FRAGMENT_TYPE_POLL_FLAG : 0);
+    frame[1] = _txLen;
+    frame[2] = _txLen >> 8;
+    frame[3] = offset;
+    frame[4] = offset >> 8;
+    frame[5] = _txFragSize;
+    if (source)
+	source(context, offset, frame + RH_FRAGMENT_HEADER_LEN, len);
+    else
+	memcpy(frame + RH_FRAGMENT_HEADER_LEN, buf + offset, len);
+
+    if (index < _txSent)
+	_retransmissions++;
+    else
+	_txSent = index + 1;
+    setHeaderId(_txId);
+    setHeaderFlags(RH_FLAGS_NONE, RH_FLAGS_RESERVED);
+    sendto(frame, RH_FRAGMENT_HEADER_LEN + len, _txAddress);
+    waitPacketSent();
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHFragmentedDatagram::waitStatus()
+{
+    uint8_t polls = 0;
+    while (true)
+    {
+	_txStatus = false;
+	unsigned long thisSendTime = millis(); // Timeout does not include transmit time
+	int32_t timeLeft;
+	while ((timeLeft = _timeout - (millis() - thisSendTime)) > 0)
+	{
+	    // Fragments for this node are reassembled while waiting
+	    if (RHDatagram::waitAvailableTimeout(timeLeft))
+	    {
+		receive();
+		if (_txStatus)
+		    return true;
+	    }
+	    YIELD;
+	}
+	if (polls++ >= _retries)
+	    return false;
+
+	// The last fragment or the status report was lost, ask again
+	uint8_t poll[4];
+	poll[0] = RH_FRAGMENT_TYPE_POLL;
+	poll[1] = _txLen;
+	poll[2] = _txLen >> 8;
+	poll[3] = _txFragSize;
+	setHeaderId(_txId);
+	setHeaderFlags(RH_FLAGS_NONE, RH_FLAGS_RESERVED);
+	sendto(poll, sizeof(poll), _txAddress);
+	waitPacketSent();
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+// Receiving
+void RHFragmentedDatagram::receive()
+{
+    uint8_t copy[RH_MAX_MESSAGE_LEN];
+    const uint8_t* buf;
+    uint8_t len, from, to, id;
+    if (!recvfromView(&buf, &len, &from, &to, &id, NULL, copy, sizeof(copy)))
+	return;
+
+    bool data = false;
+    bool reply = false;
+    if (len >= 1 && (to == _thisAddress || to == RH_BROADCAST_ADDRESS))
+    {
+	switch (buf[0] & ~RH_FRAGMENT_TYPE_POLL_FLAG)
+	{
+	case RH_FRAGMENT_TYPE_DATA:
+	    data = true;
+	    reply = receiveData(from, id, buf, len);
+	    break;
+
+	case RH_FRAGMENT_TYPE_POLL:
+	    reply = len >= 4 && receiveTransfer(from, id, buf[1] | (buf[2] << 8), buf[3]);
+	    break;
+
+	case RH_FRAGMENT_TYPE_STATUS:
+	    receiveStatus(from, id, buf, len);
+	    break;
+	}
+    }
+    release();
+
+    // Fragments that are now in order go to the stream callback
+    if (_rxActive && receiveAdvance())
+	reply = true; // Tell the sender it is all here
+    // Never report to broadcasts
+    if (to != _thisAddress || !_rxActive || from != _rxFrom || id != _rxId)
+	return;
+    if (reply)
+	sendStatus(true);
+    else if (data && !_rxComplete && (uint16_t)(_rxBase - _rxReported) * 2 >= receiveWindow())
+	sendStatus(false); // Half the window used since the last report: let the sender move it along
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHFragmentedDatagram::receiveData(uint8_t from, uint8_t id, const uint8_t* buf, uint8_t len)
+{
+    if (len <= RH_FRAGMENT_HEADER_LEN)
+	return false;
+    uint16_t total = buf[1] | (buf[2] << 8);
+    uint16_t offset = buf[3] | (buf[4] << 8);
+    uint8_t fragSize = buf[5];
+    uint8_t dataLen = len - RH_FRAGMENT_HEADER_LEN;
+    // Reject anything that does not make sense
+    if (   !fragSize
+	|| offset >= total
+	|| offset % fragSize
+	|| dataLen != ((total - offset) < fragSize ? (total - offset) : fragSize))
+	return false;
+    if (!receiveTransfer(from, id, total, fragSize))
+	return false;
+
+    uint16_t index = offset / fragSize;
+    uint16_t bit = index - _rxBase;
+    if (   index >= _rxBase
+	&& bit < receiveWindow()
+	&& !(_rxBits[bit >> 3] & (1 << (bit & 7))))
+    {
+	if (_rxBufSize < fragSize && _rxTotal - _rxOrigin > _rxBufSize)
+	{
+	    // No room to keep it, so it was accepted because it is the next one in order.
+	    // Must be delivered now, while the message is still held
+	    _streamCallback(_streamContext, from, offset, buf + RH_FRAGMENT_HEADER_LEN, dataLen, total);
+	    _rxBase++;
+	    _rxOrigin = offset + dataLen;
+	}
+	else
+	{
+	    memcpy(_rxBuf + offset - _rxOrigin, buf + RH_FRAGMENT_HEADER_LEN, dataLen);
+	    _rxBits[bit >> 3] |= 1 << (bit & 7);
+	}
+    }
+    return buf[0] & RH_FRAGMENT_TYPE_POLL_FLAG;
+}
+
+////////////////////////////////////////////////////////////////////
+void RHFragmentedDatagram::receiveStatus(uint8_t from, uint8_t id, const uint8_t* buf, uint8_t len)
+{
+    if (!_txActive || from != _txAddress || id != _txId || len < 4)
+	return;
+    uint16_t base = buf[1] | (buf[2] << 8);
+    if (base < _txBase)
+	return; // Old news
+    _txBase = base;
+    _txCount = buf[3] < RH_FRAGMENT_WINDOW ? buf[3] : RH_FRAGMENT_WINDOW;
+    if (_txCount > _txFragments - base)
+	_txCount = base < _txFragments ? _txFragments - base : 0;
+    memset(_txBits, 0, sizeof(_txBits));
+    uint8_t bytes = len - 4;
+    if (bytes > sizeof(_txBits))
+	bytes = sizeof(_txBits);
+    memcpy(_txBits, buf + 4, bytes);
+    if (buf[0] & RH_FRAGMENT_TYPE_POLL_FLAG)
+	_txStatus = true;
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHFragmentedDatagram::receiveTransfer(uint8_t from, uint8_t id, uint16_t total, uint8_t fragSize)
+{
+    if (!fragSize || !total)
+	return false;
+    // A finished transfer is remembered long enough to answer a sender whose last status report
+    // was lost, but not so long that a sender that restarted its IDs is taken for it
+    if (   _rxActive && from == _rxFrom && id == _rxId
+	&& !(_rxComplete && !_rxReady && (millis() - _rxHeard) >= RH_FRAGMENT_IDLE_TIMEOUT))
+    {
+	if (total != _rxTotal || fragSize != _rxFragSize)
+	    return false;
+	_rxHeard = millis();
+	return true;
+    }
+    // A transfer that was finished but not collected yet would be overwritten.
+    // An unfinished one is replaced only when the same sender gives up on it, or goes quiet
+    if (   _rxReady
+	|| (   _rxActive
+	    && !_rxComplete
+	    && from != _rxFrom
+	    && (millis() - _rxHeard) < RH_FRAGMENT_IDLE_TIMEOUT))
+	return false;
+
+    _rxActive = true;
+    _rxComplete = false;
+    _rxFrom = from;
+    _rxId = id;
+    _rxTotal = total;
+    _rxFragSize = fragSize;
+    _rxFragments = ((uint32_t)total + fragSize - 1) / fragSize;
+    _rxBase = 0;
+    _rxReported = 0;
+    _rxOrigin = 0;
+    _rxHeard = millis();
+    memset(_rxBits, 0, sizeof(_rxBits));
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+uint16_t RHFragmentedDatagram::receiveWindow()
+{
+    uint16_t window = _rxFragments - _rxBase;
+    if (_rxTotal - _rxOrigin > _rxBufSize)
+    {
+	// It does not all fit. Only a stream callback can take it, keeping what fits in the buffer,
+	// or else only the next fragment
+	if (!_streamCallback)
+	    return 0;
+	uint16_t room = _rxBufSize / _rxFragSize;
+	if (room < window)
+	    window = room ? room : 1;
+    }
+    if (window > RH_FRAGMENT_WINDOW)
+	window = RH_FRAGMENT_WINDOW;
+    // The bitmap must fit in the status report
+    uint16_t reportable = (_driver.maxMessageLength() - 4) * 8;
+    if (window > reportable)
+	window = reportable;
+    return window;
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHFragmentedDatagram::receiveAdvance()
+{
+    uint16_t start = _rxBase;
+    while (_rxBase < _rxFragments && (_rxBits[0] & 1))
+    {
+	for (uint8_t i = 0; i < sizeof(_rxBits) - 1; i++)
+	    _rxBits[i] = (_rxBits[i] >> 1) | (_rxBits[i + 1] << 7);
+	_rxBits[sizeof(_rxBits) - 1] >>= 1;
+	_rxBase++;
+    }
+    if (_rxBase != start)
+    {
+	uint16_t from = start * _rxFragSize;
+	uint32_t to = (uint32_t)_rxBase * _rxFragSize;
+	if (to > _rxTotal)
+	    to = _rxTotal;
+	if (_streamCallback)
+	    _streamCallback(_streamContext, _rxFrom, from, _rxBuf + from - _rxOrigin, to - from, _rxTotal);
+	if (_rxTotal > _rxBufSize)
+	{
+	    // Streaming through a smaller buffer: make room for the next ones
+	    memmove(_rxBuf, _rxBuf + (to - _rxOrigin), _rxBufSize - (to - _rxOrigin));
+	    _rxOrigin = to;
+	}
+    }
+    if (_rxBase >= _rxFragments && !_rxComplete)
+    {
+	_rxComplete = true;
+	_rxReady = true;
+	return true;
+    }
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////
+void RHFragmentedDatagram::sendStatus(bool reply)
+{
+    uint8_t status[4 + RH_FRAGMENT_WINDOW / 8];
+    uint16_t window = _rxComplete ? 0 : receiveWindow();
+    uint8_t bytes = (window + 7) / 8;
+    status[0] = RH_FRAGMENT_TYPE_STATUS | (reply ? RH_FRAGMENT_TYPE_POLL_FLAG : 0);
+    status[1] = _rxBase;
+    status[2] = _rxBase >> 8;
+    status[3] = window;
+    memcpy(status + 4, _rxBits, bytes);
+    _rxReported = _rxBase;
+    setHeaderId(_rxId);
+    setHeaderFlags(RH_FLAGS_NONE, RH_FLAGS_RESERVED);
+    sendto(status, 4 + bytes, _rxFrom);
+    waitPacketSent();
+}
@@ -16,12 +16,48 @@ RHGenericDriver::RHGenericDriver()
     _rxBad(0),
     _rxGood(0),
     _txGood(0),
-    _cad_timeout(0)
+    _rxOverflow(0),
+    _rxDropped(0),
+    _statsSince(0),
+    _cad_timeout(0),
+    _eventDriven(false),
+    _eventPending(false),
+    _asyncSend(false),
+    _sendCallback(NULL),
+    _sendContext(NULL),
+    _rxView(false)
+#if RH_ISR_STATS
+    ,
+    _isrBudget(0)
+#endif
 {
+#if RH_DRIVER_STATS
+    memset((void*)&_stats, 0, sizeof(_stats));
+#endif
+#if RH_ISR_STATS
+    isrStats(NULL, true);
+#endif
+#if RH_WAIT_EVENTS && ((RH_PLATFORM == RH_PLATFORM_UNIX) || (RH_PLATFORM == RH_PLATFORM_RASPI))
+    pthread_mutex_init(&_eventMutex, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+ #if defined(__linux__)
+    // Timeouts are not upset by changes to the time of day
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+ #endif
+    pthread_cond_init(&_eventCond, &attr);
+    pthread_condattr_destroy(&attr);
+#endif
 }
 
 bool RHGenericDriver::init()
 {
+#if RH_ISR_STATS && !(RH_PLATFORM == RH_PLATFORM_UNIX) && (defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__))
+    // Start the DWT cycle counter: TRCENA in DEMCR, then CYCCNTENA in DWT_CTRL
+    *(volatile uint32_t*)0xE000EDFC |= 0x01000000;
+    *(volatile uint32_t*)0xE0001000 |= 0x00000001;
+#endif
+    _statsSince = millis();
     return true;
 }
 
@@ -29,7 +65,7 @@ bool RHGenericDriver::init()
 void RHGenericDriver::waitAvailable()
 {
     while (!available())
-	YIELD;
+	waitEvent(0);
 }
 
 // Blocks until a valid message is received or timeout expires
@@ -38,13 +74,14 @@ void RHGenericDriver::waitAvailable()
 bool RHGenericDriver::waitAvailableTimeout(uint16_t timeout)
 {
     unsigned long starttime = millis();
-    while ((millis() - starttime) < timeout)
+    unsigned long elapsed;
+    while ((elapsed = millis() - starttime) < timeout)
     {
         if (available())
 	{
            return true;
 	}
-	YIELD;
+	waitEvent(timeout - elapsed);
     }
     return false;
 }
@@ -52,22 +89,134 @@ bool RHGenericDriver::waitAvailableTimeout(uint16_t timeout)
 bool RHGenericDriver::waitPacketSent()
 {
     while (_mode == RHModeTx)
-	YIELD; // Wait for any previous transmit to finish
+	waitEvent(0); // Wait for any previous transmit to finish
     return true;
 }
 
 bool RHGenericDriver::waitPacketSent(uint16_t timeout)
 {
     unsigned long starttime = millis();
-    while ((millis() - starttime) < timeout)
+    unsigned long elapsed;
+    while ((elapsed = millis() - starttime) < timeout)
     {
         if (_mode != RHModeTx) // Any previous transmit finished?
            return true;
-	YIELD;
+	waitEvent(timeout - elapsed);
     }
     return false;
 }
 
+bool RHGenericDriver::sendAsync(const uint8_t* data, uint8_t len, SendCallback callback, void* context)
+{
+    // send() will wait for any earlier message anyway, so finish it off first
+    sendAsyncFinish();
+    if (!send(data, len))
+	return false;
+    _sendCallback = callback;
+    _sendContext = context;
+    if (!_asyncSend)
+    {
+	// Cant tell when it has finished unless we wait for it, and polled drivers such as
+	// RH_NRF24 only leave RHModeTx (and so can receive again) in waitPacketSent()
+	waitPacketSent();
+	service();
+    }
+    return true;
+}
+
+void RHGenericDriver::sendAsyncFinish()
+{
+    if (_sendCallback)
+    {
+	waitPacketSent();
+	service();
+    }
+}
+
+void RHGenericDriver::service()
+{
+    if (_sendCallback && _mode != RHModeTx)
+    {
+	// Clear it first, in case the callback sends another message
+	SendCallback callback = _sendCallback;
+	_sendCallback = NULL;
+	callback(_sendContext);
+    }
+}
+
+bool RHGenericDriver::recvView(const uint8_t** buf, uint8_t* len, uint8_t* copy, uint8_t copyLen)
+{
+    // No receive buffer that can be lent out, so copy it. With nowhere to copy it, it is discarded
+    if (!recv(copy, &copyLen))
+	return false;
+    *buf = copy;
+    *len = copyLen;
+    return true;
+}
+
+void RHGenericDriver::release()
+{
+    // recvView() copied the message, so nothing is held
+}
+
+void RH_INTERRUPT_ATTR RHGenericDriver::notifyEvent()
+{
+#if RH_WAIT_EVENTS && ((RH_PLATFORM == RH_PLATFORM_UNIX) || (RH_PLATFORM == RH_PLATFORM_RASPI))
+    pthread_mutex_lock(&_eventMutex);
+    _eventPending = true;
+    pthread_cond_broadcast(&_eventCond);
+    pthread_mutex_unlock(&_eventMutex);
+#elif RH_WAIT_EVENTS
+    _eventPending = true;
+    __asm__ volatile ("sev"); // In case the main code is just about to WFE
+#else
+    _eventPending = true;
+#endif
+}
+
+void RHGenericDriver::waitEvent(uint16_t timeout)
+{
+#if RH_WAIT_EVENTS && ((RH_PLATFORM == RH_PLATFORM_UNIX) || (RH_PLATFORM == RH_PLATFORM_RASPI))
+    if (!_eventDriven && (timeout == 0 || timeout > RH_WAIT_POLL_MS))
+	timeout = RH_WAIT_POLL_MS; // Nothing will wake us, so come back to poll
+    pthread_mutex_lock(&_eventMutex);
+    if (!_eventPending)
+    {
+	if (timeout == 0)
+	    pthread_cond_wait(&_eventCond, &_eventMutex);
+	else
+	{
+	    struct timespec until;
+ #if defined(__linux__)
+	    clock_gettime(CLOCK_MONOTONIC, &until);
+ #else
+	    clock_gettime(CLOCK_REALTIME, &until);
+ #endif
+	    until.tv_sec += timeout / 1000;
+	    until.tv_nsec += (long)(timeout % 1000) * 1000000L;
+	    if (until.tv_nsec >= 1000000000L)
+	    {
+		until.tv_sec++;
+		until.tv_nsec -= 1000000000L;
+	    }
+	    pthread_cond_timedwait(&_eventCond, &_eventMutex, &until);
+	}
+    }
+    _eventPending = false;
+    pthread_mutex_unlock(&_eventMutex);
+#elif RH_WAIT_EVENTS
+    (void)timeout; // Woken by any interrupt, including the SysTick that runs millis()
+    // If notifyEvent() is called between the test and WFE, its SEV makes WFE return at once
+    if (!_eventPending)
+	__asm__ volatile ("wfe");
+    _eventPending = false;
+    YIELD;
+#else
+    (void)timeout;
+    YIELD;
+#endif
+}
+
 // Wait until no channel activity detected or timeout
 bool RHGenericDriver::waitCAD()
 {
@@ -206,6 +355,209 @@ uint16_t RHGenericDriver::txGood()
     return _txGood;
 }
 
+bool RHGenericDriver::stats(Stats* stats, bool reset)
+{
+    ATOMIC_BLOCK_START;
+    if (stats)
+    {
+#if RH_DRIVER_STATS
+	memcpy(stats, (const void*)&_stats, sizeof(*stats));
+#else
+	memset(stats, 0, sizeof(*stats));
+#endif
+	stats->elapsed = millis() - _statsSince;
+	stats->rxGood = _rxGood;
+	stats->rxBad = _rxBad;
+	stats->txGood = _txGood;
+	stats->rxOverflow = _rxOverflow;
+	stats->rxDropped = _rxDropped;
+    }
+    if (reset)
+    {
+	_rxGood = 0;
+	_rxBad = 0;
+	_txGood = 0;
+	_rxOverflow = 0;
+	_rxDropped = 0;
+	_statsSince = millis();
+#if RH_DRIVER_STATS
+	memset((void*)&_stats, 0, sizeof(_stats));
+#endif
+    }
+    ATOMIC_BLOCK_END;
+#if RH_DRIVER_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint32_t RH_INTERRUPT_ATTR RHGenericDriver::statsClock()
+{
+#if RH_DRIVER_STATS
+    return micros();
+#else
+    return 0;
+#endif
+}
+
+void RHGenericDriver::statsTxStart()
+{
+#if RH_DRIVER_STATS
+    _statsTxStart = statsClock();
+#endif
+}
+
+void RH_INTERRUPT_ATTR RHGenericDriver::statsTxDone()
+{
+#if RH_DRIVER_STATS
+    statsTxDone(_statsTxStart, statsClock() - _statsTxStart);
+#endif
+}
+
+// Bucket n is for times less than 64 << n us
+static uint8_t RH_INTERRUPT_ATTR statsBucket(uint32_t us)
+{
+    uint8_t bucket = 0;
+    for (uint32_t limit = 64; bucket < RH_DRIVER_STATS_BUCKETS - 1 && us >= limit; limit <<= 1)
+	bucket++;
+    return bucket;
+}
+
+void RH_INTERRUPT_ATTR RHGenericDriver::statsTxDone(uint32_t sendTime, uint32_t airtime)
+{
+#if RH_DRIVER_STATS
+    uint32_t latency = statsClock() - sendTime;
+    _stats.txAirtime += airtime;
+    if (latency > _stats.txLatencyMax)
+	_stats.txLatencyMax = latency;
+    _stats.txLatency[statsBucket(latency)]++;
+#else
+    (void)sendTime;
+    (void)airtime;
+#endif
+}
+
+void RH_INTERRUPT_ATTR RHGenericDriver::statsRxDone()
+{
+#if RH_DRIVER_STATS
+    _statsRxDone = statsClock();
+#endif
+}
+
+void RH_INTERRUPT_ATTR RHGenericDriver::statsRxAirtime(uint32_t airtime)
+{
+#if RH_DRIVER_STATS
+    _stats.rxAirtime += airtime;
+#else
+    (void)airtime;
+#endif
+}
+
+void RHGenericDriver::statsRecv()
+{
+#if RH_DRIVER_STATS
+    statsRecv(_statsRxDone);
+#endif
+}
+
+void RHGenericDriver::statsRecv(uint32_t rxDoneTime)
+{
+#if RH_DRIVER_STATS
+    uint32_t latency = statsClock() - rxDoneTime;
+    ATOMIC_BLOCK_START;
+    if (latency > _stats.rxLatencyMax)
+	_stats.rxLatencyMax = latency;
+    _stats.rxLatency[statsBucket(latency)]++;
+    ATOMIC_BLOCK_END;
+#else
+    (void)rxDoneTime;
+#endif
+}
+
+bool RHGenericDriver::isrStats(IsrStats* stats, bool reset)
+{
+#if RH_ISR_STATS
+    ATOMIC_BLOCK_START;
+    if (stats)
+    {
+	stats->count = _isrStats.count;
+	stats->min = _isrStats.count ? _isrStats.min : 0;
+	stats->max = _isrStats.max;
+	stats->mean = _isrStats.count ? _isrTotal / _isrStats.count : 0;
+	stats->overruns = _isrStats.overruns;
+	for (uint8_t i = 0; i < RH_ISR_STATS_BUCKETS; i++)
+	    stats->histogram[i] = _isrStats.histogram[i];
+    }
+    if (reset)
+    {
+	_isrStats.count = 0;
+	_isrStats.min = 0xffffffff;
+	_isrStats.max = 0;
+	_isrStats.overruns = 0;
+	for (uint8_t i = 0; i < RH_ISR_STATS_BUCKETS; i++)
+	    _isrStats.histogram[i] = 0;
+	_isrTotal = 0;
+    }
+    ATOMIC_BLOCK_END;
+    return true;
+#else
+    (void)reset;
+    if (stats)
+	memset(stats, 0, sizeof(*stats));
+    return false;
+#endif
+}
+
+void RHGenericDriver::setIsrBudget(uint32_t clocks)
+{
+#if RH_ISR_STATS
+    _isrBudget = clocks;
+#else
+    (void)clocks;
+#endif
+}
+
+uint32_t RH_INTERRUPT_ATTR RHGenericDriver::isrClock()
+{
+#if !RH_ISR_STATS
+    return 0;
+#elif (RH_PLATFORM == RH_PLATFORM_UNIX)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)now.tv_sec * 1000000000UL + now.tv_nsec;
+#elif defined(__AVR__)
+    return (uint32_t)TCNT0 * 64;
+#elif defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+    return *(volatile uint32_t*)0xE0001004; // DWT_CYCCNT
+#else
+    return micros();
+#endif
+}
+
+void RH_INTERRUPT_ATTR RHGenericDriver::isrStatsRecord(uint32_t start)
+{
+#if RH_ISR_STATS
+    uint32_t clocks = (isrClock() - start) & RH_ISR_CLOCK_MASK;
+    _isrStats.count++;
+    _isrTotal += clocks;
+    if (clocks < _isrStats.min)
+	_isrStats.min = clocks;
+    if (clocks > _isrStats.max)
+	_isrStats.max = clocks;
+    if (_isrBudget && clocks > _isrBudget)
+	_isrStats.overruns++;
+
+    // Bucket n is for times less than 64 << n
+    uint8_t bucket = 0;
+    for (uint32_t limit = 64; bucket < RH_ISR_STATS_BUCKETS - 1 && clocks >= limit; limit <<= 1)
+	bucket++;
+    _isrStats.histogram[bucket]++;
+#else
+    (void)start;
+#endif
+}
+
 void RHGenericDriver::setCADTimeout(unsigned long cad_timeout)
 {
     _cad_timeout = cad_timeout;
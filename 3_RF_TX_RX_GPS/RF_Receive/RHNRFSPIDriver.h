@@ -77,6 +77,15 @@ public:
     ///  it may or may not be meaningfule depending on the the type of device being accessed.
     uint8_t           spiBurstWrite(uint8_t reg, const uint8_t* src, uint8_t len);
 
+    /// Write a header followed by data in a single burst write, without assembling them in a buffer first
+    /// \param[in] reg Register number of the first register
+    /// \param[in] header Array of values to write first. Must be at least headerLen bytes
+    /// \param[in] headerLen Number of header bytes to write
+    /// \param[in] src Array of values to write after the header. Must be at least len bytes
+    /// \param[in] len Number of bytes to write from src
+    /// \return The status byte returned during the first data transfer.
+    uint8_t           spiBurstWrite(uint8_t reg, const uint8_t* header, uint8_t headerLen, const uint8_t* src, uint8_t len);
+
     /// Set or change the pin to be used for SPI slave select.
     /// This can be called at any time to change the
     /// pin that will be used for slave select in subsquent SPI operations.
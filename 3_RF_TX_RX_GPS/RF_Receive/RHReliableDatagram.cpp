@@ -22,7 +22,30 @@ RHReliableDatagram::RHReliableDatagram(RHGenericDriver& driver, uint8_t thisAddr
     _lastSequenceNumber = 0;
     _timeout = RH_DEFAULT_TIMEOUT;
     _retries = RH_DEFAULT_RETRIES;
-    memset(_seenIds, 0, sizeof(_seenIds));
+    _adaptiveTimeout = true;
+#if RH_RELIABLE_RTT_PEERS
+    for (uint8_t i = 0; i < RH_RELIABLE_RTT_PEERS; i++)
+	_rttPeers[i].address = RH_BROADCAST_ADDRESS;
+    _rttPeerNext = 0;
+#endif
+    for (uint8_t i = 0; i < RH_RELIABLE_SEEN_PEERS; i++)
+	_seenPeers[i].address = RH_BROADCAST_ADDRESS;
+    _seenClock = 0;
+    _window = 1;
+    _windowGap = 0;
+    _windowFailed = false;
+#if RH_RELIABLE_WINDOW
+    for (uint8_t i = 0; i < RH_RELIABLE_WINDOW; i++)
+	_windowSlots[i].address = RH_BROADCAST_ADDRESS;
+    memset(_windowNodes, 0, sizeof(_windowNodes));
+    _windowGapSlot = NULL;
+    _windowGapStart = 0;
+#endif
+#if RH_RELIABLE_RECV_QUEUE
+    _recvQueueHead = 0;
+    _recvQueueLen = 0;
+    _recvQueueView = false;
+#endif
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -32,6 +55,62 @@ void RHReliableDatagram::setTimeout(uint16_t timeout)
     _timeout = timeout;
 }
 
+////////////////////////////////////////////////////////////////////
+void RHReliableDatagram::setAdaptiveTimeout(bool adaptive)
+{
+    _adaptiveTimeout = adaptive;
+}
+
+////////////////////////////////////////////////////////////////////
+uint16_t RHReliableDatagram::rtt(uint8_t address)
+{
+#if RH_RELIABLE_RTT_PEERS
+    RttPeer* peer = rttPeer(address, false);
+    if (peer)
+	return peer->srtt >> 3;
+#else
+    (void)address;
+#endif
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////
+uint16_t RHReliableDatagram::rttVariation(uint8_t address)
+{
+#if RH_RELIABLE_RTT_PEERS
+    RttPeer* peer = rttPeer(address, false);
+    if (peer)
+	return peer->rttvar >> 2;
+#else
+    (void)address;
+#endif
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////
+uint16_t RHReliableDatagram::retransmitTimeout(uint8_t address)
+{
+#if RH_RELIABLE_RTT_PEERS
+    RttPeer* peer;
+    if (_adaptiveTimeout && (peer = rttPeer(address, false)))
+    {
+	uint32_t timeout = _timeout; // Not measured yet
+	if (peer->srtt)
+	{
+	    // srtt + 4 * rttvar, as in RFC 6298
+	    timeout = (peer->srtt >> 3) + peer->rttvar;
+	    if (timeout < RH_RELIABLE_MIN_TIMEOUT)
+		timeout = RH_RELIABLE_MIN_TIMEOUT;
+	}
+	timeout <<= peer->backoff;
+	return timeout > RH_RELIABLE_MAX_TIMEOUT ? RH_RELIABLE_MAX_TIMEOUT : timeout;
+    }
+#else
+    (void)address;
+#endif
+    return _timeout;
+}
+
 ////////////////////////////////////////////////////////////////////
 void RHReliableDatagram::setRetries(uint8_t retries)
 {
@@ -79,88 +158,488 @@ bool RHReliableDatagram::sendtoWait(uint8_t* buf, uint8_t len, uint8_t address)
 	if (retries > 1)
 	    _retransmissions++;
 	unsigned long thisSendTime = millis(); // Timeout does not include original transmit time
-
-	// Compute a new timeout, random between _timeout and _timeout*2
-	// This is to prevent collisions on every retransmit
-	// if 2 nodes try to transmit at the same time
-#if (RH_PLATFORM == RH_PLATFORM_RASPI) // use standard library random(), bugs in random(min, max)
-	uint16_t timeout = _timeout + (_timeout * (random() & 0xFF) / 256);
-#else
-	uint16_t timeout = _timeout + (_timeout * random(0, 256) / 256);
-#endif
+	uint16_t timeout = ackTimeout(address);
 	int32_t timeLeft;
         while ((timeLeft = timeout - (millis() - thisSendTime)) > 0)
 	{
-	    if (waitAvailableTimeout(timeLeft))
+	    // Other messages are acknowledged and queued for the application if there is room
+	    if (   RHDatagram::waitAvailableTimeout(timeLeft)
+		&& receiveWhileSending(address, thisSequenceNumber))
 	    {
-		uint8_t from, to, id, flags;
-		if (recvfrom(0, 0, &from, &to, &id, &flags)) // Discards the message
-		{
-		    // Now have a message: is it our ACK?
-		    if (   from == address 
-			   && to == _thisAddress 
-			   && (flags & RH_FLAGS_ACK) 
-			   && (id == thisSequenceNumber))
-		    {
-			// Its the ACK we are waiting for
-			return true;
-		    }
-		    else if (   !(flags & RH_FLAGS_ACK)
-				&& (id == _seenIds[from]))
-		    {
-			// This is a request we have already received. ACK it again
-			acknowledge(id, from);
-		    }
-		    // Else discard it
-		}
+		// Its the ACK we are waiting for
+		if (retries == 1)
+		    rttSample(address, millis() - thisSendTime); // Karn: only if unambiguous
+		return true;
 	    }
 	    // Not the one we are waiting for, maybe keep waiting until timeout exhausted
 	    YIELD;
 	}
 	// Timeout exhausted, maybe retry
+	rttTimedOut(address, retries);
 	YIELD;
     }
     // Retries exhausted
     return false;
 }
 
+////////////////////////////////////////////////////////////////////
+void RHReliableDatagram::setWindow(uint8_t window)
+{
+#if RH_RELIABLE_WINDOW
+    if (window > RH_RELIABLE_WINDOW)
+	window = RH_RELIABLE_WINDOW;
+    if (window > RH_RELIABLE_WINDOW_ACK_BITS + 1)
+	window = RH_RELIABLE_WINDOW_ACK_BITS + 1;
+#endif
+    _window = window ? window : 1;
+}
+
+////////////////////////////////////////////////////////////////////
+uint8_t RHReliableDatagram::window()
+{
+    return _window;
+}
+
+////////////////////////////////////////////////////////////////////
+void RHReliableDatagram::setWindowGap(uint16_t gap)
+{
+    _windowGap = gap;
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHReliableDatagram::sendtoWindow(uint8_t* buf, uint8_t len, uint8_t address)
+{
+#if RH_RELIABLE_WINDOW
+    if (address == RH_BROADCAST_ADDRESS)
+	return sendtoWait(buf, len, address);
+#if RH_RELIABLE_WINDOW_MESSAGE_LEN < 255
+    if (len > RH_RELIABLE_WINDOW_MESSAGE_LEN)
+	return false;
+#endif
+
+    // Collect any ACKs before the driver has to drop them to receive more
+    windowService(0);
+    WindowSlot* slot = NULL;
+    while (true)
+    {
+	if (windowInFlight(address) < windowFor(address))
+	{
+	    for (uint8_t i = 0; i < RH_RELIABLE_WINDOW; i++)
+		if (_windowSlots[i].address == RH_BROADCAST_ADDRESS)
+		    slot = &_windowSlots[i];
+	    if (slot)
+		break;
+	}
+	windowService(0xffff); // Window full, wait for ACKs
+    }
+    slot->address = address;
+    slot->id = ++_lastSequenceNumber;
+    slot->tries = 0;
+    slot->len = len;
+    slot->callback = NULL;
+    memcpy(slot->buf, buf, len);
+    windowTransmit(slot);
+
+    // Give the receiver a chance to ACK before anything else is sent
+    unsigned long start = millis();
+    int32_t timeLeft;
+    while (   slot->address != RH_BROADCAST_ADDRESS
+	   && (timeLeft = _windowGap - (millis() - start)) > 0)
+	windowService(timeLeft, false);
+    return true;
+#else
+    bool ret = sendtoWait(buf, len, address);
+    if (!ret)
+	_windowFailed = true;
+    return ret;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHReliableDatagram::sendtoQueue(uint8_t* buf, uint8_t len, uint8_t address, AckCallback callback, void* context)
+{
+#if RH_RELIABLE_WINDOW
+    if (address == RH_BROADCAST_ADDRESS)
+    {
+	// Never acknowledged, so there is nothing to wait for
+	if (!sendto(buf, len, address))
+	    return false;
+	if (callback)
+	    callback(context, true);
+	return true;
+    }
+#if RH_RELIABLE_WINDOW_MESSAGE_LEN < 255
+    if (len > RH_RELIABLE_WINDOW_MESSAGE_LEN)
+	return false;
+#endif
+    WindowSlot* slot = NULL;
+    for (uint8_t i = 0; i < RH_RELIABLE_WINDOW; i++)
+	if (_windowSlots[i].address == RH_BROADCAST_ADDRESS)
+	    slot = &_windowSlots[i];
+    if (!slot)
+	return false; // Queue full
+    slot->address = address;
+    slot->id = ++_lastSequenceNumber;
+    slot->tries = 0; // Not transmitted yet
+    slot->len = len;
+    slot->callback = callback;
+    slot->context = context;
+    memcpy(slot->buf, buf, len);
+    windowStart(); // Now, if its destination's window has room
+    return true;
+#else
+    bool ret = sendtoWait(buf, len, address);
+    if (!ret)
+	_windowFailed = true;
+    if (callback)
+	callback(context, ret);
+    return true;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////
+void RHReliableDatagram::service()
+{
+    RHDatagram::service();
+#if RH_RELIABLE_WINDOW
+    windowService(0);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHReliableDatagram::waitWindow()
+{
+#if RH_RELIABLE_WINDOW
+    while (windowPending())
+	windowService(0xffff);
+#endif
+    bool ret = !_windowFailed;
+    _windowFailed = false;
+    return ret;
+}
+
+////////////////////////////////////////////////////////////////////
+uint8_t RHReliableDatagram::windowPending()
+{
+    uint8_t count = 0;
+#if RH_RELIABLE_WINDOW
+    for (uint8_t i = 0; i < RH_RELIABLE_WINDOW; i++)
+	if (_windowSlots[i].address != RH_BROADCAST_ADDRESS)
+	    count++;
+#endif
+    return count;
+}
+
+#if RH_RELIABLE_WINDOW
+////////////////////////////////////////////////////////////////////
+uint8_t RHReliableDatagram::windowFor(uint8_t address)
+{
+    // Nodes that have not sent a window ACK get one message at a time
+    return (_windowNodes[address >> 3] & (1 << (address & 7))) ? _window : 1;
+}
+
+////////////////////////////////////////////////////////////////////
+uint8_t RHReliableDatagram::windowInFlight(uint8_t address)
+{
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < RH_RELIABLE_WINDOW; i++)
+	if (_windowSlots[i].address == address && _windowSlots[i].tries)
+	    count++;
+    return count;
+}
+
+////////////////////////////////////////////////////////////////////
+RHReliableDatagram::WindowSlot* RHReliableDatagram::windowNext()
+{
+    WindowSlot* next = NULL;
+    for (uint8_t i = 0; i < RH_RELIABLE_WINDOW; i++)
+    {
+	WindowSlot* slot = &_windowSlots[i];
+	if (slot->address == RH_BROADCAST_ADDRESS || slot->tries)
+	    continue;
+	// Oldest first, so messages to each destination go in order
+	if (next && (uint8_t)(_lastSequenceNumber - slot->id) < (uint8_t)(_lastSequenceNumber - next->id))
+	    continue;
+	if (windowInFlight(slot->address) < windowFor(slot->address))
+	    next = slot;
+    }
+    return next;
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHReliableDatagram::windowGapping()
+{
+    return    _windowGapSlot
+	   && _windowGapSlot->address != RH_BROADCAST_ADDRESS
+	   && _windowGapSlot->tries == 1
+	   && (millis() - _windowGapStart) < _windowGap;
+}
+
+////////////////////////////////////////////////////////////////////
+void RHReliableDatagram::windowTransmit(WindowSlot* slot)
+{
+    setHeaderId(slot->id);
+    // Same flags as sendtoWait()
+    if (slot->tries++ == 0)
+    {
+	setHeaderFlags(RH_FLAGS_NONE, RH_FLAGS_ACK | RH_FLAGS_RETRY);
+	_windowGapSlot = slot;
+    }
+    else
+    {
+	setHeaderFlags(RH_FLAGS_RETRY, RH_FLAGS_ACK);
+	_retransmissions++;
+    }
+    sendto(slot->buf, slot->len, slot->address);
+    waitPacketSent();
+    slot->sentAt = millis(); // Timeout does not include transmit time
+    slot->timeout = ackTimeout(slot->address);
+    if (slot == _windowGapSlot)
+	_windowGapStart = slot->sentAt;
+}
+
+////////////////////////////////////////////////////////////////////
+void RHReliableDatagram::windowDone(WindowSlot* slot, bool acked)
+{
+    AckCallback callback = slot->callback;
+    slot->address = RH_BROADCAST_ADDRESS; // Free for the callback to reuse
+    if (!acked)
+	_windowFailed = true;
+    if (callback)
+	callback(slot->context, acked);
+}
+
+////////////////////////////////////////////////////////////////////
+void RHReliableDatagram::windowService(uint16_t wait, bool retransmit)
+{
+    if (wait)
+    {
+	// Wait for a message, or until the next ACK timer or window gap runs out
+	unsigned long now = millis();
+	int32_t timeLeft = wait;
+	for (uint8_t i = 0; retransmit && i < RH_RELIABLE_WINDOW; i++)
+	{
+	    WindowSlot* slot = &_windowSlots[i];
+	    if (slot->address == RH_BROADCAST_ADDRESS || !slot->tries)
+		continue;
+	    int32_t left = slot->timeout - (int32_t)(now - slot->sentAt);
+	    if (left < timeLeft)
+		timeLeft = left;
+	}
+	if (retransmit && windowGapping())
+	{
+	    int32_t left = _windowGap - (int32_t)(now - _windowGapStart);
+	    if (left < timeLeft)
+		timeLeft = left;
+	}
+	if (timeLeft > 0)
+	    RHDatagram::waitAvailableTimeout(timeLeft);
+    }
+
+    // Look for ACKs. Other messages are acknowledged and queued for the application if there is room
+    while (RHDatagram::available())
+	receiveWhileSending(RH_BROADCAST_ADDRESS, 0);
+    if (!retransmit)
+	return;
+
+    // Retransmit or give up on the messages whose ACK timers have run out
+    for (uint8_t i = 0; i < RH_RELIABLE_WINDOW; i++)
+    {
+	WindowSlot* slot = &_windowSlots[i];
+	if (   slot->address == RH_BROADCAST_ADDRESS
+	    || !slot->tries
+	    || (int32_t)(millis() - slot->sentAt) < slot->timeout)
+	    continue;
+	rttTimedOut(slot->address, slot->tries);
+	if (slot->tries > _retries)
+	    windowDone(slot, false); // Retries exhausted
+	else
+	    windowTransmit(slot);
+    }
+
+    windowStart();
+}
+
+////////////////////////////////////////////////////////////////////
+void RHReliableDatagram::windowStart()
+{
+    // Start the queued messages that fit in their destination's window
+    WindowSlot* slot;
+    while (!windowGapping() && (slot = windowNext()))
+	windowTransmit(slot);
+}
+
+////////////////////////////////////////////////////////////////////
+void RHReliableDatagram::windowAcked(uint8_t from, uint8_t id, const uint8_t* payload, uint8_t len)
+{
+    uint8_t bitmap = 0;
+    if (len >= 2)
+    {
+	// A window ACK: the node recognises retries of earlier messages, and acknowledges them here too
+	_windowNodes[from >> 3] |= 1 << (from & 7);
+	bitmap = payload[1];
+    }
+    for (uint8_t i = 0; i < RH_RELIABLE_WINDOW; i++)
+    {
+	WindowSlot* slot = &_windowSlots[i];
+	if (slot->address != from || !slot->tries)
+	    continue;
+	uint8_t back = id - slot->id;
+	if (back == 0 && slot->tries == 1)
+	    rttSample(from, millis() - slot->sentAt); // Karn: only if unambiguous
+	if (   back == 0
+	    || (back <= RH_RELIABLE_WINDOW_ACK_BITS && (bitmap & (1 << (back - 1)))))
+	    windowDone(slot, true);
+    }
+}
+#endif
+
+////////////////////////////////////////////////////////////////////
+RHReliableDatagram::SeenPeer* RHReliableDatagram::seenPeer(uint8_t address, bool create)
+{
+    // Open addressing: entries are replaced but never removed, so a node is either
+    // before the first unused entry in its probe sequence, or not in the table
+    uint8_t i = (uint8_t)(address * 0x9d) % RH_RELIABLE_SEEN_PEERS; // Odd multiplier: spreads consecutive addresses
+    SeenPeer* oldest = NULL;
+    for (uint8_t n = 0; n < RH_RELIABLE_SEEN_PEERS; n++)
+    {
+	SeenPeer* peer = &_seenPeers[i];
+	if (peer->address == address)
+	{
+	    if (create)
+		peer->used = ++_seenClock; // Heard from again
+	    return peer;
+	}
+	if (peer->address == RH_BROADCAST_ADDRESS)
+	{
+	    oldest = peer; // Unused
+	    break;
+	}
+	if (!oldest || (uint16_t)(_seenClock - peer->used) > (uint16_t)(_seenClock - oldest->used))
+	    oldest = peer;
+	if (++i >= RH_RELIABLE_SEEN_PEERS)
+	    i = 0;
+    }
+    if (!create)
+	return NULL;
+    // The table is full: replace the least recently used
+    oldest->address = address;
+    oldest->used = ++_seenClock;
+    oldest->id = 0;
+    oldest->seen = 0;
+    return oldest;
+}
+
+////////////////////////////////////////////////////////////////////
+void RHReliableDatagram::recordSeen(uint8_t from, uint8_t id)
+{
+    SeenPeer* peer = seenPeer(from, true);
+    if (!peer->seen)
+    {
+	// First from this node
+	peer->id = id;
+	peer->seen = 1;
+	return;
+    }
+    uint8_t ahead = id - peer->id;
+    uint8_t behind = peer->id - id;
+    if (ahead && ahead < 128)
+    {
+	// Newer than any so far
+	peer->seen = (ahead < 32) ? (peer->seen << ahead) | 1 : 1;
+	peer->id = id;
+    }
+    else if (behind < 32)
+	peer->seen |= 1UL << behind;
+    else
+    {
+	// Long ago, or the node has restarted
+	peer->id = id;
+	peer->seen = 1;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+bool RHReliableDatagram::wasSeen(uint8_t from, uint8_t id)
+{
+    SeenPeer* peer = seenPeer(from, false);
+    if (!peer)
+	return false;
+    uint8_t behind = peer->id - id;
+    return behind < 32 && (peer->seen & (1UL << behind));
+}
+
 ////////////////////////////////////////////////////////////////////
 bool RHReliableDatagram::recvfromAck(uint8_t* buf, uint8_t* len, uint8_t* from, uint8_t* to, uint8_t* id, uint8_t* flags)
 {  
+    const uint8_t* message;
+    uint8_t messageLen;
+    // Drivers that cannot lend out their buffer copy the message straight into buf
+    if (!recvfromAckView(&message, &messageLen, from, to, id, flags, buf, len ? *len : 0))
+	return false;
+    if (buf && len)
+    {
+	if (*len > messageLen)
+	    *len = messageLen;
+	if (message != buf)
+	    memcpy(buf, message, *len);
+    }
+    release();
+    return true;
+}
+
+bool RHReliableDatagram::recvfromAckView(const uint8_t** buf, uint8_t* len, uint8_t* from, uint8_t* to, uint8_t* id, uint8_t* flags,
+					 uint8_t* copy, uint8_t copyLen)
+{  
+#if RH_RELIABLE_RECV_QUEUE
+    if (_recvQueueLen)
+    {
+	// Received while sending, and already acknowledged. Held until release()
+	QueuedMessage* message = &_recvQueue[_recvQueueHead];
+	*buf = message->buf;
+	*len = message->len;
+	if (from)  *from =  message->from;
+	if (to)    *to =    message->to;
+	if (id)    *id =    message->id;
+	if (flags) *flags = message->flags;
+	_recvQueueView = true;
+	return true;
+    }
+#endif
     uint8_t _from;
     uint8_t _to;
     uint8_t _id;
     uint8_t _flags;
-    // Get the message before its clobbered by the ACK (shared rx and tx buffer in some drivers
-    if (available() && recvfrom(buf, len, &_from, &_to, &_id, &_flags))
+    // The message is not clobbered by the ACK: drivers that lend out their receive buffer
+    // never transmit from it, and the others have copied it already
+    if (RHDatagram::available() && recvfromView(buf, len, &_from, &_to, &_id, &_flags, copy, copyLen))
     {
 	// Never ACK an ACK
 	if (!(_flags & RH_FLAGS_ACK))
 	{
 	    // Its a normal message not an ACK
-	    if (_to ==_thisAddress)
-	    {
-	        // Its for this node and
-		// Its not a broadcast, so ACK it
-		// Acknowledge message with ACK set in flags and ID set to received ID
-		acknowledge(_id, _from);
-	    }
-            // Filter out retried messages that we have seen before. This explicitly
-            // only filters out messages that are marked as retries to protect against
-            // the scenario where a transmitting device sends just one message and
-            // shuts down between transmissions. Devices that do this will report the
-            // the same ID each time since their internal sequence number will reset
-            // to zero each time the device starts up.
-	    if ((RH_ENABLE_EXPLICIT_RETRY_DEDUP && !(_flags & RH_FLAGS_RETRY)) || _id != _seenIds[_from])
+	    if (acceptMessage(_from, _to, _id, _flags, true))
 	    {
 		if (from)  *from =  _from;
 		if (to)    *to =    _to;
 		if (id)    *id =    _id;
 		if (flags) *flags = _flags;
-		_seenIds[_from] = _id;
-		return true;
+		return true; // Held until release()
 	    }
 	    // Else just re-ack it and wait for a new one
+	    release();
+	}
+	else
+	{
+	    // Maybe for a message sent by sendtoWindow() or sendtoQueue()
+	    uint8_t ack[2];
+	    uint8_t ackLen = *len < sizeof(ack) ? *len : sizeof(ack);
+	    memcpy(ack, *buf, ackLen);
+	    release(); // Before any callbacks
+#if RH_RELIABLE_WINDOW
+	    if (_to == _thisAddress)
+		windowAcked(_from, _id, ack, ackLen);
+#endif
 	}
     }
     // No message for us available
@@ -183,6 +662,236 @@ bool RHReliableDatagram::recvfromAckTimeout(uint8_t* buf, uint8_t* len, uint16_t
     return false;
 }
 
+void RHReliableDatagram::release()
+{
+#if RH_RELIABLE_RECV_QUEUE
+    if (_recvQueueView)
+    {
+	_recvQueueView = false;
+	if (++_recvQueueHead >= RH_RELIABLE_RECV_QUEUE)
+	    _recvQueueHead = 0;
+	_recvQueueLen--;
+	return;
+    }
+#endif
+    RHDatagram::release();
+}
+
+bool RHReliableDatagram::available()
+{
+#if RH_RELIABLE_RECV_QUEUE
+    if (_recvQueueLen)
+	return true;
+#endif
+    return RHDatagram::available();
+}
+
+void RHReliableDatagram::waitAvailable()
+{
+#if RH_RELIABLE_RECV_QUEUE
+    if (_recvQueueLen)
+	return;
+#endif
+    RHDatagram::waitAvailable();
+}
+
+bool RHReliableDatagram::waitAvailableTimeout(uint16_t timeout)
+{
+#if RH_RELIABLE_RECV_QUEUE
+    if (_recvQueueLen)
+	return true;
+#endif
+    return RHDatagram::waitAvailableTimeout(timeout);
+}
+
+bool RHReliableDatagram::acceptMessage(uint8_t from, uint8_t to, uint8_t id, uint8_t flags, bool room)
+{
+    // A retry of a message already received, maybe not the latest from the node (sent by sendtoWindow())
+    bool retried = (flags & RH_FLAGS_RETRY) && wasSeen(from, id);
+    // Filter out retried messages that we have seen before. This explicitly
+    // only filters out messages that are marked as retries to protect against
+    // the scenario where a transmitting device sends just one message and
+    // shuts down between transmissions. Devices that do this will report the
+    // the same ID each time since their internal sequence number will reset
+    // to zero each time the device starts up.
+    SeenPeer* peer = seenPeer(from, false);
+    bool latest = peer && id == peer->id;
+    bool isNew = !retried && ((RH_ENABLE_EXPLICIT_RETRY_DEDUP && !(flags & RH_FLAGS_RETRY)) || !latest);
+    if (isNew && !room)
+	return false; // Not acknowledged, so the sender will retransmit it
+    recordSeen(from, id);
+    if (to == _thisAddress)
+    {
+	// Its for this node and
+	// Its not a broadcast, so ACK it
+	// Acknowledge message with ACK set in flags and ID set to received ID
+	acknowledge(id, from);
+    }
+    return isNew;
+}
+
+bool RHReliableDatagram::receiveWhileSending(uint8_t address, uint8_t id)
+{
+    const uint8_t* payload;
+    uint8_t len;
+    uint8_t from, to, rxId, flags;
+    uint8_t ack[2]; // The ACK octets, if the driver cannot lend out its buffer
+    uint8_t* copy = ack;
+    uint8_t copyLen = sizeof(ack);
+#if RH_RELIABLE_RECV_QUEUE
+    QueuedMessage* queued = NULL;
+    if (_recvQueueLen < RH_RELIABLE_RECV_QUEUE)
+    {
+	// Receive straight into the queue, in case it is a message for the application
+	uint8_t tail = _recvQueueHead + _recvQueueLen;
+	queued = &_recvQueue[tail >= RH_RELIABLE_RECV_QUEUE ? tail - RH_RELIABLE_RECV_QUEUE : tail];
+	copy = queued->buf;
+	copyLen = sizeof(queued->buf);
+    }
+#endif
+    if (!recvfromView(&payload, &len, &from, &to, &rxId, &flags, copy, copyLen))
+	return false;
+
+    if (flags & RH_FLAGS_ACK)
+    {
+	uint8_t ackLen = len < sizeof(ack) ? len : sizeof(ack);
+	memmove(ack, payload, ackLen);
+	RHDatagram::release(); // Before any callbacks
+	if (to != _thisAddress)
+	    return false;
+#if RH_RELIABLE_WINDOW
+	windowAcked(from, rxId, ack, ackLen);
+#endif
+	return from == address && rxId == id;
+    }
+
+    bool room = false;
+#if RH_RELIABLE_RECV_QUEUE
+    room = queued != NULL;
+#endif
+    if (acceptMessage(from, to, rxId, flags, room))
+    {
+#if RH_RELIABLE_RECV_QUEUE
+	// Keep it for recvfromAck()
+#if RH_RELIABLE_WINDOW_MESSAGE_LEN < 255
+	if (len > sizeof(queued->buf))
+	    len = sizeof(queued->buf);
+#endif
+	if (payload != queued->buf)
+	    memcpy(queued->buf, payload, len);
+	queued->len = len;
+	queued->from = from;
+	queued->to = to;
+	queued->id = rxId;
+	queued->flags = flags;
+	_recvQueueLen++;
+#endif
+    }
+    RHDatagram::release();
+    return false;
+}
+
+uint16_t RHReliableDatagram::ackTimeout(uint8_t address)
+{
+    uint16_t timeout = retransmitTimeout(address);
+    // Randomly lengthen the timeout, to prevent collisions on every retransmit
+    // if 2 nodes try to transmit at the same time: a fixed timeout is random between
+    // timeout and timeout*2, a measured one needs less
+    uint8_t shift = 0;
+#if RH_RELIABLE_RTT_PEERS
+    RttPeer* peer;
+    if (_adaptiveTimeout && (peer = rttPeer(address, false)) && peer->srtt)
+	shift = 2;
+#endif
+#if (RH_PLATFORM == RH_PLATFORM_RASPI) // use standard library random(), bugs in random(min, max)
+    uint32_t extra = (uint32_t)timeout * (random() & 0xFF) / 256;
+#else
+    uint32_t extra = (uint32_t)timeout * random(0, 256) / 256;
+#endif
+    uint32_t randomised = timeout + (extra >> shift);
+    return randomised > 0xffff ? 0xffff : randomised;
+}
+
+#if RH_RELIABLE_RTT_PEERS
+RHReliableDatagram::RttPeer* RHReliableDatagram::rttPeer(uint8_t address, bool create)
+{
+    if (address == RH_BROADCAST_ADDRESS)
+	return NULL; // Never acknowledged
+    for (uint8_t i = 0; i < RH_RELIABLE_RTT_PEERS; i++)
+	if (_rttPeers[i].address == address)
+	    return &_rttPeers[i];
+    if (!create)
+	return NULL;
+    // Replace the oldest
+    RttPeer* peer = &_rttPeers[_rttPeerNext];
+    if (++_rttPeerNext >= RH_RELIABLE_RTT_PEERS)
+	_rttPeerNext = 0;
+    peer->address = address;
+    peer->backoff = 0;
+    peer->srtt = 0;
+    peer->rttvar = 0;
+    return peer;
+}
+#endif
+
+void RHReliableDatagram::rttSample(uint8_t address, unsigned long rtt)
+{
+#if RH_RELIABLE_RTT_PEERS
+    if (!_adaptiveTimeout)
+	return;
+    RttPeer* peer = rttPeer(address, true);
+    if (!peer)
+	return;
+    // Keep the scaled estimates in 16 bits
+    int16_t m = rtt > 0x1fff ? 0x1fff : rtt;
+    if (peer->srtt == 0)
+    {
+	// First measurement
+	peer->srtt = m << 3;
+	peer->rttvar = m << 1;
+    }
+    else
+    {
+	// Jacobson/Karels: srtt += (m - srtt) / 8, rttvar += (|m - srtt| - rttvar) / 4
+	int16_t err = m - (peer->srtt >> 3);
+	peer->srtt += err;
+	if (err < 0)
+	    err = -err;
+	err -= (peer->rttvar >> 2);
+	peer->rttvar += err;
+    }
+    if (peer->srtt == 0)
+	peer->srtt = 1; // Measured, if very fast
+    // Got through at the first attempt: stop backing off
+    peer->backoff = 0;
+#else
+    (void)address;
+    (void)rtt;
+#endif
+}
+
+void RHReliableDatagram::rttTimedOut(uint8_t address, uint8_t tries)
+{
+#if RH_RELIABLE_RTT_PEERS
+    // Double the timeout for each transmission of the message that timed out, so a window of
+    // messages timing out together backs off once, not once for each.
+    // Destinations not measured yet are backed off too: if the timeout set by setTimeout() is shorter
+    // than the round trip, every ACK would be for a retransmission, and never measured
+    if (!_adaptiveTimeout)
+	return;
+    RttPeer* peer = rttPeer(address, true);
+    if (!peer)
+	return;
+    if (tries > _retries)
+	peer->backoff = 0; // Given up: the next message need not wait for this one's timeouts
+    else if (peer->backoff < tries)
+	peer->backoff = tries > RH_RELIABLE_MAX_BACKOFF ? RH_RELIABLE_MAX_BACKOFF : tries;
+#else
+    (void)address;
+    (void)tries;
+#endif
+}
+
 uint32_t RHReliableDatagram::retransmissions()
 {
     return _retransmissions;
@@ -202,8 +911,17 @@ void RHReliableDatagram::acknowledge(uint8_t id, uint8_t from)
     // a 0 length message again, until its reset, which makes everything hang :-(
     // So we send an ACK of 1 octet
     // REVISIT: should we send the RSSI for the information of the sender?
-    uint8_t ack = '!';
-    sendto(&ack, sizeof(ack), from); 
-    waitPacketSent();
+    uint8_t ack[2] = { '!', 0 };
+    uint8_t len = 1;
+#if RH_RELIABLE_WINDOW
+    // Also acknowledge the earlier messages from the node, in case their ACKs were lost
+    for (uint8_t n = 0; n < RH_RELIABLE_WINDOW_ACK_BITS; n++)
+	if (wasSeen(from, id - n - 1))
+	    ack[1] |= 1 << n;
+    len = 2;
+#endif
+    // Drivers that cannot tell when it has been transmitted wait for it in sendAsync().
+    // Otherwise there is no need to wait: the next send waits for it
+    sendtoAsync(ack, len, from);
 }
 
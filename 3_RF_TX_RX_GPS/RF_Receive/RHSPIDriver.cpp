@@ -14,6 +14,9 @@ RHSPIDriver::RHSPIDriver(uint8_t slaveSelectPin, RHGenericSPI& spi)
 
 bool RHSPIDriver::init()
 {
+    if (!RHGenericDriver::init())
+	return false;
+
     // start the SPI library with the default speeds etc:
     // On Arduino Due this defaults to SPI1 on the central group of 6 SPI pins
     _spi.begin();
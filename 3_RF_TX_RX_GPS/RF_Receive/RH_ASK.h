@@ -8,6 +8,14 @@
 
 #include "RHGenericDriver.h"
 
+// The settings below that can be pre-defined can also be set for one sketch, including the separately
+// compiled RH_ASK.cpp, by defining them in an optional RH_ASK_config.h next to this file
+#if defined(__has_include)
+ #if __has_include("RH_ASK_config.h")
+  #include "RH_ASK_config.h"
+ #endif
+#endif
+
 // Maximum message length (including the headers, byte count and FCS) we are willing to support
 // This is pretty arbitrary
 #define RH_ASK_MAX_PAYLOAD_LEN 67
@@ -16,6 +24,31 @@
 // The headers are inside the payload and are therefore protected by the FCS
 #define RH_ASK_HEADER_LEN 4
 
+// This is the value of the start symbol after 6-bit conversion and nybble swapping
+#define RH_ASK_START_SYMBOL 0xb38
+
+// The start symbols of messages sent with the other line codes
+#define RH_ASK_START_SYMBOL_MANCHESTER 0x347
+#define RH_ASK_START_SYMBOL_SCRAMBLED  0x35c
+
+// The receiver looks for this sync word: the last 4 bits of preamble followed by the start symbol.
+// Any shift of it within the preamble differs in at least 4 bits, so a match with
+// up to RH_ASK_SYNC_ERRORS bit errors is still correctly aligned. The sync words of the
+// line codes also differ from each other, and from any shift of the others, in at least 4 bits.
+#define RH_ASK_SYNC_WORD(startSymbol) (((startSymbol) << 4) | (0x2a >> 2))
+
+/// The number of bit errors tolerated in the sync word, 0 or 1.
+/// With 1, a message whose preamble or start symbol has one corrupted bit is still received.
+/// The chance of noise matching the 16 bit sync word with 1 error is about the same as
+/// of it exactly matching the 12 bit start symbol, which is all that was checked before.
+/// Can be pre-defined prior to including this header
+#ifndef RH_ASK_SYNC_ERRORS
+ #define RH_ASK_SYNC_ERRORS 1
+#endif
+
+// Returned by symbol_6to4() for a 6 bit value that is not a valid symbol
+#define RH_ASK_INVALID_SYMBOL 0xff
+
 // This is the maximum message length that can be supported by this library. 
 // Can be pre-defined to a smaller size (to save SRAM) prior to including this header
 // Here we allow for 1 byte message length, 4 bytes headers, user data and 2 bytes of FCS
@@ -49,6 +82,7 @@
 
 /// Outgoing message bits grouped as 6-bit words
 /// 36 alternating 1/0 bits, followed by 12 bits of start symbol (together called the preamble)
+/// The alternating bits can be shortened with setPreambleLength()
 /// Followed immediately by the 4-6 bit encoded byte count, 
 /// message buffer and 2 byte FCS
 /// Each byte from the byte count on is translated into 2x6-bit words
@@ -57,6 +91,188 @@
 /// This is the number of 6 bit nibbles in the preamble
 #define RH_ASK_PREAMBLE_LEN 8
 
+/// Number of received messages that can be held waiting for collection by recv().
+/// The interrupt handler decodes each message straight into the next free slot of this queue
+/// and keeps listening, so the receiver is not deaf while the application is busy.
+/// Must be a power of 2. Each slot costs RH_ASK_MAX_FRAME_LEN + 1 octets of SRAM, so on AVR the default
+/// is a single slot, like the traditional RH_ASK receive buffer.
+/// Can be pre-defined prior to including this header
+#ifndef RH_ASK_RX_QUEUE_LEN
+ #if defined(__AVR__)
+  #define RH_ASK_RX_QUEUE_LEN 1
+ #else
+  #define RH_ASK_RX_QUEUE_LEN 4
+ #endif
+#endif
+#if (RH_ASK_RX_QUEUE_LEN & (RH_ASK_RX_QUEUE_LEN - 1)) || (RH_ASK_RX_QUEUE_LEN > 128)
+ #error RH_ASK_RX_QUEUE_LEN must be a power of 2 no greater than 128
+#endif
+
+/// Number of outgoing messages that can be queued for transmission by send().
+/// Each message is encoded into symbols when it is queued, and the interrupt handler chains
+/// straight from the end of one message into the preamble of the next, without returning to idle.
+/// send() only blocks when the queue is full, so with the default of 1 it behaves like
+/// the traditional RH_ASK send(). Must be a power of 2. 
+/// Each slot costs (RH_ASK_MAX_FRAME_LEN * 2) + RH_ASK_PREAMBLE_LEN + 1 octets of SRAM.
+/// Can be pre-defined prior to including this header
+#ifndef RH_ASK_TX_QUEUE_LEN
+ #define RH_ASK_TX_QUEUE_LEN 1
+#endif
+#if (RH_ASK_TX_QUEUE_LEN & (RH_ASK_TX_QUEUE_LEN - 1)) || (RH_ASK_TX_QUEUE_LEN > 128)
+ #error RH_ASK_TX_QUEUE_LEN must be a power of 2 no greater than 128
+#endif
+
+/// Number of earlier corrupted copies of a message kept for combining with later ones, 
+/// when combining is enabled with setCombining(). 0 removes combining support altogether.
+/// Each copy costs RH_ASK_MAX_PAYLOAD_LEN + (RH_ASK_MAX_PAYLOAD_LEN+7)/8 octets of SRAM, 
+/// and each receive queue slot costs another (RH_ASK_MAX_PAYLOAD_LEN+7)/8 + 1. Combining also uses
+/// over 2 * RH_ASK_MAX_PAYLOAD_LEN octets of stack in available(), so it is left out by default on AVR.
+/// Can be pre-defined prior to including this header
+#ifndef RH_ASK_COMBINE_COPIES
+ #if defined(__AVR__)
+  #define RH_ASK_COMBINE_COPIES 0
+ #else
+  #define RH_ASK_COMBINE_COPIES 4
+ #endif
+#endif
+
+/// Corrupted copies are only combined if each arrived within this many milliseconds of the previous one
+#ifndef RH_ASK_COMBINE_TIMEOUT
+ #define RH_ASK_COMBINE_TIMEOUT 2000
+#endif
+
+/// When combining copies of a message leaves octets where the copies disagree with no majority,
+/// each of the alternatives is tried, at up to this many octets, ie 2^RH_ASK_COMBINE_MAX_TRIALS FCS checks
+#ifndef RH_ASK_COMBINE_MAX_TRIALS
+ #define RH_ASK_COMBINE_MAX_TRIALS 3
+#endif
+
+/// Set to 0 to remove support for forward error correction (see setFec()), to save flash and SRAM.
+/// Defaults to 0 on AVR. Can be pre-defined prior to including this header
+#ifndef RH_ASK_FEC
+ #if defined(__AVR__)
+  #define RH_ASK_FEC 0
+ #else
+  #define RH_ASK_FEC 1
+ #endif
+#endif
+
+/// Number of Reed-Solomon parity octets sent after the FCS of messages sent with forward error correction.
+/// This is part of the message format, so unlike the other settings here it must not be changed
+#define RH_ASK_FEC_PARITY_LEN 4
+
+/// The bit in the FLAGS header that marks a message followed by Reed-Solomon parity octets.
+/// One of the RH_FLAGS_RESERVED bits
+#define RH_ASK_FLAGS_FEC 0x20
+
+/// The longest frame (byte count, headers, user data, FCS and any FEC parity) that is buffered
+#if RH_ASK_FEC
+ #define RH_ASK_MAX_FRAME_LEN (RH_ASK_MAX_PAYLOAD_LEN + RH_ASK_FEC_PARITY_LEN)
+#else
+ #define RH_ASK_MAX_FRAME_LEN RH_ASK_MAX_PAYLOAD_LEN
+#endif
+
+// Both combining and forward error correction need to know which octets contained invalid symbols
+#define RH_ASK_ERASURES ((RH_ASK_COMBINE_COPIES > 0) || RH_ASK_FEC)
+
+/// The longest run of identical bits that the edge receive engine will decode from the
+/// interval between 2 edges. Longer intervals (such as the quiet gap between messages on a wired link)
+/// are truncated to this many bits, which is enough to complete any message in progress
+/// and to flush the start symbol detector, and the bit clock starts afresh at the next edge.
+#ifndef RH_ASK_EDGE_MAX_RUN
+ #define RH_ASK_EDGE_MAX_RUN 13
+#endif
+
+/// Loop gain of the edge receive engine bit clock recovery. Each edge moves the bit period boundary
+/// 1/(2^RH_ASK_EDGE_PLL_SHIFT) of the way towards itself
+#ifndef RH_ASK_EDGE_PLL_SHIFT
+ #define RH_ASK_EDGE_PLL_SHIFT 2
+#endif
+
+/// Channel activity detection: isChannelActive() reports activity when the received signal has had at least
+/// this many more transitions on the recovered bit clock than off it (off clock transitions count double)
+#ifndef RH_ASK_CAD_THRESHOLD
+ #define RH_ASK_CAD_THRESHOLD 8
+#endif
+
+/// Channel activity detection: the channel is clear again after this many bit periods with no 
+/// transitions on the recovered bit clock
+#ifndef RH_ASK_CAD_HOLD_BITS
+ #define RH_ASK_CAD_HOLD_BITS 12
+#endif
+
+/// CSMA backoff slot time in bit periods. Must be longer than it takes to detect a transmission
+/// (about RH_ASK_CAD_THRESHOLD bits of its preamble), and no more than 31
+#ifndef RH_ASK_CSMA_SLOT_BITS
+ #define RH_ASK_CSMA_SLOT_BITS 16
+#endif
+#if (RH_ASK_CSMA_SLOT_BITS > 31)
+ #error RH_ASK_CSMA_SLOT_BITS must be no more than 31
+#endif
+
+/// CSMA contention window: before transmitting, the channel must be clear for 1 to this many slots, at random
+#ifndef RH_ASK_CSMA_WINDOW
+ #define RH_ASK_CSMA_WINDOW 16
+#endif
+
+/// Set to 0 to remove support for rate adaptation (see setRateAdaptation()), to save flash and SRAM.
+/// Its state costs 3 * RH_ASK_RATE_MAX_SPEEDS + 22 octets of SRAM (40 by default).
+/// Defaults to 0 on AVR. Can be pre-defined prior to including this header
+#ifndef RH_ASK_RATE_ADAPTATION
+ #if defined(__AVR__)
+  #define RH_ASK_RATE_ADAPTATION 0
+ #else
+  #define RH_ASK_RATE_ADAPTATION 1
+ #endif
+#endif
+
+/// Rate adaptation: the most speeds that can be passed to setRateAdaptation()
+#ifndef RH_ASK_RATE_MAX_SPEEDS
+ #define RH_ASK_RATE_MAX_SPEEDS 6
+#endif
+
+/// The bit in the FLAGS header that marks rate adaptation control messages. They are handled by the driver
+/// and never delivered to the application. One of the RH_FLAGS_RESERVED bits
+#define RH_ASK_FLAGS_RATE 0x10
+
+/// Rate adaptation: the receiver reports its frame error rate after this many messages
+#ifndef RH_ASK_RATE_REPORT_FRAMES
+ #define RH_ASK_RATE_REPORT_FRAMES 8
+#endif
+
+/// Rate adaptation: step down to the next lower speed when a reported frame error rate is more
+/// than this, in 1/256ths
+#ifndef RH_ASK_RATE_DOWN_FER
+ #define RH_ASK_RATE_DOWN_FER 96
+#endif
+
+/// Rate adaptation: step up to the next higher speed after RH_ASK_RATE_UP_REPORTS reports in a row
+/// with frame error rates of no more than this, in 1/256ths
+#ifndef RH_ASK_RATE_UP_FER
+ #define RH_ASK_RATE_UP_FER 32
+#endif
+
+/// Rate adaptation: number of good reports needed before stepping up. Doubles (up to 64) each time
+/// a step up from a speed fails, so a link at the edge of the next speed does not keep trying it
+#ifndef RH_ASK_RATE_UP_REPORTS
+ #define RH_ASK_RATE_UP_REPORTS 2
+#endif
+
+/// Rate adaptation: step down a speed after this many bit periods with no good message received.
+/// The receiver also reports at least every quarter this many bit periods while it is receiving. No more than 65535
+#ifndef RH_ASK_RATE_TIMEOUT_BITS
+ #define RH_ASK_RATE_TIMEOUT_BITS 16000
+#endif
+
+#if (RH_PLATFORM == RH_PLATFORM_UNIX)
+/// Size of the buffer for the simulated receiver's sample stream, in octets of 8 samples
+ #ifndef RH_ASK_STREAM_BUF_LEN
+  #define RH_ASK_STREAM_BUF_LEN 4096
+ #endif
+/// Number of bit periods of idle samples written to the sample stream after the transmitter goes idle
+ #define RH_ASK_STREAM_TRAILER_LEN 2
+#endif
+
 /////////////////////////////////////////////////////////////////////
 /// \class RH_ASK RH_ASK.h <RH_ASK.h>
 /// \brief Driver to send and receive unaddressed, unreliable datagrams via inexpensive ASK (Amplitude Shift Keying) or 
@@ -103,12 +319,14 @@
 /// Messages of up to RH_ASK_MAX_PAYLOAD_LEN (67) bytes can be sent
 /// Each message is transmitted as:
 ///
-/// - 36 bit training preamble consisting of 0-1 bit pairs
+/// - 36 bit training preamble consisting of 0-1 bit pairs (6 to 36 bits, see setPreambleLength())
 /// - 12 bit start symbol 0xb38
 /// - 1 byte of message length byte count (4 to 30), count includes byte count and FCS bytes
 /// - n message bytes (uincluding 4 bytes of header), maximum n is RH_ASK_MAX_MESSAGE_LEN + 4 (64)
 /// - 2 bytes FCS, sent low byte-hi byte
 ///
+/// The receiver starts a message when it sees the last 4 bits of the preamble and the start symbol,
+/// with up to RH_ASK_SYNC_ERRORS bit errors.
 /// Everything after the start symbol is encoded 4 to 6 bits, Therefore a byte in the message
 /// is encoded as 2x6 bit symbols, sent hi nybble, low nybble. Each symbol is sent LSBit
 /// first. The message may consist of any binary digits.
@@ -121,8 +339,176 @@
 /// (6 + 2 + RH_ASK_MAX_MESSAGE_LEN*2) * 6 = 768 bits = 0.384 secs (at 2000 bps).
 /// where RH_ASK_MAX_MESSAGE_LEN is RH_ASK_MAX_PAYLOAD_LEN - 7 (= 60).
 /// The code consists of an ISR interrupt handler. Most of the work is done in the interrupt
-/// handler for both transmit and receive, but some is done from the user level. Expensive
-/// functions like CRC computations are always done in the user level.
+/// handler for both transmit and receive, but some is done from the user level.
+/// The receiver accumulates the FCS with a table driven CRC update as each byte is decoded, so a
+/// corrupted message is rejected by the interrupt handler as soon as it is complete, and never occupies
+/// a slot in the receive queue. If you would rather keep the CRC computation out of the interrupt handler
+/// (eg to compare the interrupt handler cost), define RH_ASK_USER_LEVEL_CRC and the FCS will be checked
+/// over the whole message at user level by available() instead.
+///
+/// Received messages are placed in a queue of RH_ASK_RX_QUEUE_LEN slots by the interrupt handler.
+/// The receiver keeps listening after each message, and continues to fill free slots while the
+/// application is busy elsewhere. Messages are validated and delivered to the application in order
+/// of arrival by available() and recv(). If a message arrives when all the slots are full, it is
+/// dropped and counted by rxOverflow().
+///
+/// Similarly, send() encodes outgoing messages into a queue of RH_ASK_TX_QUEUE_LEN symbol buffers.
+/// If there is a free slot, send() returns as soon as the message is encoded, and the interrupt handler
+/// transmits the queued messages back to back. Use txQueueSpace() to check whether send() would block.
+/// waitPacketSent() waits until the whole queue has been transmitted. Each message queued with sendAsync()
+/// has its own callback, which service() calls when that message has been transmitted.
+///
+/// \par Combining repeated messages
+///
+/// If the application sends each message several times because single copies are often corrupted,
+/// enable combining with setCombining(). Then instead of dropping a corrupted message, the receiver keeps
+/// up to RH_ASK_COMBINE_COPIES recent corrupted copies with the same length and headers, arriving within
+/// RH_ASK_COMBINE_TIMEOUT milliseconds of each other. When another corrupted copy arrives, the copies vote
+/// on each octet of the message, ignoring octets that contained invalid symbols. If the majority
+/// message passes the FCS, it is delivered just as if it had been received correctly. If some octets
+/// have no majority (eg with only 2 copies), each of the alternatives is tried in turn. The FCS
+/// is checked for each candidate, so a combined message is as trustworthy as any other, but do not
+/// make RH_ASK_COMBINE_MAX_TRIALS large. This often recovers a message from 2 or 3 corrupted copies, so
+/// fewer repetitions are needed. When combining is enabled, the receiver does not drop messages
+/// as soon as an invalid symbol arrives: it needs the rest of the message to combine.
+/// The combining is done at user level, in available().
+///
+/// \par Channel activity detection and CSMA
+///
+/// When no transmitter is on, most ASK receivers output random noise, so the presence of transitions
+/// means nothing in itself. But the transitions of a real transmission, and especially of its preamble of
+/// alternating bits, all fall on the bit clock recovered by the receive engine, and those of noise fall anywhere.
+/// The receiver scores each transition by whether it is within about 1/8 bit period of the recovered bit clock,
+/// and isChannelActive() reports activity while the score is at least RH_ASK_CAD_THRESHOLD, and there 
+/// has been such a transition in the last RH_ASK_CAD_HOLD_BITS bit periods, or a message is being received.
+/// A transmission is detected about 10 bits into its preamble. The receiver must be running (RHModeRx, as after
+/// available()) for this to work. isChannelActive() enables the generic waitCAD() (see setCADTimeout()),
+/// but its delays of 100 to 1000 ms are long compared with RH_ASK messages.
+///
+/// Instead, setCsma() enables carrier sense multiple access in the interrupt handler: send() queues the 
+/// message and returns as usual, but if the transmitter is idle, the message is only transmitted once the 
+/// channel has been clear for a random backoff of 1 to RH_ASK_CSMA_WINDOW slots of RH_ASK_CSMA_SLOT_BITS 
+/// bit periods. The backoff pauses while the channel is active, and continues when it is clear again,
+/// so nodes waiting for a busy channel take turns. Messages queued while transmitting are sent straight after
+/// the current one as usual. waitPacketSent() also waits for any backoff. The receiver keeps running during the 
+/// backoff, and with the edge receive engine the timer interrupt runs during the backoff too.
+/// setModeIdle() stops any transmission and cancels any backoff. Messages still queued, including one that
+/// was being transmitted, are sent from the start by the next send().
+/// See examples/simulator/simulator_ask_csma_benchmark for the effect on a busy channel.
+///
+/// \par Forward error correction
+///
+/// A single bit error changes the number of 1s in a 6 bit symbol, so it always makes an invalid symbol. 
+/// So the receiver knows which octets of a corrupted message are wrong, even though it does not know their values.
+/// With setFec() enabled, send() adds RH_ASK_FEC_PARITY_LEN (4) octets of Reed-Solomon parity after the FCS,
+/// and sets the RH_ASK_FLAGS_FEC bit in the FLAGS header. The byte count does not include the parity, so
+/// older receivers just receive the message as usual and ignore the parity that follows it.
+/// When this receiver gets a message with the RH_ASK_FLAGS_FEC bit (or with the FLAGS header itself corrupted)
+/// that fails the FCS or contains invalid symbols, it also collects the parity, and available() uses it
+/// to reconstruct up to 4 octets that contained invalid symbols (in the headers, user data, FCS or parity).
+/// The FCS is checked after correction, so a corrected message is as trustworthy as any other.
+/// Messages that arrive intact are delivered as soon as the FCS arrives, and the parity is ignored.
+/// The parity costs 48 bits per message, much less than sending the message again, and recovers most
+/// messages with a few bit errors. Corruption of the byte count octet cannot be corrected. 
+/// The decoding is done at user level, in available(), and takes a few hundred table lookups.
+/// If both are enabled, combining is tried on messages that forward error correction could not recover.
+/// See examples/simulator/simulator_ask_fec_benchmark for the effect on goodput.
+/// Messages with forward error correction are received regardless of setFec(), unless RH_ASK_FEC is 0.
+///
+/// \par Line codes
+///
+/// The line code is how each octet of the message is turned into bits on the air. Select it by passing
+/// lineCode to the constructor:
+/// - LineCode4b6b: the default, and the only code understood by older versions of RH_ASK.
+///   Each 4 bits is sent as a 6 bit symbol with 3 ones and 3 zeros, and at most 3 consecutive identical bits.
+///   12 bits per octet: 67% of the bit rate carries data. Only 16 of the 64 possible symbols are valid,
+///   so most bit errors are detected at the symbol where they occur.
+/// - LineCodeManchester: each bit is sent as a 1 0 or 0 1 pair. 16 bits per octet: 50% efficient,
+///   but there is a transition in the middle of every bit for the PLL, and any single bit error is detected.
+///   The most robust when the receiver slices the signal poorly, or the transmitter clock is inaccurate.
+/// - LineCodeScrambled: the octets are whitened with the PN9 sequence (as used by many FSK radios), so they
+///   have about as many ones as zeros, and each 4 bits is followed by the complement of the 4th bit,
+///   so there is a transition at least every 5 bits. 10 bits per octet: 80% efficient, but only
+///   bit errors in the 4th and 5th bits of each group are detected as invalid symbols: the rest are left to the FCS.
+///   Best for short messages on a clean channel.
+///
+/// The speed passed to the constructor is the bit rate on the air whatever the line code. The transmitter
+/// and receiver must use the same line code. Each line code has its own start symbol, so a receiver ignores
+/// messages in other line codes, instead of decoding them wrongly. The preamble, byte count, headers, FCS
+/// and FEC parity are the same for all line codes.
+/// See examples/simulator/simulator_ask_linecode_benchmark for the goodput of each.
+///
+/// \par Rate adaptation
+///
+/// The range of an ASK link depends strongly on the bit rate: each halving of the speed doubles the energy
+/// per bit. setSpeed() changes the bit rate at any time, reprogramming the timer without init().
+/// setRateAdaptation() goes further: both ends of a link are given the same ladder of speeds, and move up and down
+/// it together as the frame error rate changes, so short links run fast and long ones keep working.
+///
+/// The receiving end counts the good and bad messages it receives (rxGood() and rxBad()), and every
+/// RH_ASK_RATE_REPORT_FRAMES messages, or every RH_ASK_RATE_TIMEOUT_BITS/4 bit periods if it is receiving less often,
+/// sends a report of its frame error rate back to the node it last heard from. The sending end
+/// decides: when a report shows more than RH_ASK_RATE_DOWN_FER it asks to step down a speed,
+/// and after RH_ASK_RATE_UP_REPORTS clean reports in a row it asks to step up. The other end accepts, and each
+/// end changes speed once it has finished transmitting what it had queued. If a step up fails, more
+/// clean reports are needed before it is tried again. If either end hears no good message for
+/// RH_ASK_RATE_TIMEOUT_BITS bit periods (because the link has failed, or the handshake was lost)
+/// it steps down a speed, and keeps doing so until it hears the other end, which does the same. The timeout
+/// is in bit periods, so the end at the lower speed waits longer, and the other catches up. After a change, the accepting
+/// end only waits an eighth of that (and the requesting end a half) before going back to the speed it came from,
+/// so a failed step up, or a lost acceptance, costs little. The receiving end reports soon after a change, to show
+/// the new speed works.
+///
+/// The reports and the rate change handshake are short messages with the RH_ASK_FLAGS_RATE bit in the FLAGS
+/// header, sent with the current headers TO the peer. The driver handles them in available(), and they are never
+/// delivered to the application, so the application should call available() or recv() regularly.
+/// Rate adaptation is meant for a link between 2 nodes that both send from time to time
+/// (such as with RHReliableDatagram, whose acknowledgements are enough): a node that never receives
+/// cannot report. It needs the oversampling receive engine, and is not supported by RH_ASKMulti.
+/// See examples/simulator/simulator_ask_rate_benchmark for goodput against noise, with and without it.
+/// Rate adaptation is left out by default on AVR: define RH_ASK_RATE_ADAPTATION as 1 to use it there.
+///
+/// \par Receive engines
+///
+/// By default the receiver samples the rx pin 8 times per bit period in the timer interrupt, and
+/// recovers the bit clock with a software PLL (RxEngineOversample). This costs 8 interrupts per bit
+/// whether or not anything is being received, which is a large part of the CPU on a small processor
+/// at higher bit rates.
+///
+/// Alternatively, pass RxEngineEdge to the constructor to use the edge receive engine. It takes an interrupt
+/// on each change of the rx pin and timestamps it with micros(). From the timestamps it measures exactly how long
+/// the line was high in each bit period, and declares a 1 bit if that was more than half the period, just like the
+/// integrator of the oversampling engine. Each edge moves the bit period boundaries 1/(2^RH_ASK_EDGE_PLL_SHIFT) of the
+/// way towards itself, doing the job of the PLL. While receiving, the timer interrupt is
+/// not needed at all (on AVR it is disabled except while transmitting). The interrupt rate depends on the
+/// signal instead of the bit rate: about 1.3 edges per bit during a message.
+/// Both engines produce the same bits for the rest of the receiver, so messages are compatible either way.
+///
+/// The edge engine needs the rx pin to be an external interrupt pin supported by attachInterrupt()
+/// (pins 2 and 3 on Uno, not the default pin 11), and is not available on RH_PLATFORM_GENERIC_AVR8:
+/// init() returns false in those cases. micros() has a resolution of 4 microseconds on 16MHz AVRs, which
+/// is adequate up to bit rates of about 10000 bps. Bits are decoded when the next edge arrives, so
+/// available() also decodes any bits completed since the last edge, in case a message ends with
+/// a run of bits at the idle level.
+///
+/// \par Simulation and sample streams
+///
+/// On Linux and OSX (RH_PLATFORM_UNIX) there is no timer interrupt and no pins. Instead the modem
+/// works on streams of samples at 8 samples per bit period, packed 8 to an octet, first sample in bit 0,
+/// so each octet holds one nominal bit period. receiveSamples() passes a buffer of samples through the 
+/// oversampling receiver, exactly as if they had been read by the timer interrupt, and transmitSamples()
+/// generates the samples the timer interrupt would have written to the txPin. These can be used to decode
+/// captured samples in bulk, for regression tests and benchmarks. See examples/simulator/simulator_ask_receiver.
+///
+/// setSampleStreams() connects the receiver and transmitter to file descriptors such as files or pipes.
+/// Then available() reads and decodes whatever samples are waiting on the rx stream, and send()
+/// writes the whole message to the tx stream at once, so 2 simulated RH_ASK nodes can talk to each other
+/// over pipes:
+/// \code
+/// tools/simBuild examples/simulator/simulator_ask_transmitter/simulator_ask_transmitter.pde
+/// tools/simBuild examples/simulator/simulator_ask_receiver/simulator_ask_receiver.pde
+/// ./simulator_ask_transmitter 10 | ./simulator_ask_receiver
+/// \endcode
 ///
 /// \par Supported Hardware
 ///
@@ -251,6 +637,21 @@
 class RH_ASK : public RHGenericDriver
 {
 public:
+    /// \brief Defines the different ways the receiver can recover bits from the rxPin
+    typedef enum
+    {
+	RxEngineOversample = 0,   ///< Sample the rxPin 8 times per bit in the timer interrupt and track it with a PLL
+	RxEngineEdge              ///< Timestamp each edge on the rxPin in a pin change interrupt
+    } RxEngine;
+
+    /// \brief Line codes for sending messages. See the Line codes section above.
+    typedef enum
+    {
+	LineCode4b6b = 0,         ///< 4 bits to 6 bit symbols, compatible with older RH_ASK. 67% efficient
+	LineCodeManchester,       ///< Each bit sent as 2 of opposite value. 50% efficient
+	LineCodeScrambled         ///< Whitened NRZ, a transition bit after each 4 bits. 80% efficient
+    } LineCode;
+
     /// Constructor.
     /// At present only one instance of RH_ASK per sketch is supported.
     /// \param[in] speed The desired bit rate in bits per second
@@ -258,7 +659,10 @@ public:
     /// \param[in] txPin The pin that is used to send data to the transmitter
     /// \param[in] pttPin The pin that is connected to the transmitter controller. It will be set HIGH to enable the transmitter (unless pttInverted is true).
     /// \param[in] pttInverted true if you desire the pttin to be inverted so that LOW wil enable the transmitter.
-    RH_ASK(uint16_t speed = 2000, uint8_t rxPin = 11, uint8_t txPin = 12, uint8_t pttPin = 10, bool pttInverted = false);
+    /// \param[in] rxEngine How the receiver recovers bits from the rxPin. See the Receive engines section above.
+    /// \param[in] lineCode The line code to send and receive messages with. See the Line codes section above.
+    RH_ASK(uint16_t speed = 2000, uint8_t rxPin = 11, uint8_t txPin = 12, uint8_t pttPin = 10, bool pttInverted = false,
+	   RxEngine rxEngine = RxEngineOversample, LineCode lineCode = LineCode4b6b);
 
     /// Initialise the Driver transport hardware and software.
     /// Make sure the Driver is properly configured before calling init().
@@ -267,8 +671,10 @@ public:
 
     /// Tests whether a new message is available
     /// from the Driver. 
-    /// On most drivers, this will also put the Driver into RHModeRx mode until
-    /// a message is actually received bythe transport, when it wil be returned to RHModeIdle.
+    /// If the Driver is not transmitting, this will also put the Driver into RHModeRx mode.
+    /// Unlike most other drivers, RH_ASK stays in RHModeRx after a message is received, and continues
+    /// to queue incoming messages until the receive queue is full.
+    /// Messages already in the receive queue can be collected even while transmitting.
     /// This can be called multiple times in a timeout loop
     /// \return true if a new, complete, error-free uncollected message is available to be retreived by recv()
     virtual bool    available();
@@ -284,14 +690,54 @@ public:
     /// \return true if a valid message was copied to buf
     virtual bool    recv(uint8_t* buf, uint8_t* len);
 
-    /// Waits until any previous transmit packet is finished being transmitted with waitPacketSent().
-    /// Then loads a message into the transmitter and starts the transmitter. Note that a message length
+    /// Returns a pointer to the oldest message in the receive queue, without copying it. Its slot is kept
+    /// from the interrupt handler until release(), so the rest of the queue is still available for new messages.
+    /// See RHGenericDriver::recvView()
+    /// \param[out] buf Set to point to the message
+    /// \param[out] len Set to the length of the message
+    /// \param[in] copy Not used
+    /// \param[in] copyLen Not used
+    /// \return true if there was a valid message
+    virtual bool    recvView(const uint8_t** buf, uint8_t* len, uint8_t* copy = NULL, uint8_t copyLen = 0);
+
+    /// Gives the slot of the message returned by recvView() back to the interrupt handler
+    virtual void    release();
+
+    /// Waits until there is a free slot in the transmit queue (with the default RH_ASK_TX_QUEUE_LEN of 1,
+    /// until any previous transmit packet is finished being transmitted).
+    /// Then encodes the message into the transmit queue and starts the transmitter if it is not already
+    /// running. If the transmitter is idle, waitCAD() is called first. Note that a message length
     /// of 0 is NOT permitted. 
     /// \param[in] data Array of data to be sent
     /// \param[in] len Number of bytes of data to send (> 0)
     /// \return true if the message length was valid and it was correctly queued for transmit
     virtual bool    send(const uint8_t* data, uint8_t len);
 
+    /// Queues a message like send(), and remembers callback for service() to call when the message has been
+    /// transmitted. Only waits if the transmit queue is full, as send() does.
+    /// \param[in] data Array of data to be sent
+    /// \param[in] len Number of bytes of data to send (> 0)
+    /// \param[in] callback Function to call when the message has been transmitted, or NULL
+    /// \param[in] context Passed to callback
+    /// \return true if the message length was valid and it was correctly queued for transmit
+    virtual bool    sendAsync(const uint8_t* data, uint8_t len, SendCallback callback = NULL, void* context = NULL);
+
+    /// Calls the callbacks of the messages sent with sendAsync() that have been transmitted, in order
+    virtual void    service();
+
+    /// Blocks until the transmitter is no longer transmitting, or waiting to transmit with CSMA
+    virtual bool    waitPacketSent();
+
+    /// Blocks until the transmitter is no longer transmitting, or waiting to transmit with CSMA, or until the timeout
+    /// \param[in] timeout The maximum time to wait in milliseconds
+    /// \return false if timed out
+    virtual bool    waitPacketSent(uint16_t timeout);
+
+    /// Tells whether another transmitter is active on the channel, from the transitions in the received signal.
+    /// See the Channel activity detection and CSMA section above. Puts the driver in RHModeRx if it is idle.
+    /// \return true if the channel is active
+    virtual bool    isChannelActive();
+
     /// Returns the maximum message length 
     /// available in this Driver.
     /// \return The maximum legal message length
@@ -310,12 +756,157 @@ public:
     void           setModeTx();
 
     /// dont call this it used by the interrupt handler
-    void            handleTimerInterrupt();
+    virtual void    handleTimerInterrupt();
+
+    /// dont call this it used by the pin change interrupt handler of the edge receive engine
+    void            handleEdgeInterrupt();
 
     /// Returns the current speed in bits per second
     /// \return The current speed in bits per second
     uint16_t        speed() { return _speed;}
 
+    /// Changes the bit rate, reprogramming the timer without init(). Waits for any message being
+    /// transmitted to finish first, and any message being received is lost.
+    /// Both ends of a link must use the same speed: see also setRateAdaptation().
+    /// \param[in] speed The new bit rate in bits per second
+    /// \return true if the timer can run at the speed
+    bool            setSpeed(uint16_t speed);
+
+    /// Enables or disables rate adaptation. See the Rate adaptation section above.
+    /// Both ends of the link must be given the same speeds, and start at the same speed.
+    /// \param[in] speeds The speeds to adapt between in bits per second, lowest first. Copied.
+    /// NULL to disable rate adaptation
+    /// \param[in] numSpeeds The number of speeds, up to RH_ASK_RATE_MAX_SPEEDS
+    /// \return false if the timer cannot run at one of the speeds, the receive engine is RxEngineEdge,
+    /// or RH_ASK_RATE_ADAPTATION is 0 and speeds were given. Call after init(). The driver starts at the lowest speed
+    bool            setRateAdaptation(const uint16_t* speeds, uint8_t numSpeeds);
+
+    /// Returns the count of speed changes made by rate adaptation
+    /// \return The number of speed changes, including those after losing contact
+    uint16_t        rateChanges();
+
+    /// Returns the frame error rate in the last report from the other end of the link,
+    /// for messages sent by this node
+    /// \return The frame error rate in 1/256ths
+    uint8_t         rateFrameErrorRate();
+
+    /// Returns the number of received messages waiting in the receive queue, including any that
+    /// have not yet been validated by available()
+    /// \return The number of queued messages, 0 to RH_ASK_RX_QUEUE_LEN
+    uint8_t         rxQueueDepth();
+
+    /// Returns the count of messages that were dropped because the receive queue was full
+    /// when their start symbol arrived. If this increases, collect messages more often
+    /// or increase RH_ASK_RX_QUEUE_LEN.
+    /// \return The number of messages dropped due to receive queue overflow
+    uint16_t        rxOverflow();
+
+    /// Returns the count of received messages that were dropped because they contained a 6 bit
+    /// code that is not a valid symbol. The receiver drops such a message as soon as the invalid
+    /// symbol arrives, without waiting for the rest of it (unless the message has forward error correction
+    /// parity or combining is enabled, when it keeps the rest to try to recover it). These messages are also
+    /// counted by rxBad(), and by rxFecCorrected() or rxCombined() if they are recovered.
+    /// \return The number of messages dropped due to symbol errors
+    uint16_t        rxSymbolErrors();
+
+    /// Returns where the invalid symbol was found in the most recent message dropped due to a symbol error.
+    /// Consistently low values suggest a timing or start symbol problem, consistently high ones
+    /// suggest the signal is fading during long messages.
+    /// \return The offset of the corrupted octet in the message, counting the message length octet as 0
+    uint8_t         rxSymbolErrorPosition();
+
+    /// Enables or disables early address rejection in the receiver.
+    /// Normally every message on the channel is received in full, queued and checked, and only then 
+    /// discarded if its TO header is not thisAddress or RH_BROADCAST_ADDRESS. In a busy network
+    /// most of the receiver's time and queue slots can go on other nodes' traffic. 
+    /// When enabled, the interrupt handler checks the TO header as soon as it is decoded, and drops messages
+    /// for other nodes immediately, going straight back to looking for the next start symbol.
+    /// Has no effect in promiscuous mode. 
+    /// Caution: the TO header is checked before the FCS, so a message for this node whose TO
+    /// header was corrupted is also dropped this way, rather than as a bad message.
+    /// \param[in] enable true to enable early address rejection. Defaults to false.
+    void            setEarlyAddressFilter(bool enable);
+
+    /// Enables or disables combining of corrupted copies of repeated messages.
+    /// See the Combining repeated messages section above. Has no effect if RH_ASK_COMBINE_COPIES is 0.
+    /// \param[in] enable true to enable combining. Defaults to false.
+    void            setCombining(bool enable);
+
+    /// Sets the number of 6 bit symbols of alternating 1/0 bits sent before the start symbol of each message.
+    /// The receiver needs the preamble to lock its PLL onto the bit clock before the start symbol arrives:
+    /// a shorter preamble saves airtime, which for short messages is significant, at the cost
+    /// of missing more messages on a noisy channel. The receiver accepts any preamble length.
+    /// See the simulator_ask_preamble_benchmark example for the tradeoff.
+    /// Takes effect from the next message transmitted.
+    /// \param[in] symbols Number of symbols of preamble, 1 to RH_ASK_PREAMBLE_LEN - 2 (6). Defaults to 6
+    void            setPreambleLength(uint8_t symbols);
+
+    /// Returns the count of messages whose sync word (the end of the preamble and the start symbol)
+    /// was received with a bit error, and which would have been missed without RH_ASK_SYNC_ERRORS
+    /// \return The number of messages started with a corrupted sync word
+    uint16_t        rxSyncErrors();
+
+    /// Enables or disables carrier sense multiple access. See the Channel activity detection and CSMA section above.
+    /// \param[in] enable true to wait for a random backoff with the channel clear before each transmission. 
+    /// Defaults to false.
+    void            setCsma(bool enable);
+
+    /// Enables or disables forward error correction parity on messages sent by send().
+    /// See the Forward error correction section above. Has no effect if RH_ASK_FEC is 0.
+    /// \param[in] enable true to send Reed-Solomon parity after each message. Defaults to false.
+    void            setFec(bool enable);
+
+    /// Returns the count of corrupted messages that were recovered with forward error correction
+    /// \return The number of messages recovered with forward error correction
+    uint16_t        rxFecCorrected();
+
+    /// Returns the count of messages that were recovered by combining corrupted copies
+    /// \return The number of messages recovered by combining
+    uint16_t        rxCombined();
+
+    /// Returns the count of messages dropped by early address rejection
+    /// \return The number of messages for other nodes that were dropped as soon as their TO header arrived
+    uint16_t        rxAddressDrops();
+
+    /// Returns the number of messages that can be passed to send() without blocking
+    /// \return The number of free slots in the transmit queue, 0 to RH_ASK_TX_QUEUE_LEN
+    uint8_t         txQueueSpace();
+
+    /// Returns the number of messages waiting in the transmit queue, including the one
+    /// currently being transmitted
+    /// \return The number of queued messages, 0 to RH_ASK_TX_QUEUE_LEN
+    uint8_t         txQueueDepth();
+
+#if (RH_PLATFORM == RH_PLATFORM_UNIX)
+    /// Passes a buffer of samples through the oversampling receiver, as if they had been read from the rxPin 
+    /// by the timer interrupt. Complete messages are queued as usual for available() and recv().
+    /// Stops early if the receive queue becomes full, so no messages are lost:
+    /// collect them with recv() and call again with the rest of the samples.
+    /// \param[in] samples The samples, 8 to an octet, first sample in bit 0
+    /// \param[in] len Number of octets of samples
+    /// \return The number of octets of samples used
+    uint32_t        receiveSamples(const uint8_t* samples, uint32_t len);
+
+    /// Generates the samples of the txPin for messages queued by send(), as the timer interrupt would have.
+    /// Stops when the transmit queue is empty and the driver goes idle. Without a tx stream,
+    /// this is how queued messages get transmitted in the simulator.
+    /// \param[out] samples Where to put the samples, 8 to an octet, first sample in bit 0
+    /// \param[in] len The maximum number of octets of samples to generate
+    /// \return The number of octets of samples generated
+    uint32_t        transmitSamples(uint8_t* samples, uint32_t len);
+
+    /// Connects the simulated receiver and transmitter to sample streams. available() reads and decodes
+    /// all the samples waiting on rxFd (which is made non-blocking), and send() writes each message
+    /// to txFd as soon as it is queued.
+    /// \param[in] rxFd File descriptor to read received samples from, or -1 for none
+    /// \param[in] txFd File descriptor to write transmitted samples to, or -1 for none
+    void            setSampleStreams(int rxFd, int txFd);
+
+    /// Tells whether all the samples in the rx stream have been read and decoded
+    /// \return true if the rx stream has reached end of file
+    bool            sampleStreamEnded();
+#endif
+
 #if (RH_PLATFORM == RH_PLATFORM_ESP8266)
     /// ESP8266 timer0 increment value
     uint32_t _timerIncrement;
@@ -325,6 +916,11 @@ protected:
     /// Helper function for calculating timer ticks
     uint8_t         timerCalc(uint16_t speed, uint16_t max_ticks, uint16_t *nticks);
 
+    /// Tells whether the timer can generate interrupts at 8 times a bit rate
+    /// \param[in] speed The bit rate in bits per second
+    /// \return true if the speed can be used
+    bool            timerSupports(uint16_t speed);
+
     /// Set up the timer and its interrutps so the interrupt handler is called at the right frequency
     void            timerSetup();
 
@@ -337,20 +933,131 @@ protected:
     /// Write the txPin in a platform dependent way, taking into account whether it is inverted or not
     void            writePtt(bool value);
 
-    /// Translates a 6 bit symbol to its 4 bit plaintext equivalent
+    /// Translates a 6 bit symbol to its 4 bit plaintext equivalent, 
+    /// or 0xff if it is not a valid symbol
     uint8_t         symbol_6to4(uint8_t symbol);
 
-    /// The receiver handler function, called a 8 times the bit rate
-    void            receiveTimer();
+    /// Checks the last 16 received bits for the sync word, allowing RH_ASK_SYNC_ERRORS bit errors.
+    /// Counts matches with an error in _rxSyncErrors
+    /// \param[in] bits The last 16 bits received, the most recent in bit 15
+    /// \return true if the bits match the sync word
+    bool            syncMatch(uint16_t bits)
+    {
+	uint16_t errors = bits ^ _rxSyncWord;
+	if (errors == 0)
+	    return true;
+#if RH_ASK_SYNC_ERRORS
+	if ((errors & (errors - 1)) == 0) // Just one bit set
+	{
+	    _rxSyncErrors++;
+	    return true;
+	}
+#endif
+	return false;
+    }
+
+    /// Encodes an octet of the message into 2 symbols in the transmit queue, in the line code being sent
+    /// \param[in] p Where to put the symbols
+    /// \param[in] octet The octet to encode
+    /// \return Where to put the next symbols
+    uint8_t*        encodeOctet(uint8_t* p, uint8_t octet);
+
+    /// Decodes a received symbol to its 4 bit plaintext equivalent in the line code
+    /// \param[in] symbol The symbol, in the low bits
+    /// \return The 4 bits, or RH_ASK_INVALID_SYMBOL if it is not a valid symbol
+    uint8_t         decodeSymbol(uint16_t symbol);
+
+    /// The receiver handler function, called a 8 times the bit rate with a sample of the rxPin.
+    /// This is the PLL and integrator of the oversampling receive engine
+    /// \param[in] rxSample The level of the rxPin
+    void            receiveSample(bool rxSample);
+
+    /// The edge receive engine handler function, called on each change of the rxPin
+    /// \param[in] when The time of the edge in microseconds
+    /// \param[in] level The new level of the rxPin
+    void            receiveEdge(uint32_t when, bool level);
+
+    /// Decodes the bits of each bit period that has ended before a given time, for the edge receive engine
+    /// \param[in] when The time in microseconds
+    void            receiveEdgeBits(uint32_t when);
+
+    /// Called by available() when using the edge receive engine, to decode any bits
+    /// that have been completed since the last edge
+    void            receiveEdgeTimeout();
+
+    /// Updates the channel activity detector for a transition in the received signal
+    /// \param[in] onClock true if the transition was close to the recovered bit clock
+    void            receiveTransition(bool onClock);
+
+    /// Tells whether the channel activity detector thinks the channel is active
+    bool            channelActive();
+
+    /// Called by the timer interrupt handler in RHModeRx while a CSMA backoff is in progress.
+    /// Counts down the backoff while the channel is clear, and starts the transmitter at the end of it
+    void            csmaTimer();
+
+    /// Starts sending the transmit queue, after a CSMA backoff if enabled, unless it is already
+    /// being sent or a backoff is in progress
+    void            startTransmitter();
+
+    /// Common receiver handling for each bit recovered by either receive engine:
+    /// finds the start symbol, decodes symbols and assembles messages into the receive queue
+    void            receiveBit(bool bit);
+
+#if (RH_PLATFORM == RH_PLATFORM_UNIX)
+    /// Reads and decodes the samples waiting on the rx stream
+    void            receiveStream();
+
+    /// Writes the transmit queue to the tx stream
+    void            transmitStream();
+#endif
+
+    /// Enables or disables the timer interrupt, where supported. Used by the edge receive engine,
+    /// which only needs the timer when transmitting
+    void            timerEnable(bool enable);
 
     /// The transmitter handler function, called a 8 times the bit rate 
     void            transmitTimer();
 
-    /// Check whether the latest received message is complete and uncorrupted
-    /// We should always check the FCS at user level, not interrupt level
-    /// since it is slow
+    /// Check whether the oldest message in the receive queue is addressed to us
+    /// (and uncorrupted, if RH_ASK_USER_LEVEL_CRC is defined)
     void            validateRxBuf();
 
+#if RH_ASK_COMBINE_COPIES > 0
+    /// Try to recover a corrupted message by combining it with earlier corrupted copies,
+    /// and keep it for combining with later ones if that fails
+    /// \param[in,out] rxBuf The corrupted message. The recovered message is put here
+    /// \param[in] erasures Bitmap of the octets of rxBuf that contained invalid symbols
+    /// \param[in] len The length of the message
+    /// \return true if the message was recovered
+    bool            combineRxBuf(uint8_t* rxBuf, const uint8_t* erasures, uint8_t len);
+#endif
+
+#if RH_ASK_RATE_ADAPTATION
+    /// Handles a rate adaptation control message in the receive queue, and drops it
+    void            rateReceived();
+
+    /// Sends rate adaptation reports, and makes any speed change that is due. Called by available()
+    void            rateService();
+
+    /// Queues a rate adaptation control message, if there is room in the transmit queue
+    /// \param[in] type The message type
+    /// \param[in] index The index in _rateSpeeds the message is about
+    /// \param[in] fer For reports, the frame error rate in 1/256ths
+    /// \param[in] frames For reports, the number of messages the frame error rate was measured over
+    /// \return true if the message was queued
+    bool            rateSend(uint8_t type, uint8_t index, uint8_t fer = 0, uint8_t frames = 0);
+
+    /// Asks the other end to change to another speed, as soon as there is room in the transmit queue
+    /// \param[in] index The index in _rateSpeeds to change to
+    void            rateRequest(uint8_t index);
+
+    /// Changes to another speed in the ladder
+    /// \param[in] index The index in _rateSpeeds to change to
+    /// \param[in] agreed true if the change was agreed with the other end, and should be undone if nothing is heard soon
+    void            rateSwitch(uint8_t index, bool agreed);
+#endif
+
     /// Configure bit rate in bits per second
     uint16_t        _speed;
 
@@ -369,14 +1076,55 @@ protected:
     /// True of the sense of the pttPin is to be inverted
     bool            _pttInverted;
 
-    // Used in the interrupt handlers
-    /// Buf is filled but not validated
-    volatile bool   _rxBufFull;
+    /// The receive engine selected in the constructor
+    RxEngine        _rxEngine;
+
+    /// The line code messages are sent with
+    LineCode        _lineCode;
+
+    /// Nominal bit period in microseconds, used by the edge receive engine
+    uint16_t        _rxEdgePeriod;
+
+    /// Start time of the current bit period for the edge receive engine, in microseconds
+    volatile uint32_t _rxEdgeTime;
+
+    /// Time up to which _rxEdgeHigh has been measured, in microseconds
+    volatile uint32_t _rxEdgeLast;
+
+    /// Microseconds the rx pin has been high so far in the current bit period
+    volatile uint16_t _rxEdgeHigh;
+
+#if (RH_PLATFORM == RH_PLATFORM_UNIX)
+    /// Simulated level of the receiver data output, returned by readRx()
+    bool            _rxLevel;
+
+    /// Simulated level of the transmitter data input, set by writeTx()
+    bool            _txLevel;
+
+    /// File descriptor of the rx sample stream, or -1
+    int             _rxFd;
+
+    /// File descriptor of the tx sample stream, or -1
+    int             _txFd;
 
-    /// Buf is full and valid
+    /// Samples read from the rx stream
+    uint8_t         _rxStreamBuf[RH_ASK_STREAM_BUF_LEN];
+
+    /// Number of octets in _rxStreamBuf
+    uint16_t        _rxStreamLen;
+
+    /// Number of octets in _rxStreamBuf already decoded
+    uint16_t        _rxStreamPos;
+
+    /// The rx stream has reached end of file
+    bool            _rxStreamEnded;
+#endif
+
+    // Used in the interrupt handlers
+    /// The oldest message in the receive queue is valid and ready for recv()
     volatile bool   _rxBufValid;
 
-    /// Last digital input from the rx data pin
+    /// Last digital input from the rx data pin. For the edge receive engine, the level since the last edge
     volatile bool   _rxLastSample;
 
     /// This is the integrate and dump integral. If there are <5 0 samples in the PLL cycle
@@ -393,14 +1141,54 @@ protected:
     /// in the processes of reading and decoding it
     volatile uint8_t _rxActive;
 
-    /// Last 12 bits received, so we can look for the start symbol
+    /// Last 16 bits received, so we can look for the sync word. The most recent bit is bit 15
     volatile uint16_t _rxBits;
 
-    /// How many bits of message we have received. Ranges from 0 to 12
+    /// How many bits of message we have received. Ranges from 0 to _rxOctetBits
     volatile uint8_t _rxBitCount;
+
+    /// The sync word of the line code
+    uint16_t         _rxSyncWord;
+
+    /// The number of bits per octet in the line code
+    uint8_t          _rxOctetBits;
+
+    /// PN9 whitening sequence generator for the message being received, if LineCodeScrambled
+    uint16_t         _rxWhitening;
     
-    /// The incoming message buffer
-    uint8_t _rxBuf[RH_ASK_MAX_PAYLOAD_LEN];
+    /// The receive queue. The interrupt handler decodes into slot (_rxHead % RH_ASK_RX_QUEUE_LEN),
+    /// the application collects from slot (_rxTail % RH_ASK_RX_QUEUE_LEN)
+    uint8_t _rxBuf[RH_ASK_RX_QUEUE_LEN][RH_ASK_MAX_FRAME_LEN];
+
+    /// Length of each completed frame in the receive queue. More than the byte count if it
+    /// includes forward error correction parity
+    uint8_t _rxFrameLen[RH_ASK_RX_QUEUE_LEN];
+
+#if RH_DRIVER_STATS
+    /// statsClock() when each message in the receive queue was completed
+    uint32_t _rxDoneTime[RH_ASK_RX_QUEUE_LEN];
+#endif
+
+    /// Count of messages completed by the interrupt handler. Only written by the interrupt handler
+    volatile uint8_t _rxHead;
+
+    /// Count of messages collected or dropped by the application. Only written at user level
+    volatile uint8_t _rxTail;
+
+    /// Count of messages dropped because of an invalid symbol
+    volatile uint16_t _rxSymbolErrors;
+
+    /// Octet offset of the invalid symbol in the last message dropped because of it
+    volatile uint8_t  _rxSymbolErrorPosition;
+
+    /// True if messages for other nodes are to be dropped as soon as their TO header arrives
+    bool              _rxEarlyAddressFilter;
+
+    /// Count of messages dropped by early address rejection
+    volatile uint16_t _rxAddressDrops;
+
+    /// Count of messages started with a bit error in the sync word
+    volatile uint16_t _rxSyncErrors;
     
     /// The incoming message expected length
     volatile uint8_t _rxCount;
@@ -408,20 +1196,173 @@ protected:
     /// The incoming message buffer length received so far
     volatile uint8_t _rxBufLen;
 
+#ifndef RH_ASK_USER_LEVEL_CRC
+    /// The FCS of the incoming message so far, accumulated as each byte is decoded
+    volatile uint16_t _rxCrc;
+#endif
+
+    /// True if corrupted messages are to be combined
+    bool              _rxCombining;
+
+    /// Count of messages recovered by combining
+    uint16_t          _rxCombined;
+
+    /// Channel activity detector score: up for each transition on the recovered bit clock, down for others
+    volatile uint8_t  _rxCadScore;
+
+    /// Number of bit periods since the last transition on the recovered bit clock, up to 255
+    volatile uint8_t  _rxCadQuiet;
+
+    /// True if send() is to wait for a CSMA backoff before transmitting
+    bool              _csma;
+
+    /// Number of CSMA backoff slots still to wait before starting the transmitter, 0 if not waiting
+    volatile uint8_t  _txBackoff;
+
+    /// True if messages are to be sent with forward error correction parity
+    bool              _txFec;
+
+    /// Count of messages recovered by forward error correction
+    uint16_t          _rxFecCorrected;
+
+#if RH_ASK_ERASURES
+    /// True while the incoming message may be followed by forward error correction parity
+    volatile bool     _rxFecFrame;
+
+    /// Number of octets in the incoming message that contained invalid symbols
+    volatile uint8_t  _rxErasureCount;
+
+    /// Bitmap of the octets of each message in the receive queue that contained invalid symbols
+    uint8_t           _rxErasures[RH_ASK_RX_QUEUE_LEN][(RH_ASK_MAX_FRAME_LEN + 7) / 8];
+
+    /// True for each message in the receive queue that is corrupted, and only queued for 
+    /// forward error correction or combining
+    bool              _rxFrameBad[RH_ASK_RX_QUEUE_LEN];
+#endif
+
+#if RH_ASK_COMBINE_COPIES > 0
+    /// Earlier corrupted copies of a message, for combining
+    uint8_t           _rxCopies[RH_ASK_COMBINE_COPIES][RH_ASK_MAX_PAYLOAD_LEN];
+
+    /// Bitmap of the octets of each copy that contained invalid symbols
+    uint8_t           _rxCopyErasures[RH_ASK_COMBINE_COPIES][(RH_ASK_MAX_PAYLOAD_LEN + 7) / 8];
+
+    /// Number of valid copies in _rxCopies
+    uint8_t           _rxCopyCount;
+
+    /// Index in _rxCopies of the next copy to be replaced
+    uint8_t           _rxCopyNext;
+
+    /// Time of arrival of the most recent copy, in milliseconds
+    uint32_t          _rxCopyTime;
+#endif
+
+#if RH_ASK_RATE_ADAPTATION
+    /// The rate adaptation ladder of speeds, lowest first
+    uint16_t          _rateSpeeds[RH_ASK_RATE_MAX_SPEEDS];
+
+    /// Number of speeds in _rateSpeeds. 0 if rate adaptation is disabled
+    uint8_t           _rateNumSpeeds;
+
+    /// Index in _rateSpeeds of the current speed
+    uint8_t           _rateIndex;
+
+    /// Index in _rateSpeeds agreed with the other end, to change to when the transmit queue is empty,
+    /// or RH_ASK_RATE_NONE
+    uint8_t           _ratePending;
+
+    /// Index in _rateSpeeds this node has asked the other end to change to, or RH_ASK_RATE_NONE
+    uint8_t           _rateRequested;
+
+    /// Index in _rateSpeeds to go back to if nothing is heard soon after an agreed change, or RH_ASK_RATE_NONE
+    uint8_t           _rateRevert;
+
+    /// Type of the handshake message waiting for room in the transmit queue, or 0
+    uint8_t           _rateSendType;
+
+    /// Index in _rateSpeeds for the handshake message waiting to be sent
+    uint8_t           _rateSendIndex;
+
+    /// The node rate adaptation messages are sent to: the FROM header of the last message received
+    uint8_t           _ratePeer;
+
+    /// Number of good messages for the application received since the last report was sent
+    uint16_t          _rateRxData;
+
+    /// _rxBad when the last report was sent
+    uint16_t          _rateRxBad;
+
+    /// Number of reports in a row with frame error rates no more than RH_ASK_RATE_UP_FER
+    uint8_t           _rateCleanReports;
+
+    /// Number of clean reports needed before stepping up from each speed
+    uint8_t           _rateUpReports[RH_ASK_RATE_MAX_SPEEDS];
+
+    /// True from a step up until the first report at the new speed
+    bool              _rateProbing;
+
+    /// Frame error rate in the last report received
+    uint8_t           _rateFer;
+
+    /// Count of speed changes
+    uint16_t          _rateChanges;
+
+    /// Counts timer interrupts, to run the rate adaptation timers once per bit period
+    uint8_t           _rateTicks;
+
+    /// Bit periods until stepping down a speed, unless a good message is received
+    volatile uint16_t _rateTimeout;
+
+    /// Bit periods until a report is due, even if fewer than RH_ASK_RATE_REPORT_FRAMES messages have been received
+    volatile uint16_t _rateReportDue;
+#endif
+
     /// Index of the next symbol to send. Ranges from 0 to vw_tx_len
     uint8_t _txIndex;
 
+    /// Index in each slot of _txBuf of the first symbol to send. Skips the unwanted part of the preamble
+    uint8_t _txStart;
+
+    /// Number of bits in each symbol of _txBuf after the preamble, in the line code messages are sent with
+    uint8_t _txSymbolBits;
+
+    /// PN9 whitening sequence generator for the message being encoded, if LineCodeScrambled
+    uint16_t _txWhitening;
+
     /// Bit number of next bit to send
     uint8_t _txBit;
 
     /// Sample number for the transmitter. Runs 0 to 7 during one bit interval
     uint8_t _txSample;
 
-    /// The transmitter buffer in _symbols_ not data octets
-    uint8_t _txBuf[(RH_ASK_MAX_PAYLOAD_LEN * 2) + RH_ASK_PREAMBLE_LEN];
+    /// The transmit queue, in _symbols_ not data octets. The preamble is in 6 bit symbols,
+    /// the rest in _txSymbolBits symbols. The interrupt handler sends from slot 
+    /// (_txTail % RH_ASK_TX_QUEUE_LEN), send() encodes into slot (_txHead % RH_ASK_TX_QUEUE_LEN)
+    uint8_t _txBuf[RH_ASK_TX_QUEUE_LEN][(RH_ASK_MAX_FRAME_LEN * 2) + RH_ASK_PREAMBLE_LEN];
+
+    /// Number of symbols in each slot of _txBuf to be sent;
+    uint8_t _txBufLen[RH_ASK_TX_QUEUE_LEN];
+
+#if RH_DRIVER_STATS
+    /// statsClock() when send() queued each message in the transmit queue
+    uint32_t _txSendTime[RH_ASK_TX_QUEUE_LEN];
+#endif
+
+    /// Count of messages queued by send(). Only written at user level
+    volatile uint8_t _txHead;
+
+    /// Count of messages completely transmitted. Only written by the interrupt handler:
+    /// setModeIdle() leaves it alone, so messages it stops stay queued until startTransmitter()
+    volatile uint8_t _txTail;
+
+    /// Count of transmitted messages whose callbacks service() has called. Only written at user level
+    uint8_t _txServiced;
+
+    /// The sendAsync() callback of each message in the transmit queue, NULL if there is none
+    SendCallback _txCallback[RH_ASK_TX_QUEUE_LEN];
 
-    /// Number of symbols in _txBuf to be sent;
-    uint8_t _txBufLen;
+    /// The context for each _txCallback
+    void* _txContext[RH_ASK_TX_QUEUE_LEN];
 
 };
 
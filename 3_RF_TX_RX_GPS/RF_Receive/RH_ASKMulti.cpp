@@ -0,0 +1,276 @@
+// RH_ASKMulti.cpp
+//
+// Contributed to the RadioHead project
+
+#include "RH_ASKMulti.h"
+#include "RHCRC.h"
+
+#ifndef __SAMD51__
+
+// Timer ticks within which identical messages are duplicates
+#define RH_ASK_MULTI_DUPLICATE_TICKS (RH_ASK_MULTI_DUPLICATE_BITS * 8)
+
+RH_ASKMulti::RH_ASKMulti(uint16_t speed, const uint8_t* rxPins, uint8_t numRxPins, uint8_t txPin, uint8_t pttPin,
+			 bool pttInverted)
+    :
+    RH_ASK(speed, numRxPins ? rxPins[0] : 11, txPin, pttPin, pttInverted, RxEngineOversample),
+    _numChannels(numRxPins > RH_ASK_MULTI_CHANNELS ? RH_ASK_MULTI_CHANNELS : numRxPins),
+#if (RH_PLATFORM == RH_PLATFORM_UNIX)
+    _chLevels(0),
+#endif
+    _chLastSamples(0),
+    _chActive(0),
+    _chTicks(0),
+    _dupNext(0),
+    _rxDuplicates(0)
+{
+    for (uint8_t ch = 0; ch < RH_ASK_MULTI_CHANNELS; ch++)
+    {
+	_chPin[ch] = (ch < _numChannels) ? rxPins[ch] : 0;
+	_chIntegrator[ch] = 0;
+	_chPllRamp[ch] = 0;
+	_chBits[ch] = 0;
+	_chGood[ch] = 0;
+	_dupFcs[ch] = 0;
+	_dupTicks[ch] = 0 - (RH_ASK_MULTI_DUPLICATE_TICKS + 1); // Long ago
+    }
+}
+
+bool RH_ASKMulti::init()
+{
+    if (!RH_ASK::init())
+	return false;
+
+#if (RH_PLATFORM == RH_PLATFORM_ARDUINO)
+    for (uint8_t ch = 1; ch < _numChannels; ch++)
+	pinMode(_chPin[ch], INPUT);
+ #if defined(__AVR__)
+    for (uint8_t ch = 0; ch < _numChannels; ch++)
+    {
+	_chInputReg[ch] = portInputRegister(digitalPinToPort(_chPin[ch]));
+	_chInputMask[ch] = digitalPinToBitMask(_chPin[ch]);
+    }
+ #endif
+#endif
+    return true;
+}
+
+uint16_t RH_ASKMulti::rxChannelGood(uint8_t channel)
+{
+    return (channel < _numChannels) ? _chGood[channel] : 0;
+}
+
+uint16_t RH_ASKMulti::rxDuplicates()
+{
+    return _rxDuplicates;
+}
+
+// Read all the RX data input pins, taking into account platform type and inversion.
+uint8_t RH_INTERRUPT_ATTR RH_ASKMulti::readChannels()
+{
+    uint8_t samples = 0;
+#if (RH_PLATFORM == RH_PLATFORM_UNIX)
+    samples = _chLevels;
+#elif (RH_PLATFORM == RH_PLATFORM_ARDUINO) && defined(__AVR__)
+    // A few instructions per pin, instead of the several microseconds of digitalRead()
+    for (uint8_t ch = 0; ch < _numChannels; ch++)
+	if (*_chInputReg[ch] & _chInputMask[ch])
+	    samples |= 1 << ch;
+#elif (RH_PLATFORM == RH_PLATFORM_GENERIC_AVR8)
+    // Only the one RH_ASK_RX_PIN is configured. Read it directly: readRx() would also apply _rxInverted
+    if (RH_ASK_RX_PORT & (1<<RH_ASK_RX_PIN))
+	samples = 1;
+#else
+    for (uint8_t ch = 0; ch < _numChannels; ch++)
+	if (digitalRead(_chPin[ch]))
+	    samples |= 1 << ch;
+#endif
+    if (_rxInverted)
+	samples = ~samples;
+    return samples;
+}
+
+void RH_INTERRUPT_ATTR RH_ASKMulti::receiveChannels(uint8_t samples)
+{
+    // Same integrate and dump receiver and PLL as RH_ASK::receiveSample(), for each channel in turn
+    uint8_t transitions = samples ^ _chLastSamples;
+    _chLastSamples = samples;
+    uint8_t mask = 1;
+    for (uint8_t ch = 0; ch < _numChannels; ch++, mask <<= 1)
+    {
+	uint8_t ramp = _chPllRamp[ch];
+	if (samples & mask)
+	    _chIntegrator[ch]++;
+
+	if (transitions & mask)
+	{
+	    // Channel activity detection is done on the first channel only
+	    if (ch == 0)
+		receiveTransition(ramp < (RH_ASK_RAMP_INC * 2) || ramp >= (RH_ASK_RX_RAMP_LEN - RH_ASK_RAMP_INC));
+	    ramp += ((ramp < RH_ASK_RAMP_TRANSITION)
+		     ? RH_ASK_RAMP_INC_RETARD
+		     : RH_ASK_RAMP_INC_ADVANCE);
+	}
+	else
+	    ramp += RH_ASK_RAMP_INC;
+
+	if (ramp >= RH_ASK_RX_RAMP_LEN)
+	{
+	    // If < 5 out of 8 samples were high, then its declared a 0 bit, else a 1
+	    bool bit = _chIntegrator[ch] >= 5;
+	    ramp -= RH_ASK_RX_RAMP_LEN;
+	    _chIntegrator[ch] = 0;
+	    if (ch == 0 && _rxCadQuiet < 255)
+		_rxCadQuiet++;
+	    receiveChannelBit(ch, bit);
+	}
+	_chPllRamp[ch] = ramp;
+    }
+    // So channelActive() and the CSMA backoff see a message coming in on any channel
+    _rxActive = _chActive != 0;
+}
+
+void RH_INTERRUPT_ATTR RH_ASKMulti::receiveChannelBit(uint8_t ch, bool bit)
+{
+    // Same as RH_ASK::receiveBit(), but corrupted messages are always dropped
+    uint16_t bits = _chBits[ch] >> 1;
+    if (bit)
+	bits |= 0x8000;
+    _chBits[ch] = bits;
+
+    uint8_t mask = 1 << ch;
+    if (_chActive & mask)
+    {
+	if (++_chBitCount[ch] < 12)
+	    return;
+	_chBitCount[ch] = 0;
+
+	// Have 12 bits of encoded message == 1 byte encoded
+	uint8_t hi = symbol_6to4(bits >> 4);
+	uint8_t lo = symbol_6to4(bits >> 10);
+	uint8_t len = _chBufLen[ch];
+	if ((hi | lo) == RH_ASK_INVALID_SYMBOL)
+	{
+	    // Not a valid symbol, so the message is corrupted. Drop it now
+	    _chActive &= ~mask;
+	    _rxBad++;
+	    _rxSymbolErrors++;
+	    _rxSymbolErrorPosition = len;
+	    return;
+	}
+	uint8_t this_byte = (hi << 4) | lo;
+
+	if (len == 0)
+	{
+	    // The first byte is the byte count, including itself, the headers and the FCS
+	    _chCount[ch] = this_byte;
+	    if (this_byte < 7 || this_byte > RH_ASK_MAX_PAYLOAD_LEN)
+	    {
+		// Stupid message length, drop the whole thing
+		_chActive &= ~mask;
+		_rxBad++;
+		return;
+	    }
+	}
+	else if (len == 1
+		 && _rxEarlyAddressFilter
+		 && !_promiscuous
+		 && this_byte != _thisAddress
+		 && this_byte != RH_BROADCAST_ADDRESS)
+	{
+	    // The TO header says this message is for some other node
+	    _chActive &= ~mask;
+	    _rxAddressDrops++;
+	    _rxDropped++;
+	    return;
+	}
+	_chBuf[ch][len++] = this_byte;
+	_chBufLen[ch] = len;
+	_chCrc[ch] = RHcrc_ccitt_update(_chCrc[ch], this_byte);
+
+	if (len == _chCount[ch])
+	{
+	    // Got all the bytes up to the FCS now. Any FEC parity that follows is ignored
+	    _chActive &= ~mask;
+	    if (_chCrc[ch] != 0xf0b8) // CRC when buffer and expected CRC are CRC'd
+		_rxBad++;
+	    else
+		queueChannelBuf(ch);
+	}
+    }
+    // Not in a message, see if we have the sync word
+    else if (syncMatch(bits))
+    {
+	_chActive |= mask;
+	_chBitCount[ch] = 0;
+	_chBufLen[ch] = 0;
+	_chCrc[ch] = 0xffff;
+    }
+}
+
+void RH_INTERRUPT_ATTR RH_ASKMulti::queueChannelBuf(uint8_t ch)
+{
+    uint8_t len = _chBufLen[ch];
+    uint16_t fcs = _chBuf[ch][len - 2] | (_chBuf[ch][len - 1] << 8);
+    _chGood[ch]++;
+
+    // Another channel may have just received the same transmission.
+    // The FCS covers the whole message, so identical FCSs mean identical messages
+    for (uint8_t i = 0; i < RH_ASK_MULTI_CHANNELS; i++)
+    {
+	if (_dupFcs[i] == fcs && (_chTicks - _dupTicks[i]) <= RH_ASK_MULTI_DUPLICATE_TICKS)
+	{
+	    _rxDuplicates++;
+	    return;
+	}
+    }
+#if RH_DRIVER_STATS
+    statsRxAirtime((uint32_t)len * _rxOctetBits * 1000000UL / _speed);
+#endif
+    _dupFcs[_dupNext] = fcs;
+    _dupTicks[_dupNext] = _chTicks;
+    if (++_dupNext >= RH_ASK_MULTI_CHANNELS)
+	_dupNext = 0;
+
+    if ((uint8_t)(_rxHead - _rxTail) >= RH_ASK_RX_QUEUE_LEN)
+    {
+	// No free slot in the receive queue: the application is not
+	// collecting messages fast enough
+	_rxOverflow++;
+	return;
+    }
+    // Hand it over to the application in the usual receive queue.
+    // The FCS has been checked, so validateRxBuf() only needs to look at the headers
+    uint8_t slot = _rxHead & (RH_ASK_RX_QUEUE_LEN - 1);
+    memcpy(_rxBuf[slot], _chBuf[ch], len);
+    _rxFrameLen[slot] = len;
+#if RH_ASK_ERASURES
+    _rxFrameBad[slot] = false;
+#endif
+#if RH_DRIVER_STATS
+    _rxDoneTime[slot] = statsClock();
+#endif
+    _rxHead++;
+    notifyEvent();
+}
+
+void RH_INTERRUPT_ATTR RH_ASKMulti::handleTimerInterrupt()
+{
+    RH_ISR_STATS_START
+    _chTicks++;
+    if (_mode == RHModeRx)
+    {
+	receiveChannels(readChannels()); // Receiving
+	if (_txBackoff)
+	    csmaTimer(); // Waiting to transmit
+    }
+    else
+    {
+	_chActive = 0; // Cant hear anything while transmitting
+	if (_mode == RHModeTx)
+	    transmitTimer(); // Transmitting
+    }
+    RH_ISR_STATS_END(this)
+}
+
+#endif //_SAMD51__
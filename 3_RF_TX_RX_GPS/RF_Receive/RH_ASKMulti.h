@@ -0,0 +1,179 @@
+// RH_ASKMulti.h
+//
+// Contributed to the RadioHead project
+
+#ifndef RH_ASKMulti_h
+#define RH_ASKMulti_h
+
+#include "RH_ASK.h"
+
+/// The maximum number of receiver data pins that RH_ASKMulti can decode. No more than 8.
+/// Each channel costs about RH_ASK_MAX_PAYLOAD_LEN + 20 octets of SRAM.
+/// Can be pre-defined prior to including this header
+#ifndef RH_ASK_MULTI_CHANNELS
+ #if defined(__AVR__)
+  #define RH_ASK_MULTI_CHANNELS 2
+ #else
+  #define RH_ASK_MULTI_CHANNELS 4
+ #endif
+#endif
+#if (RH_ASK_MULTI_CHANNELS < 1) || (RH_ASK_MULTI_CHANNELS > 8)
+ #error RH_ASK_MULTI_CHANNELS must be 1 to 8
+#endif
+
+/// Identical messages completed on different channels within this many bit periods of each other
+/// are taken to be the same transmission, and only the first is queued
+#ifndef RH_ASK_MULTI_DUPLICATE_BITS
+ #define RH_ASK_MULTI_DUPLICATE_BITS 24
+#endif
+
+/////////////////////////////////////////////////////////////////////
+/// \class RH_ASKMulti RH_ASKMulti.h <RH_ASKMulti.h>
+/// \brief RH_ASK driver that receives from several ASK receivers at once, with one timer interrupt
+///
+/// Gateways often have several inexpensive ASK receivers, on different antennas for diversity, or on different
+/// frequencies. Each RH_ASK instance would need its own timer interrupt, and the platform code only supports one.
+/// RH_ASKMulti samples all the rxPins in the same timer interrupt, and runs the oversampling receiver
+/// (the software PLL, integrator, start symbol detector, symbol decoder and FCS) for each of them.
+/// The per channel receiver state is kept in arrays indexed by channel (struct of arrays), so each
+/// step of the receiver is done for all channels in turn, with little more overhead than for one.
+/// On AVR the pins are read directly from their port registers instead of with digitalRead().
+///
+/// Each message that passes the FCS is queued in the usual RH_ASK receive queue, and collected with
+/// available() and recv() in the usual way. When several receivers hear the same transmission, each
+/// completes an identical message at about the same time: only the first is queued and the rest are
+/// counted by rxDuplicates(). Identical messages that arrive more than RH_ASK_MULTI_DUPLICATE_BITS bit periods
+/// apart (eg when the application repeats messages) are separate transmissions and are all queued.
+/// rxChannelGood() tells how many messages each channel decoded, duplicates included, so you can see
+/// which receivers are doing the work.
+///
+/// Transmission is the same as RH_ASK, on the single txPin. isChannelActive() and setCsma() use the
+/// first rxPin. The edge receive engine, combining of corrupted messages and forward error correction
+/// are not supported by RH_ASKMulti: corrupted messages are dropped, although messages sent with
+/// forward error correction parity are received normally when they arrive intact. Only messages sent
+/// with the default LineCode4b6b are received.
+///
+/// \code
+/// uint8_t rxPins[] = { 11, 8, 9 };
+/// RH_ASKMulti driver(2000, rxPins, sizeof(rxPins));
+/// \endcode
+class RH_ASKMulti : public RH_ASK
+{
+public:
+    /// Constructor.
+    /// At present only one instance of RH_ASK or RH_ASKMulti per sketch is supported.
+    /// \param[in] speed The desired bit rate in bits per second
+    /// \param[in] rxPins The pins that are used to get data from each receiver. Copied by the constructor
+    /// \param[in] numRxPins The number of rxPins, up to RH_ASK_MULTI_CHANNELS. Extra pins are ignored
+    /// \param[in] txPin The pin that is used to send data to the transmitter
+    /// \param[in] pttPin The pin that is connected to the transmitter controller. It will be set HIGH to enable the transmitter (unless pttInverted is true).
+    /// \param[in] pttInverted true if you desire the pttin to be inverted so that LOW wil enable the transmitter.
+    RH_ASKMulti(uint16_t speed, const uint8_t* rxPins, uint8_t numRxPins, uint8_t txPin = 12, uint8_t pttPin = 10,
+		bool pttInverted = false);
+
+    /// Initialise the Driver transport hardware and software.
+    /// \return true if initialisation succeeded.
+    virtual bool    init();
+
+    /// dont call this it used by the interrupt handler
+    virtual void    handleTimerInterrupt();
+
+    /// Returns the number of receiver channels
+    /// \return The number of rxPins in use
+    uint8_t         channels() { return _numChannels; }
+
+    /// Returns the number of good messages decoded by a channel, including those dropped as duplicates
+    /// \param[in] channel The channel number, 0 to channels() - 1
+    /// \return The number of messages that passed the FCS on the channel
+    uint16_t        rxChannelGood(uint8_t channel);
+
+    /// Returns the number of good messages dropped because another channel had already received
+    /// the same transmission
+    /// \return The number of duplicates dropped
+    uint16_t        rxDuplicates();
+
+protected:
+    /// Reads all the rxPins, taking into account whether they are inverted or not
+    /// \return Bit n is the level of the rxPin of channel n
+    uint8_t         readChannels();
+
+    /// The receiver for all channels, called 8 times the bit rate with a sample of each rxPin.
+    /// Runs the PLL and integrator of each channel, and passes any completed bits to receiveChannelBit()
+    /// \param[in] samples Bit n is the level of the rxPin of channel n
+    void            receiveChannels(uint8_t samples);
+
+    /// Finds the start symbol, decodes symbols and assembles the messages for one channel
+    void            receiveChannelBit(uint8_t channel, bool bit);
+
+    /// Queues a good message completed by a channel, unless it is a duplicate
+    void            queueChannelBuf(uint8_t channel);
+
+    /// Number of channels in use
+    uint8_t         _numChannels;
+
+    /// The rxPin of each channel
+    uint8_t         _chPin[RH_ASK_MULTI_CHANNELS];
+
+#if (RH_PLATFORM == RH_PLATFORM_ARDUINO) && defined(__AVR__)
+    /// The input register of each rxPin, so they can be read without digitalRead()
+    volatile uint8_t* _chInputReg[RH_ASK_MULTI_CHANNELS];
+
+    /// The bit in _chInputReg of each rxPin
+    uint8_t         _chInputMask[RH_ASK_MULTI_CHANNELS];
+#endif
+
+#if (RH_PLATFORM == RH_PLATFORM_UNIX)
+    /// Simulated levels of the receiver data outputs, bit n for channel n, returned by readChannels()
+    uint8_t         _chLevels;
+#endif
+
+    /// Last sample from each channel, bit n for channel n
+    volatile uint8_t  _chLastSamples;
+
+    /// Channels that have seen the start symbol and are receiving a message, bit n for channel n
+    volatile uint8_t  _chActive;
+
+    /// Count of timer ticks, for recognising duplicates
+    volatile uint32_t _chTicks;
+
+    /// Integrate and dump integral of each channel
+    uint8_t           _chIntegrator[RH_ASK_MULTI_CHANNELS];
+
+    /// PLL ramp of each channel
+    uint8_t           _chPllRamp[RH_ASK_MULTI_CHANNELS];
+
+    /// Last 16 bits received on each channel
+    uint16_t          _chBits[RH_ASK_MULTI_CHANNELS];
+
+    /// How many bits of the current octet each channel has received
+    uint8_t           _chBitCount[RH_ASK_MULTI_CHANNELS];
+
+    /// The byte count of the message each channel is receiving
+    uint8_t           _chCount[RH_ASK_MULTI_CHANNELS];
+
+    /// Number of octets of the message each channel has received so far
+    uint8_t           _chBufLen[RH_ASK_MULTI_CHANNELS];
+
+    /// The FCS of the message each channel is receiving, so far
+    uint16_t          _chCrc[RH_ASK_MULTI_CHANNELS];
+
+    /// The message each channel is receiving
+    uint8_t           _chBuf[RH_ASK_MULTI_CHANNELS][RH_ASK_MAX_PAYLOAD_LEN];
+
+    /// Count of good messages from each channel
+    uint16_t          _chGood[RH_ASK_MULTI_CHANNELS];
+
+    /// The FCS of the most recent messages queued, for recognising duplicates
+    uint16_t          _dupFcs[RH_ASK_MULTI_CHANNELS];
+
+    /// When each of the _dupFcs messages was queued, in timer ticks
+    uint32_t          _dupTicks[RH_ASK_MULTI_CHANNELS];
+
+    /// Index in _dupFcs to be replaced next
+    uint8_t           _dupNext;
+
+    /// Count of duplicate messages dropped
+    volatile uint16_t _rxDuplicates;
+};
+
+#endif
@@ -0,0 +1,15 @@
+// RH_ASK_config.h
+// RH_ASK settings for the receiver sketch. See RH_ASK.h
+
+// Hold the repeated copies of each message that arrive while loop() is busy blinking the LED
+// and redrawing the LCD, so they are not lost, and so they can be combined.
+// Each slot costs about 82 octets of SRAM with forward error correction
+#define RH_ASK_RX_QUEUE_LEN 4
+
+#if defined(__AVR__)
+// The sketch combines the repeated copies of each message sent by the transmitter, and corrects
+// them with the forward error correction parity the transmitter adds.
+// Both are left out by default on AVR to save SRAM
+ #define RH_ASK_COMBINE_COPIES 2
+ #define RH_ASK_FEC 1
+#endif
@@ -126,6 +126,7 @@ bool RH_CC110::init()
 	attachInterrupt(interruptNumber, isr2, RISING);
     else
 	return false; // Too many devices, not enough interrupt vectors
+    _eventDriven = true; // handleInterrupt() wakes up the wait functions
 
     spiWriteRegister(RH_CC110_REG_02_IOCFG0, RH_CC110_GDO_CFG_CRC_OK_AUTORESET);  // gdo0 interrupt on CRC_OK
     spiWriteRegister(RH_CC110_REG_06_PKTLEN, RH_CC110_MAX_PAYLOAD_LEN); // max packet length
@@ -184,6 +185,7 @@ void RH_CC110::handleInterrupt()
 	if (_rxBufValid)
 	    setModeIdle(); // Done
     }
+    notifyEvent();
 }
 
 // These are low level functions that call the interrupt handler for the correct
@@ -192,17 +194,29 @@ void RH_CC110::handleInterrupt()
 void RH_INTERRUPT_ATTR RH_CC110::isr0()
 {
     if (_deviceForInterrupt[0])
+    {
+	RH_ISR_STATS_START
 	_deviceForInterrupt[0]->handleInterrupt();
+	RH_ISR_STATS_END(_deviceForInterrupt[0])
+    }
 }
 void RH_INTERRUPT_ATTR RH_CC110::isr1()
 {
     if (_deviceForInterrupt[1])
+    {
+	RH_ISR_STATS_START
 	_deviceForInterrupt[1]->handleInterrupt();
+	RH_ISR_STATS_END(_deviceForInterrupt[1])
+    }
 }
 void RH_INTERRUPT_ATTR RH_CC110::isr2()
 {
     if (_deviceForInterrupt[2])
+    {
+	RH_ISR_STATS_START
 	_deviceForInterrupt[2]->handleInterrupt();
+	RH_ISR_STATS_END(_deviceForInterrupt[2])
+    }
 }
 
 uint8_t RH_CC110::spiReadRegister(uint8_t reg)
@@ -261,6 +275,7 @@ void RH_CC110::validateRxBuf()
 	_rxHeaderTo == RH_BROADCAST_ADDRESS)
     {
 	_rxGood++;
+	statsRxDone();
 	_rxBufValid = true;
     }
 }
@@ -297,6 +312,7 @@ bool RH_CC110::recv(uint8_t* buf, uint8_t* len)
 	memcpy(buf, _buf + RH_CC110_HEADER_LEN, *len);
 	ATOMIC_BLOCK_END;
     }
+    statsRecv();
     clearRxBuf(); // This message accepted and cleared
 
     return true;
@@ -322,6 +338,7 @@ bool RH_CC110::send(const uint8_t* data, uint8_t len)
 
     // Radio returns to Idle when TX is finished
     // need waitPacketSent() to detect change of _mode and TX completion
+    statsTxStart();
     setModeTx();
 
     return true;
@@ -389,6 +406,8 @@ bool RH_CC110::waitPacketSent()
 	YIELD;
 
     _mode = RHModeIdle;
+    _txGood++;
+    statsTxDone(); // No interrupt at the end of transmission, so as late as this
     return true;
 }
 
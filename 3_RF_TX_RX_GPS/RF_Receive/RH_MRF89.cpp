@@ -110,6 +110,8 @@ bool RH_MRF89::init()
 	attachInterrupt(interruptNumber, isr2, RISING);
     else
 	return false; // Too many devices, not enough interrupt vectors
+    _eventDriven = true; // handleInterrupt() wakes up the wait functions
+    _asyncSend = true; // and sees the end of each transmission
 
     // When used with the MRF89XAM9A module, per 75017B.pdf section 1.3, need:
     // crystal freq = 12.8MHz
@@ -199,6 +201,7 @@ void RH_MRF89::handleInterrupt()
 	// TXDONE
 	// Transmit is complete
 	_txGood++;
+	statsTxDone();
 	setModeIdle();
     }
     else if (_mode == RHModeRx)
@@ -233,6 +236,7 @@ void RH_MRF89::handleInterrupt()
 	if (_rxBufValid)
 	    setModeIdle(); // Got one 
     }
+    notifyEvent();
 }
 
 // These are low level functions that call the interrupt handler for the correct
@@ -241,17 +245,29 @@ void RH_MRF89::handleInterrupt()
 void RH_INTERRUPT_ATTR RH_MRF89::isr0()
 {
     if (_deviceForInterrupt[0])
+    {
+	RH_ISR_STATS_START
 	_deviceForInterrupt[0]->handleInterrupt();
+	RH_ISR_STATS_END(_deviceForInterrupt[0])
+    }
 }
 void RH_INTERRUPT_ATTR RH_MRF89::isr1()
 {
     if (_deviceForInterrupt[1])
+    {
+	RH_ISR_STATS_START
 	_deviceForInterrupt[1]->handleInterrupt();
+	RH_ISR_STATS_END(_deviceForInterrupt[1])
+    }
 }
 void RH_INTERRUPT_ATTR RH_MRF89::isr2()
 {
     if (_deviceForInterrupt[2])
+    {
+	RH_ISR_STATS_START
 	_deviceForInterrupt[2]->handleInterrupt();
+	RH_ISR_STATS_END(_deviceForInterrupt[2])
+    }
 }
 
 uint8_t RH_MRF89::spiReadRegister(uint8_t reg)
@@ -383,6 +399,7 @@ bool RH_MRF89::recv(uint8_t* buf, uint8_t* len)
 	memcpy(buf, _buf + RH_MRF89_HEADER_LEN, *len);
 	ATOMIC_BLOCK_END;
     }
+    statsRecv();
     clearRxBuf(); // This message accepted and cleared
 
     return true;
@@ -407,6 +424,7 @@ bool RH_MRF89::send(const uint8_t* data, uint8_t len)
     spiWriteData(_txHeaderId);
     spiWriteData(_txHeaderFlags);
     spiWriteData(data, len);
+    statsTxStart();
     setModeTx(); // Start transmitting
 
     return true;
@@ -432,6 +450,7 @@ void RH_MRF89::validateRxBuf()
 	_rxHeaderTo == RH_BROADCAST_ADDRESS)
     {
 	_rxGood++;
+	statsRxDone();
 	_rxBufValid = true;
     }
 }
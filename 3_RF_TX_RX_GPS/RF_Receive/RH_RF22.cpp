@@ -140,6 +140,8 @@ bool RH_RF22::init()
 	attachInterrupt(interruptNumber, isr2, FALLING);
     else
 	return false; // Too many devices, not enough interrupt vectors
+    _eventDriven = true; // handleInterrupt() wakes up the wait functions
+    _asyncSend = true; // and sees the end of each transmission
 
     setModeIdle();
 
@@ -254,6 +256,7 @@ void RH_RF22::handleInterrupt()
     {
 //	Serial.println("IPKSENT");   
 	_txGood++; 
+	statsTxDone();
 	// Transmission does not automatically clear the tx buffer.
 	// Could retransmit if we wanted
 	// RH_RF22 transitions automatically to Idle
@@ -283,6 +286,7 @@ void RH_RF22::handleInterrupt()
 	_rxHeaderId = spiRead(RH_RF22_REG_49_RECEIVED_HEADER1);
 	_rxHeaderFlags = spiRead(RH_RF22_REG_4A_RECEIVED_HEADER0);
 	_rxGood++;
+	statsRxDone();
 	_bufLen = len;
 	_mode = RHModeIdle;
 	_rxBufValid = true;
@@ -304,6 +308,7 @@ void RH_RF22::handleInterrupt()
 	resetRxFifo();
 	clearRxBuf();
     }
+    notifyEvent();
 }
 
 // These are low level functions that call the interrupt handler for the correct
@@ -312,17 +317,29 @@ void RH_RF22::handleInterrupt()
 void RH_INTERRUPT_ATTR RH_RF22::isr0()
 {
     if (_deviceForInterrupt[0])
+    {
+	RH_ISR_STATS_START
 	_deviceForInterrupt[0]->handleInterrupt();
+	RH_ISR_STATS_END(_deviceForInterrupt[0])
+    }
 }
 void RH_INTERRUPT_ATTR RH_RF22::isr1()
 {
     if (_deviceForInterrupt[1])
+    {
+	RH_ISR_STATS_START
 	_deviceForInterrupt[1]->handleInterrupt();
+	RH_ISR_STATS_END(_deviceForInterrupt[1])
+    }
 }
 void RH_INTERRUPT_ATTR RH_RF22::isr2()
 {
     if (_deviceForInterrupt[2])
+    {
+	RH_ISR_STATS_START
 	_deviceForInterrupt[2]->handleInterrupt();
+	RH_ISR_STATS_END(_deviceForInterrupt[2])
+    }
 }
 
 void RH_RF22::reset()
@@ -565,6 +582,7 @@ bool RH_RF22::recv(uint8_t* buf, uint8_t* len)
 	memcpy(buf, _buf, *len);
 	ATOMIC_BLOCK_END;
     }
+    statsRecv();
     clearRxBuf();
 //    printBuffer("recv:", buf, *len);
     return true;
@@ -582,6 +600,7 @@ void RH_RF22::startTransmit()
 {
     sendNextFragment(); // Actually the first fragment
     spiWrite(RH_RF22_REG_3E_PACKET_LENGTH, _bufLen); // Total length that will be sent
+    statsTxStart();
     setModeTx(); // Start the transmitter, turns off the receiver
 }
 
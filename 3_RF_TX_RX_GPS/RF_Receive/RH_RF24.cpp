@@ -107,6 +107,8 @@ bool RH_RF24::init()
 	attachInterrupt(interruptNumber, isr2, FALLING);
     else
 	return false; // Too many devices, not enough interrupt vectors
+    _eventDriven = true; // handleInterrupt() wakes up the wait functions
+    _asyncSend = true; // and sees the end of each transmission
 
     // Ensure we get the interrupts we need, irrespective of whats in the radio_config
     uint8_t int_ctl[] = {RH_RF24_MODEM_INT_STATUS_EN | RH_RF24_PH_INT_STATUS_EN, 0xff, 0xff, 0x00 };
@@ -193,6 +195,7 @@ void RH_RF24::handleInterrupt()
 	if (status[2] & RH_RF24_INT_STATUS_PACKET_SENT)
 	{
 	    _txGood++; 
+	    statsTxDone();
 	    // Transmission does not automatically clear the tx buffer.
 	    // Could retransmit if we wanted
 	    // RH_RF24 configured to transition automatically to Idle after packet sent
@@ -226,6 +229,7 @@ void RH_RF24::handleInterrupt()
 	    readNextFragment();
 	}
     }
+    notifyEvent();
 }
 
 // Check whether the latest received message is complete and uncorrupted
@@ -244,6 +248,7 @@ void RH_RF24::validateRxBuf()
 	{
 	    // Its for us
 	    _rxGood++;
+	    statsRxDone();
 	    _rxBufValid = true;
 	}
     }
@@ -268,17 +273,29 @@ void RH_RF24::clearBuffer()
 void RH_INTERRUPT_ATTR RH_RF24::isr0()
 {
     if (_deviceForInterrupt[0])
+    {
+	RH_ISR_STATS_START
 	_deviceForInterrupt[0]->handleInterrupt();
+	RH_ISR_STATS_END(_deviceForInterrupt[0])
+    }
 }
 void RH_INTERRUPT_ATTR RH_RF24::isr1()
 {
     if (_deviceForInterrupt[1])
+    {
+	RH_ISR_STATS_START
 	_deviceForInterrupt[1]->handleInterrupt();
+	RH_ISR_STATS_END(_deviceForInterrupt[1])
+    }
 }
 void RH_INTERRUPT_ATTR RH_RF24::isr2()
 {
     if (_deviceForInterrupt[2])
+    {
+	RH_ISR_STATS_START
 	_deviceForInterrupt[2]->handleInterrupt();
+	RH_ISR_STATS_END(_deviceForInterrupt[2])
+    }
 }
 
 bool RH_RF24::available()
@@ -303,6 +320,7 @@ bool RH_RF24::recv(uint8_t* buf, uint8_t* len)
 	memcpy(buf, _buf + RH_RF24_HEADER_LEN, *len);
 	ATOMIC_BLOCK_END;
     }
+    statsRecv();
     clearBuffer(); // Got the most recent message
     return true;
 }
@@ -338,6 +356,7 @@ bool RH_RF24::send(const uint8_t* data, uint8_t len)
     set_properties(RH_RF24_PROPERTY_PKT_FIELD_2_LENGTH_7_0, l, sizeof(l));
 
     sendNextFragment();
+    statsTxStart();
     setModeTx();
     return true;
 }
@@ -149,6 +149,8 @@ bool RH_RF69::init()
 	attachInterrupt(interruptNumber, isr2, RISING);
     else
 	return false; // Too many devices, not enough interrupt vectors
+    _eventDriven = true; // handleInterrupt() wakes up the wait functions
+    _asyncSend = true; // and sees the end of each transmission
 
     setModeIdle();
 
@@ -206,6 +208,7 @@ void RH_RF69::handleInterrupt()
 	// A transmitter message has been fully sent
 	setModeIdle(); // Clears FIFO
 	_txGood++;
+	statsTxDone();
 //	Serial.println("PACKETSENT");
     }
     // Must look for PAYLOADREADY, not CRCOK, since only PAYLOADREADY occurs _after_ AES decryption
@@ -221,6 +224,7 @@ void RH_RF69::handleInterrupt()
 	readFifo();
 //	Serial.println("PAYLOADREADY");
     }
+    notifyEvent();
 }
 
 // Low level function reads the FIFO and checks the address
@@ -251,6 +255,7 @@ void RH_RF69::readFifo()
 	    for (_bufLen = 0; _bufLen < (payloadlen - RH_RF69_HEADER_LEN); _bufLen++)
 		_buf[_bufLen] = _spi.transfer(0);
 	    _rxGood++;
+	    statsRxDone();
 	    _rxBufValid = true;
 	}
     }
@@ -266,17 +271,29 @@ void RH_RF69::readFifo()
 void RH_INTERRUPT_ATTR RH_RF69::isr0()
 {
     if (_deviceForInterrupt[0])
+    {
+	RH_ISR_STATS_START
 	_deviceForInterrupt[0]->handleInterrupt();
+	RH_ISR_STATS_END(_deviceForInterrupt[0])
+    }
 }
 void RH_INTERRUPT_ATTR RH_RF69::isr1()
 {
     if (_deviceForInterrupt[1])
+    {
+	RH_ISR_STATS_START
 	_deviceForInterrupt[1]->handleInterrupt();
+	RH_ISR_STATS_END(_deviceForInterrupt[1])
+    }
 }
 void RH_INTERRUPT_ATTR RH_RF69::isr2()
 {
     if (_deviceForInterrupt[2])
+    {
+	RH_ISR_STATS_START
 	_deviceForInterrupt[2]->handleInterrupt();
+	RH_ISR_STATS_END(_deviceForInterrupt[2])
+    }
 }
 
 int8_t RH_RF69::temperatureRead()
@@ -505,6 +522,7 @@ bool RH_RF69::recv(uint8_t* buf, uint8_t* len)
 	memcpy(buf, _buf, *len);
 	ATOMIC_BLOCK_END;
     }
+    statsRecv();
     _rxBufValid = false; // Got the most recent message
 //    printBuffer("recv:", buf, *len);
     return true;
@@ -536,6 +554,7 @@ bool RH_RF69::send(const uint8_t* data, uint8_t len)
     digitalWrite(_slaveSelectPin, HIGH);
     ATOMIC_BLOCK_END;
 
+    statsTxStart();
     setModeTx(); // Start the transmitter
     return true;
 }
@@ -664,6 +664,19 @@ public:
     /// \return true if a valid message was copied to buf
     virtual bool    recv(uint8_t* buf, uint8_t* len);
 
+    /// Returns a pointer to the received message in the driver's buffer, without copying it.
+    /// The receiver is kept in idle mode until release(), so messages arriving in the meantime are not received.
+    /// See RHGenericDriver::recvView()
+    /// \param[out] buf Set to point to the message
+    /// \param[out] len Set to the length of the message
+    /// \param[in] copy Not used
+    /// \param[in] copyLen Not used
+    /// \return true if there was a valid message
+    virtual bool    recvView(const uint8_t** buf, uint8_t* len, uint8_t* copy = NULL, uint8_t copyLen = 0);
+
+    /// Frees the driver's buffer after recvView(), so the receiver can be started again
+    virtual void    release();
+
     /// Waits until any previous transmit packet is finished being transmitted with waitPacketSent().
     /// Then optionally waits for Channel Activity Detection (CAD) 
     /// to show the channnel is clear (if the radio supports CAD) by calling waitCAD().
@@ -185,6 +185,19 @@ public:
     /// \return true if a valid message was copied to buf
     virtual bool recv(uint8_t* buf, uint8_t* len);
 
+    /// Returns a pointer to the received message in the driver's buffer, without copying it.
+    /// No more characters are read from the serial port until release().
+    /// See RHGenericDriver::recvView()
+    /// \param[out] buf Set to point to the message
+    /// \param[out] len Set to the length of the message
+    /// \param[in] copy Not used
+    /// \param[in] copyLen Not used
+    /// \return true if there was a valid message
+    virtual bool recvView(const uint8_t** buf, uint8_t* len, uint8_t* copy = NULL, uint8_t copyLen = 0);
+
+    /// Frees the driver's buffer after recvView(), so the next message can be received
+    virtual void release();
+
     /// Waits until any previous transmit packet is finished being transmitted with waitPacketSent().
     /// Then loads a message into the transmitter and starts the transmitter. Note that a message length
     /// of 0 is NOT permitted. 
@@ -227,7 +240,7 @@ protected:
     void  validateRxBuf();
 
     /// Sends a single data octet to the serial port.
-    /// Implements DLE stuffing and keeps track of the senders FCS
+    /// Implements DLE stuffing
     void  txData(uint8_t ch);
 
     /// Reference to the HardwareSerial port we will use
@@ -236,7 +249,7 @@ protected:
     /// The current state of the Rx state machine
     RxState         _rxState;
 
-    /// Progressive FCS calc (CCITT CRC-16 covering all received data (but not stuffed DLEs), plus trailing DLE, ETX)
+    /// FCS calculated when the message is complete (CCITT CRC-16 covering all received data (but not stuffed DLEs), plus trailing DLE, ETX)
     uint16_t        _rxFcs;
 
     /// The received FCS at the end of the current message
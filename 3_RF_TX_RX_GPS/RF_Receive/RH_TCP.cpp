@@ -194,7 +194,8 @@ bool RH_TCP::available()
 {
     if (_socket < 0)
 	return false;
-    checkForEvents();
+    if (!_rxView)
+	checkForEvents(); // Would overwrite _rxBuf while recvView() has lent it out
     if (_rxBufFull)
     {
 	validateRxBuf();
@@ -248,10 +249,31 @@ bool RH_TCP::recv(uint8_t* buf, uint8_t* len)
 	    *len = _rxBufLen;
 	memcpy(buf, _rxBuf, *len);
     }
+    _rxView = false;
     clearRxBuf();
     return true;
 }
 
+bool RH_TCP::recvView(const uint8_t** buf, uint8_t* len, uint8_t* copy, uint8_t copyLen)
+{
+    (void)copy; // _rxBuf can always be lent out
+    (void)copyLen;
+    if (!available())
+	return false;
+    *buf = _rxBuf;
+    *len = _rxBufLen;
+    _rxView = true; // available() leaves the socket alone until release()
+    return true;
+}
+
+void RH_TCP::release()
+{
+    if (!_rxView)
+	return;
+    _rxView = false;
+    clearRxBuf();
+}
+
 bool RH_TCP::send(const uint8_t* data, uint8_t len)
 {
     if (!waitCAD()) 
@@ -262,6 +284,17 @@ bool RH_TCP::send(const uint8_t* data, uint8_t len)
     return ret;
 }
 
+bool RH_TCP::sendAsync(const uint8_t* data, uint8_t len, SendCallback callback, void* context)
+{
+    sendAsyncFinish();
+    if (!waitCAD() || !sendPacket(data, len))
+	return false;
+    // The simulator has it now
+    _sendCallback = callback;
+    _sendContext = context;
+    return true;
+}
+
 uint8_t RH_TCP::maxMessageLength()
 {
     return RH_TCP_MAX_MESSAGE_LEN;
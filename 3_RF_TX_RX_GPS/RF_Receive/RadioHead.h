@@ -163,6 +163,10 @@ Addressed, unreliable variable length messages, with optional broadcast faciliti
 - RHReliableDatagram
 Addressed, reliable, retransmitted, acknowledged variable length messages.
 
+- RHFragmentedDatagram
+Addressed transfers of up to 65535 octets, split into fragments and reassembled, with only the
+lost fragments retransmitted.
+
 - RHRouter
 Multi-hop delivery of RHReliableDatagrams from source node to destination node via 0 or more
 intermediate nodes, with manual, pre-programmed routing.
@@ -1351,6 +1355,8 @@ these examples and explanations and extend them to suit your needs.
  // Simulate the sketch on Linux and OSX
  #include <RHutil/simulator.h>
  #define RH_HAVE_SERIAL
+ #define PROGMEM
+ #define memcpy_P memcpy
 #include <netinet/in.h> // For htons and friends
 
 #else
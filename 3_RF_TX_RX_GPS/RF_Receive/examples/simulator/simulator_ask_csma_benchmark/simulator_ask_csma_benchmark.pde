@@ -0,0 +1,194 @@
+// simulator_ask_csma_benchmark.pde
+// -*- mode: C++ -*-
+// Simulates a number of RH_ASK nodes sharing one channel, each sending messages at random
+// times to a single receiver, and reports the delivered messages per second with and without
+// CSMA (setCsma()). Each timer tick of every node is simulated in turn. The channel is the OR of the
+// transmitter outputs, like ASK transmitters on the same frequency, and is random noise when no
+// transmitter is on, like the output of a typical ASK receiver.
+// Also reports how well the channel activity detector of the receiver agrees with the
+// actual state of the channel.
+// Tested on Linux
+// Build with
+// cd whatever/RadioHead
+// tools/simBuild examples/simulator/simulator_ask_csma_benchmark/simulator_ask_csma_benchmark.pde
+// Run with ./simulator_ask_csma_benchmark
+
+#include <RH_ASK.h>
+#include <math.h>
+
+#define SPEED 2000
+#define SECONDS 120        // Simulated time for each run
+#define MESSAGE_LEN 20     // Like a GPS position
+#define INTERVAL_MS 2000   // Mean time between messages from each node
+#define MAX_NODES 16
+
+#define TICKS_PER_SEC (SPEED * 8)
+
+// Gives the benchmark access to the simulated pins and the channel activity detector
+class SimASK : public RH_ASK
+{
+public:
+    SimASK() : RH_ASK(SPEED) {}
+    void tick(bool level) { _rxLevel = level; handleTimerInterrupt(); }
+    bool txLevel() { return _mode == RHModeTx && _txLevel; }
+    bool transmitting() { return _mode == RHModeTx; }
+    bool active() { return channelActive(); }
+};
+
+typedef struct
+{
+    double offered;      // Messages per second passed to send()
+    double delivered;    // Distinct messages per second received correctly
+    double falseBusy;    // Fraction of idle time the receiver thought the channel was active
+    double missedBusy;   // Fraction of busy time the receiver thought the channel was clear
+} Result;
+
+static void makePayload(uint8_t node, uint16_t seq, uint8_t* buf)
+{
+    buf[0] = node;
+    buf[1] = seq >> 8;
+    buf[2] = seq & 0xff;
+    for (uint8_t i = 3; i < MESSAGE_LEN; i++)
+	buf[i] = node + (seq * 7) + i;
+}
+
+// Ticks until the next message from a node, exponentially distributed
+static unsigned long nextArrival()
+{
+    double u = (random() + 1.0) / (RAND_MAX + 2.0);
+    return -log(u) * INTERVAL_MS * TICKS_PER_SEC / 1000;
+}
+
+static Result run(uint8_t numNodes, bool csma)
+{
+    SimASK nodes[MAX_NODES];
+    static uint16_t seqs[MAX_NODES];
+    static unsigned long arrivals[MAX_NODES];
+    static bool seen[MAX_NODES][65536 / 8];
+    SimASK receiver;
+    Result r = {};
+    unsigned long offered = 0, delivered = 0;
+    unsigned long idleTicks = 0, busyTicks = 0, falseBusy = 0, missedBusy = 0;
+    uint8_t buf[RH_ASK_MAX_MESSAGE_LEN];
+    uint8_t expected[MESSAGE_LEN];
+    uint8_t len;
+
+    srandom(1);
+    memset(seen, 0, sizeof(seen));
+    for (uint8_t n = 0; n < numNodes; n++)
+    {
+	nodes[n].init();
+	nodes[n].setCsma(csma);
+	nodes[n].setModeRx();
+	seqs[n] = 0;
+	arrivals[n] = nextArrival();
+    }
+    receiver.init();
+    receiver.setModeRx();
+
+    bool noise = false;
+    unsigned long noiseRun = 0;
+    for (unsigned long t = 0; t < (unsigned long)SECONDS * TICKS_PER_SEC; t++)
+    {
+	// The channel
+	bool busy = false, level = false;
+	for (uint8_t n = 0; n < numNodes; n++)
+	{
+	    busy |= nodes[n].transmitting();
+	    level |= nodes[n].txLevel();
+	}
+	if (!noiseRun--)
+	{
+	    noise = random() & 1;
+	    noiseRun = random() % 16;
+	}
+	if (!busy)
+	    level = noise;
+
+	// How does the receiver's channel activity detector compare?
+	if (busy)
+	{
+	    busyTicks++;
+	    if (!receiver.active())
+		missedBusy++;
+	}
+	else
+	{
+	    idleTicks++;
+	    if (receiver.active())
+		falseBusy++;
+	}
+
+	for (uint8_t n = 0; n < numNodes; n++)
+	    nodes[n].tick(level);
+	receiver.tick(level);
+
+	// The application on each node
+	if ((t & 7) == 0)
+	{
+	    for (uint8_t n = 0; n < numNodes; n++)
+	    {
+		// Keep the receiver running, for CSMA, and discard what it hears
+		len = sizeof(buf);
+		while (nodes[n].recv(buf, &len))
+		    len = sizeof(buf);
+		if (t >= arrivals[n])
+		{
+		    // Send only if it would not block
+		    if (nodes[n].txQueueSpace())
+		    {
+			makePayload(n, seqs[n]++, buf);
+			nodes[n].send(buf, MESSAGE_LEN);
+			offered++;
+		    }
+		    arrivals[n] = t + nextArrival();
+		}
+	    }
+	    len = sizeof(buf);
+	    while (receiver.recv(buf, &len))
+	    {
+		uint8_t n = buf[0];
+		uint16_t seq = (buf[1] << 8) | buf[2];
+		if (len == MESSAGE_LEN && n < numNodes)
+		{
+		    makePayload(n, seq, expected);
+		    if (memcmp(buf, expected, len) == 0 && !(seen[n][seq >> 3] & (1 << (seq & 7))))
+		    {
+			seen[n][seq >> 3] |= 1 << (seq & 7);
+			delivered++;
+		    }
+		}
+		len = sizeof(buf);
+	    }
+	}
+    }
+    r.offered = (double)offered / SECONDS;
+    r.delivered = (double)delivered / SECONDS;
+    r.falseBusy = idleTicks ? (double)falseBusy / idleTicks : 0;
+    r.missedBusy = busyTicks ? (double)missedBusy / busyTicks : 0;
+    return r;
+}
+
+void setup()
+{
+    static const uint8_t nodeCounts[] = { 1, 2, 4, 8, 16 };
+
+    printf("RH_ASK shared channel, %d octet messages at %d bps, each node sends one every %d ms on average, %d s per run\n",
+	   MESSAGE_LEN, SPEED, INTERVAL_MS, SECONDS);
+    printf("nodes  offered/s  delivered/s (no CSMA)  delivered/s (CSMA)  CAD false busy  CAD missed busy\n");
+    for (uint8_t i = 0; i < sizeof(nodeCounts); i++)
+    {
+	Result plain = run(nodeCounts[i], false);
+	Result csma = run(nodeCounts[i], true);
+	printf("%5d  %9.2f  %10.2f (%5.1f%%)  %10.2f (%5.1f%%)  %13.2f%%  %14.2f%%\n",
+	       nodeCounts[i], plain.offered,
+	       plain.delivered, plain.offered ? 100 * plain.delivered / plain.offered : 0,
+	       csma.delivered, csma.offered ? 100 * csma.delivered / csma.offered : 0,
+	       100 * csma.falseBusy, 100 * csma.missedBusy);
+    }
+    exit(0);
+}
+
+void loop()
+{
+}
@@ -0,0 +1,333 @@
+// simulator_ask_edge_benchmark.pde
+// -*- mode: C++ -*-
+// Compares the RH_ASK receive engines (RxEngineOversample and RxEngineEdge) on identical
+// edge timelines, reporting messages received, interrupts per second of airtime
+// and host CPU time for each.
+// With no arguments, the timelines are synthesised: the output of an RH_ASK transmitter
+// sending MESSAGES messages, with noise between messages like a typical ASK receiver,
+// passed through a channel with increasing amounts of edge jitter and short glitches.
+// Edge times are rounded to 4 microseconds, the resolution of micros() on a 16MHz AVR.
+// With a file name argument, replays the recorded edge timeline in the file instead. The file
+// has one edge per line: the time in microseconds and the new level (0 or 1), eg "10250 1"
+// Tested on Linux
+// Build with
+// cd whatever/RadioHead
+// tools/simBuild examples/simulator/simulator_ask_edge_benchmark/simulator_ask_edge_benchmark.pde
+// Run with ./simulator_ask_edge_benchmark [timeline-file]
+
+#include <RH_ASK.h>
+
+#define SPEED 2000
+#define MESSAGES 200
+#define MESSAGE_LEN 24
+#define GAP_BITS 40      // Noise between messages, in bit periods
+#define RESOLUTION 4     // Edge time resolution in microseconds
+#define GLITCH_MIN 10    // Glitch widths in microseconds
+#define GLITCH_MAX 150
+
+// Gives the benchmark access to the simulated pin levels and the receive engines
+class BenchASK : public RH_ASK
+{
+public:
+    BenchASK(RxEngine rxEngine) : RH_ASK(SPEED, 11, 12, 10, false, rxEngine) {}
+    void tick(bool level) { _rxLevel = level; handleTimerInterrupt(); }
+    void edge(uint32_t when, bool level) { _rxLevel = level; receiveEdge(when, level); }
+    bool txLevel() { return _txLevel; }
+    uint16_t symbolErrors() { return _rxSymbolErrors; }
+    // Time only advances with the timeline here, so dont let available()
+    // apply the edge engine timeout against the real clock
+    bool available()
+    {
+	while (!_rxBufValid && _rxTail != _rxHead)
+	{
+	    validateRxBuf();
+	    if (!_rxBufValid)
+		_rxTail++;
+	}
+	return _rxBufValid;
+    }
+};
+
+typedef struct
+{
+    uint32_t when;   // Microseconds
+    uint8_t  level;  // Level after the edge
+} Edge;
+
+#include "../simulator_samples.h"
+// samples is the transmitter output, one level per timer tick (8 per bit)
+
+// The timeline as seen by the receiver
+static Edge*         edges;
+static unsigned long numEdges;
+static unsigned long maxEdges;
+
+// The same timeline sampled at each timer tick, for the oversampling engine
+static uint8_t*      rxTicks;
+static unsigned long numRxTicks;
+
+static const double  tickUs = 1000000.0 / SPEED / 8;
+
+static double uniform(double from, double to)
+{
+    return from + (to - from) * (random() / (RAND_MAX + 1.0));
+}
+
+// Adds an edge, rounded to RESOLUTION. A pulse that rounds to nothing disappears
+static void addEdge(double when, uint8_t level)
+{
+    uint32_t t = ((uint32_t)(when / RESOLUTION)) * RESOLUTION;
+    if (numEdges && edges[numEdges - 1].level == level)
+	return;
+    if (numEdges && edges[numEdges - 1].when >= t)
+    {
+	numEdges--; // Cancels the previous edge
+	return;
+    }
+    if (numEdges >= maxEdges)
+    {
+	maxEdges = maxEdges ? maxEdges * 2 : 65536;
+	edges = (Edge*)realloc(edges, maxEdges * sizeof(Edge));
+    }
+    edges[numEdges].when = t;
+    edges[numEdges].level = level;
+    numEdges++;
+}
+
+// Random noise, like an ASK receiver outputs when there is no signal
+static void addNoiseTicks(unsigned long ticks)
+{
+    while (ticks)
+    {
+	unsigned long run = random(1, 17);
+	uint8_t level = random(2);
+	for (; run && ticks; run--, ticks--)
+	    addSample(level);
+    }
+}
+
+// Record the transmitter output for all the messages
+static void makeTxTicks()
+{
+    BenchASK tx(RH_ASK::RxEngineOversample);
+    tx.init();
+    uint8_t buf[MESSAGE_LEN];
+    srandom(1);
+    addNoiseTicks(GAP_BITS * 8);
+    for (uint16_t seq = 0; seq < MESSAGES; seq++)
+    {
+	makePayload(seq, buf);
+	tx.send(buf, sizeof(buf));
+	while (tx.mode() == RHGenericDriver::RHModeTx)
+	{
+	    tx.tick(false);
+	    addSample(tx.txLevel());
+	}
+	addNoiseTicks(GAP_BITS * 8);
+    }
+}
+
+// Pass the transmitter output through the channel to make the receiver timeline
+// The edges are jittered, and glitches of random width arrive at random times
+static void makeTimeline(double jitterUs, double glitchesPerSec)
+{
+    numEdges = 0;
+    srandom(2);
+    double end = numSamples * tickUs;
+    double nextGlitch = glitchesPerSec ? uniform(0, 2e6 / glitchesPerSec) : end;
+    double glitchEnd = -1;
+    uint8_t level = 0;   // Transmitter level
+    bool glitch = false; // Currently inverted by a glitch
+    double last = 0;
+    for (unsigned long k = 1; k <= numSamples; k++)
+    {
+	double t = (k < numSamples) ? k * tickUs + uniform(-jitterUs, jitterUs) : end;
+	if (t < last)
+	    t = last;
+	// Glitch edges before this tick
+	while (true)
+	{
+	    double g = glitch ? glitchEnd : nextGlitch;
+	    if (g >= t || g >= end)
+		break;
+	    if (g > last)
+		last = g;
+	    glitch = !glitch;
+	    if (glitch)
+		glitchEnd = g + uniform(GLITCH_MIN, GLITCH_MAX);
+	    else
+		nextGlitch = g + uniform(0, 2e6 / glitchesPerSec);
+	    addEdge(g, level ^ glitch);
+	}
+	if (k < numSamples && samples[k] != level)
+	{
+	    level = samples[k];
+	    last = t;
+	    addEdge(t, level ^ glitch);
+	}
+    }
+}
+
+// Sample the timeline at each timer tick for the oversampling engine
+static void makeRxTicks()
+{
+    uint32_t end = numEdges ? edges[numEdges - 1].when + (uint32_t)(GAP_BITS * 8 * tickUs) : 0;
+    numRxTicks = end / tickUs;
+    rxTicks = (uint8_t*)realloc(rxTicks, numRxTicks ? numRxTicks : 1);
+    unsigned long e = 0;
+    uint8_t level = 0;
+    for (unsigned long k = 0; k < numRxTicks; k++)
+    {
+	while (e < numEdges && edges[e].when <= k * tickUs)
+	    level = edges[e++].level;
+	rxTicks[k] = level;
+    }
+}
+
+typedef struct
+{
+    unsigned long received;
+    unsigned long correct;
+    unsigned long interrupts;
+    uint16_t      bad;
+    uint16_t      symbolErrors;
+    double        ns;
+} Result;
+
+static void collect(BenchASK& rx, Result& r, bool* seen)
+{
+    uint8_t buf[RH_ASK_MAX_MESSAGE_LEN];
+    uint8_t len = sizeof(buf);
+    uint8_t expected[MESSAGE_LEN];
+    while (rx.recv(buf, &len))
+    {
+	r.received++;
+	uint16_t seq = (buf[0] << 8) | buf[1];
+	makePayload(seq, expected);
+	if (len == MESSAGE_LEN && seq < MESSAGES && !seen[seq] && memcmp(buf, expected, len) == 0)
+	{
+	    seen[seq] = true;
+	    r.correct++;
+	}
+	len = sizeof(buf);
+    }
+}
+
+static Result runOversample()
+{
+    Result r = {};
+    bool seen[MESSAGES] = {false};
+    BenchASK rx(RH_ASK::RxEngineOversample);
+    rx.init();
+    rx.setModeRx();
+    double t = nowNs();
+    for (unsigned long k = 0; k < numRxTicks; k++)
+    {
+	rx.tick(rxTicks[k]);
+	if (rx.rxQueueDepth())
+	    collect(rx, r, seen);
+    }
+    r.ns = nowNs() - t;
+    r.interrupts = numRxTicks;
+    r.bad = rx.rxBad();
+    r.symbolErrors = rx.symbolErrors();
+    return r;
+}
+
+static Result runEdge()
+{
+    Result r = {};
+    bool seen[MESSAGES] = {false};
+    BenchASK rx(RH_ASK::RxEngineEdge);
+    rx.init();
+    rx.setModeRx();
+    double t = nowNs();
+    for (unsigned long e = 0; e < numEdges; e++)
+    {
+	rx.edge(edges[e].when, edges[e].level);
+	if (rx.rxQueueDepth())
+	    collect(rx, r, seen);
+    }
+    // Final edge after the trailing gap, so the last run is decoded
+    if (numEdges)
+	rx.edge(edges[numEdges - 1].when + (uint32_t)(GAP_BITS * 8 * tickUs), !edges[numEdges - 1].level);
+    collect(rx, r, seen);
+    r.ns = nowNs() - t;
+    r.interrupts = numEdges;
+    r.bad = rx.rxBad();
+    r.symbolErrors = rx.symbolErrors();
+    return r;
+}
+
+static void report(const char* name, Result& r, bool known)
+{
+    double airSecs = numRxTicks * tickUs / 1e6;
+    printf("  %-10s received %4lu", name, r.received);
+    if (known)
+	printf(" correct %4lu/%d FER %5.3f", r.correct, MESSAGES, 1.0 - (double)r.correct / MESSAGES);
+    printf(" bad %4u (symbol %4u) %7.0f irq/s %6.1f ns/irq %7.1f us cpu per s of air\n",
+	   r.bad, r.symbolErrors, r.interrupts / airSecs, r.ns / (r.interrupts ? r.interrupts : 1), r.ns / 1e3 / airSecs);
+}
+
+static void compare(bool known)
+{
+    makeRxTicks();
+    Result o = runOversample();
+    Result e = runEdge();
+    report("oversample", o, known);
+    report("edge", e, known);
+}
+
+static bool readTimeline(const char* filename)
+{
+    FILE* f = fopen(filename, "r");
+    if (!f)
+	return false;
+    unsigned long when;
+    unsigned int level;
+    numEdges = 0;
+    while (fscanf(f, "%lu %u", &when, &level) == 2)
+	addEdge(when, level ? 1 : 0);
+    fclose(f);
+    return true;
+}
+
+void setup()
+{
+    if (_simulator_argc >= 2)
+    {
+	if (!readTimeline(_simulator_argv[1]))
+	{
+	    printf("Cannot read %s\n", _simulator_argv[1]);
+	    exit(1);
+	}
+	printf("RH_ASK receive engines, %lu edges from %s at %d bps\n", numEdges, _simulator_argv[1], SPEED);
+	compare(false);
+	exit(0);
+    }
+
+    static const struct { double jitterUs; double glitchesPerSec; } channels[] =
+    {
+	{ 0,   0 },
+	{ 50,  0 },
+	{ 100, 0 },
+	{ 150, 0 },
+	{ 0,   20 },
+	{ 0,   100 },
+	{ 50,  50 },
+    };
+    makeTxTicks();
+    printf("RH_ASK receive engines, %d messages of %d octets at %d bps, bit period %d us\n",
+	   MESSAGES, MESSAGE_LEN, SPEED, 1000000 / SPEED);
+    for (uint8_t i = 0; i < sizeof(channels) / sizeof(channels[0]); i++)
+    {
+	makeTimeline(channels[i].jitterUs, channels[i].glitchesPerSec);
+	printf("jitter +-%.0f us, %.0f glitches/s (%lu edges)\n", channels[i].jitterUs, channels[i].glitchesPerSec, numEdges);
+	compare(true);
+    }
+    exit(0);
+}
+
+void loop()
+{
+}
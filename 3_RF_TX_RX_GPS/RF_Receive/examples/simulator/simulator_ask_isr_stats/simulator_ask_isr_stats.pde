@@ -0,0 +1,110 @@
+// simulator_ask_isr_stats.pde
+// -*- mode: C++ -*-
+// Reports the interrupt handler timing stats (isrStats()) of RH_ASK transmitting, RH_ASK receiving
+// and RH_ASKMulti receiving on all its channels, so you can see how much of the CPU each
+// takes at a given bit rate, and how fast they could go.
+// The handlers are called once per simulated timer tick, with the transmitter output fed
+// straight to the receivers. On Linux the times are in ns, and include the time to read the clock.
+// The max times and overruns on Linux are mostly the process being descheduled mid handler.
+// load is the fraction of the CPU the handler takes at SPEED, and max bps the bit rate at which
+// it would take all of the CPU.
+// Tested on Linux
+// Build with
+// cd whatever/RadioHead
+// CPPFLAGS=-DRH_ISR_STATS=1 tools/simBuild examples/simulator/simulator_ask_isr_stats/simulator_ask_isr_stats.pde
+// Run with ./simulator_ask_isr_stats
+
+#include <RH_ASKMulti.h>
+
+#if !RH_ISR_STATS
+ #error Build with CPPFLAGS=-DRH_ISR_STATS=1 to enable the interrupt handler stats
+#endif
+
+#define SPEED 2000
+#define MESSAGES 200
+#define MESSAGE_LEN 20   // Like a GPS position
+#define GAP_TICKS 800    // 50ms at 2000bps, as in RF_Transmit
+
+static const uint8_t rxPins[RH_ASK_MULTI_CHANNELS] = { 0 }; // No pins in the simulator
+
+// Drive the drivers one timer tick at a time
+class SimASK : public RH_ASK
+{
+public:
+    SimASK() : RH_ASK(SPEED) {}
+    bool tick(bool level) { _rxLevel = level; handleTimerInterrupt(); return _txLevel; }
+};
+
+class SimASKMulti : public RH_ASKMulti
+{
+public:
+    SimASKMulti() : RH_ASKMulti(SPEED, rxPins, RH_ASK_MULTI_CHANNELS) {}
+    void tick(bool level) { _chLevels = level ? 0xff : 0; handleTimerInterrupt(); }
+};
+
+static void report(const char* name, RHGenericDriver& driver)
+{
+    RHGenericDriver::IsrStats stats;
+    driver.isrStats(&stats);
+    // The handler runs 8 times per bit
+    double load = stats.mean * 8.0 * SPEED / RH_ISR_CLOCK_HZ;
+    printf("%-22s %8u %6u %6u %6u %8u %5.2f%% %8.0f ", name, stats.count, stats.min, stats.mean,
+	   stats.max, stats.overruns, load * 100, stats.mean ? (double)RH_ISR_CLOCK_HZ / 8 / stats.mean : 0);
+    for (uint8_t i = 0; i < RH_ISR_STATS_BUCKETS; i++)
+	printf(" %7u", stats.histogram[i]);
+    printf("\n");
+}
+
+void setup()
+{
+    SimASK tx, rx;
+    SimASKMulti multi;
+    tx.init();
+    rx.init();
+    multi.init();
+    rx.available(); // Start receiving
+    multi.available();
+
+    uint8_t buf[RH_ASK_MAX_MESSAGE_LEN];
+    uint8_t len;
+    unsigned long received = 0, multiReceived = 0;
+    for (uint16_t seq = 0; seq < MESSAGES; seq++)
+    {
+	memset(buf, seq, MESSAGE_LEN);
+	tx.send(buf, MESSAGE_LEN);
+	for (uint32_t ticks = 0; tx.mode() == RHGenericDriver::RHModeTx || ticks < GAP_TICKS; ticks++)
+	{
+	    bool level = tx.tick(false);
+	    rx.tick(level);
+	    multi.tick(level);
+	}
+	len = sizeof(buf);
+	while (rx.recv(buf, &len))
+	{
+	    received++;
+	    len = sizeof(buf);
+	}
+	len = sizeof(buf);
+	while (multi.recv(buf, &len))
+	{
+	    multiReceived++;
+	    len = sizeof(buf);
+	}
+    }
+
+    printf("Interrupt handler times in 1/%lu s, %d messages of %d octets at %d bps (budget %lu per tick)\n",
+	   (unsigned long)RH_ISR_CLOCK_HZ, MESSAGES, MESSAGE_LEN, SPEED, (unsigned long)RH_ISR_CLOCK_HZ / 8 / SPEED);
+    printf("Received %lu by RH_ASK, %lu by RH_ASKMulti\n", received, multiReceived);
+    printf("%-22s %8s %6s %6s %6s %8s %6s %8s  histogram (< 64 << n)\n",
+	   "handler", "calls", "min", "mean", "max", "overruns", "load", "max bps");
+    report("RH_ASK transmit", tx);
+    report("RH_ASK receive", rx);
+    char name[32];
+    snprintf(name, sizeof(name), "RH_ASKMulti receive x%d", RH_ASK_MULTI_CHANNELS);
+    report(name, multi);
+    exit(0);
+}
+
+void loop()
+{
+}
@@ -0,0 +1,163 @@
+// simulator_ask_linecode_benchmark.pde
+// -*- mode: C++ -*-
+// Measures the goodput of each RH_ASK line code over a simulated channel.
+// MESSAGES messages are sent with each line code, with random noise between them, so the receiver PLL
+// is at an arbitrary phase when each preamble starts. The channel then inverts each bit period
+// with the given probability, or runs the transmitter clock fast by the given amount.
+// The report shows the fraction of messages delivered and the goodput: user data delivered
+// per second of airtime, counting a gap of GAP_BITS bits after each message.
+// Tested on Linux
+// Build with
+// cd whatever/RadioHead
+// tools/simBuild examples/simulator/simulator_ask_linecode_benchmark/simulator_ask_linecode_benchmark.pde
+// Run with ./simulator_ask_linecode_benchmark
+
+#include <RH_ASK.h>
+
+#define SPEED 2000
+#define MESSAGES 1000
+#define MESSAGE_LEN 20   // Like a GPS position
+#define GAP_BITS 100     // 50ms at 2000bps, as in RF_Transmit
+
+typedef struct
+{
+    const char*      name;
+    RH_ASK::LineCode lineCode;
+} Code;
+
+static const Code codes[] =
+{
+    { "4b6b",       RH_ASK::LineCode4b6b },
+    { "manchester", RH_ASK::LineCodeManchester },
+    { "scrambled",  RH_ASK::LineCodeScrambled },
+};
+#define NUM_CODES (sizeof(codes) / sizeof(codes[0]))
+
+typedef struct
+{
+    double ber;        // Probability of inverting each bit period
+    double clockError; // Transmitter bit rate error, as a fraction
+} Channel;
+
+static const Channel channels[] =
+{
+    { 0,     0 },
+    { 0.001, 0 },
+    { 0.003, 0 },
+    { 0.01,  0 },
+    { 0,     0.02 },
+    { 0,     0.04 },
+    { 0,     0.06 },
+};
+#define NUM_CHANNELS (sizeof(channels) / sizeof(channels[0]))
+
+#include "../simulator_samples.h"
+// samples is the transmitter output, one octet per sample
+
+// Record the transmitter output for all the messages, with noise between them
+static void transmit(const Code& code)
+{
+    RH_ASK tx(SPEED, 11, 12, 10, false, RH_ASK::RxEngineOversample, code.lineCode);
+    tx.init();
+    numSamples = 0;
+    srandom(1);
+    uint8_t buf[MESSAGE_LEN];
+    uint8_t octets[64];
+    for (uint16_t seq = 0; seq < MESSAGES; seq++)
+    {
+	// Noise, a random number of samples long: the receiver sees a new level every few samples
+	uint16_t gap = GAP_BITS * 8 + (random() % 8);
+	uint8_t level = 0;
+	for (uint16_t i = 0; i < gap; i++)
+	{
+	    if ((random() % 3) == 0)
+		level = random() & 1;
+	    addSample(level);
+	}
+	makePayload(seq, buf);
+	tx.send(buf, sizeof(buf));
+	while (tx.mode() == RHGenericDriver::RHModeTx)
+	{
+	    uint32_t len = tx.transmitSamples(octets, sizeof(octets));
+	    for (uint32_t i = 0; i < len; i++)
+		for (uint8_t bit = 0; bit < 8; bit++)
+		    addSample((octets[i] >> bit) & 1);
+	}
+    }
+}
+
+typedef struct
+{
+    unsigned long delivered; // Distinct correct messages
+    double        goodput;   // Bits of user data per second of airtime
+} Result;
+
+// Pass the transmitter output through the channel to the receiver
+static Result receive(const Code& code, const Channel& channel)
+{
+    Result r = {};
+    bool seen[MESSAGES] = {false};
+    RH_ASK rx(SPEED, 11, 12, 10, false, RH_ASK::RxEngineOversample, code.lineCode);
+    rx.init();
+    uint8_t buf[RH_ASK_MAX_MESSAGE_LEN];
+    uint8_t expected[MESSAGE_LEN];
+    uint8_t len;
+    srandom(100);
+    long threshold = channel.ber * RAND_MAX;
+    // A fast transmitter clock means the receiver sees fewer samples per bit
+    unsigned long rxSamples = numSamples / (1 + channel.clockError);
+    for (unsigned long i = 0; i + 8 <= rxSamples; i += 8)
+    {
+	uint8_t octet = 0;
+	for (uint8_t bit = 0; bit < 8; bit++)
+	    octet |= samples[(unsigned long)((i + bit) * (1 + channel.clockError))] << bit;
+	if (random() < threshold)
+	    octet = ~octet;
+	rx.receiveSamples(&octet, 1);
+	len = sizeof(buf);
+	while (rx.recv(buf, &len))
+	{
+	    uint16_t seq = (buf[0] << 8) | buf[1];
+	    makePayload(seq, expected);
+	    if (len == MESSAGE_LEN && seq < MESSAGES && !seen[seq] && memcmp(buf, expected, len) == 0)
+	    {
+		seen[seq] = true;
+		r.delivered++;
+	    }
+	    len = sizeof(buf);
+	}
+    }
+    r.goodput = r.delivered * MESSAGE_LEN * 8.0 / ((double)rxSamples / 8 / SPEED);
+    return r;
+}
+
+void setup()
+{
+    static Result results[NUM_CODES][NUM_CHANNELS];
+    for (uint8_t c = 0; c < NUM_CODES; c++)
+    {
+	transmit(codes[c]);
+	for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++)
+	    results[c][ch] = receive(codes[c], channels[ch]);
+    }
+
+    printf("RH_ASK line codes, %d messages of %d octets at %d bps, %d bits of noise between messages\n",
+	   MESSAGES, MESSAGE_LEN, SPEED, GAP_BITS);
+    printf("Delivered fraction / goodput in bps\n");
+    printf("%-8s %-11s", "BER", "clock err");
+    for (uint8_t c = 0; c < NUM_CODES; c++)
+	printf(" %14s", codes[c].name);
+    printf("\n");
+    for (uint8_t ch = 0; ch < NUM_CHANNELS; ch++)
+    {
+	printf("%-8.3f %-11.3f", channels[ch].ber, channels[ch].clockError);
+	for (uint8_t c = 0; c < NUM_CODES; c++)
+	    printf("   %5.3f / %4.0f", (double)results[c][ch].delivered / MESSAGES, results[c][ch].goodput);
+	printf("\n");
+    }
+    exit(0);
+}
+
+void loop()
+{
+}
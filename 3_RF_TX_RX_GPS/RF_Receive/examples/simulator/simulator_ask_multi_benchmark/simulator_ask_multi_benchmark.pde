@@ -0,0 +1,214 @@
+// simulator_ask_multi_benchmark.pde
+// -*- mode: C++ -*-
+// Measures receive diversity with RH_ASKMulti, and the cost of its timer interrupt.
+// MESSAGES messages from one transmitter are received by up to RH_ASK_MULTI_CHANNELS receivers,
+// each of which independently inverts each bit period with the given probability.
+// The report shows the fraction of messages delivered with 1, 2 ... receivers, and the duplicates
+// dropped. Then it times the timer interrupt of one RH_ASKMulti decoding all the channels,
+// against a separate RH_ASK timer interrupt for each channel.
+// Tested on Linux
+// Build with
+// cd whatever/RadioHead
+// tools/simBuild examples/simulator/simulator_ask_multi_benchmark/simulator_ask_multi_benchmark.pde
+// Run with ./simulator_ask_multi_benchmark
+
+#include <RH_ASKMulti.h>
+
+#define SPEED 2000
+#define MESSAGES 500
+#define MESSAGE_LEN 20   // Like a GPS position
+#define GAP_BITS 100     // 50ms at 2000bps, as in RF_Transmit
+
+static const double bers[] = { 0, 0.003, 0.01, 0.02, 0.03 };
+#define NUM_BERS (sizeof(bers) / sizeof(bers[0]))
+
+static const uint8_t rxPins[RH_ASK_MULTI_CHANNELS] = { 0 }; // No pins in the simulator
+
+// Drive the receivers one timer tick at a time
+class SimASKMulti : public RH_ASKMulti
+{
+public:
+    SimASKMulti(uint8_t channels) : RH_ASKMulti(SPEED, rxPins, channels) {}
+    void tick(uint8_t levels) { _chLevels = levels; handleTimerInterrupt(); }
+};
+
+class SimASK : public RH_ASK
+{
+public:
+    SimASK() : RH_ASK(SPEED) {}
+    void tick(bool level) { _rxLevel = level; handleTimerInterrupt(); }
+};
+
+#include "../simulator_samples.h"
+// samples is the transmitter output, one octet of 8 samples per bit period
+
+// The samples at each receiver
+static uint8_t*      rxSamples[RH_ASK_MULTI_CHANNELS];
+
+static void transmit()
+{
+    RH_ASK tx(SPEED);
+    tx.init();
+    numSamples = 0;
+    uint8_t buf[MESSAGE_LEN];
+    for (uint16_t seq = 0; seq < MESSAGES; seq++)
+    {
+	makePayload(seq, buf);
+	tx.send(buf, sizeof(buf));
+	while (tx.mode() == RHGenericDriver::RHModeTx)
+	    numSamples += tx.transmitSamples(reserveSamples(256), 256);
+	memset(reserveSamples(GAP_BITS), 0, GAP_BITS);
+	numSamples += GAP_BITS;
+    }
+}
+
+// Invert each bit period with probability ber, independently at each receiver
+static void addErrors(double ber)
+{
+    long threshold = ber * RAND_MAX;
+    for (uint8_t ch = 0; ch < RH_ASK_MULTI_CHANNELS; ch++)
+    {
+	srandom(ch + 1);
+	for (unsigned long i = 0; i < numSamples; i++)
+	    rxSamples[ch][i] = (random() < threshold) ? ~samples[i] : samples[i];
+    }
+}
+
+// The 8 timer ticks of bit period i, as levels for each channel
+static void channelLevels(unsigned long i, uint8_t channels, uint8_t* levels)
+{
+    memset(levels, 0, 8);
+    for (uint8_t ch = 0; ch < channels; ch++)
+	for (uint8_t bit = 0; bit < 8; bit++)
+	    if (rxSamples[ch][i] & (1 << bit))
+		levels[bit] |= 1 << ch;
+}
+
+typedef struct
+{
+    unsigned long delivered;  // Distinct correct messages
+    uint16_t      duplicates; // Dropped by RH_ASKMulti
+} Result;
+
+static Result receive(uint8_t channels)
+{
+    Result r = {};
+    bool seen[MESSAGES] = {false};
+    SimASKMulti rx(channels);
+    rx.init();
+    rx.setModeRx();
+    uint8_t buf[RH_ASK_MAX_MESSAGE_LEN];
+    uint8_t expected[MESSAGE_LEN];
+    uint8_t levels[8];
+    uint8_t len;
+    for (unsigned long i = 0; i < numSamples; i++)
+    {
+	channelLevels(i, channels, levels);
+	for (uint8_t bit = 0; bit < 8; bit++)
+	    rx.tick(levels[bit]);
+	len = sizeof(buf);
+	while (rx.recv(buf, &len))
+	{
+	    uint16_t seq = (buf[0] << 8) | buf[1];
+	    makePayload(seq, expected);
+	    if (len == MESSAGE_LEN && seq < MESSAGES && !seen[seq] && memcmp(buf, expected, len) == 0)
+	    {
+		seen[seq] = true;
+		r.delivered++;
+	    }
+	    len = sizeof(buf);
+	}
+    }
+    r.duplicates = rx.rxDuplicates();
+    return r;
+}
+
+// Keep the receive queue empty, so nothing is dropped
+static void drain(RH_ASK& rx)
+{
+    uint8_t buf[RH_ASK_MAX_MESSAGE_LEN];
+    uint8_t len = sizeof(buf);
+    while (rx.recv(buf, &len))
+	len = sizeof(buf);
+}
+
+// ns per timer tick, decoding all channels with one RH_ASKMulti
+static double timeMulti(uint8_t channels)
+{
+    SimASKMulti rx(channels);
+    rx.init();
+    rx.setModeRx();
+    uint8_t levels[8];
+    double ns = 0;
+    for (unsigned long i = 0; i < numSamples; i++)
+    {
+	channelLevels(i, channels, levels);
+	double start = nowNs();
+	for (uint8_t bit = 0; bit < 8; bit++)
+	    rx.tick(levels[bit]);
+	ns += nowNs() - start;
+	drain(rx);
+    }
+    return ns / (numSamples * 8);
+}
+
+// ns per timer tick, decoding each channel with its own RH_ASK
+static double timeSeparate(uint8_t channels)
+{
+    SimASK rx[RH_ASK_MULTI_CHANNELS];
+    for (uint8_t ch = 0; ch < channels; ch++)
+    {
+	rx[ch].init();
+	rx[ch].setModeRx();
+    }
+    uint8_t levels[8];
+    double ns = 0;
+    for (unsigned long i = 0; i < numSamples; i++)
+    {
+	channelLevels(i, channels, levels);
+	double start = nowNs();
+	for (uint8_t bit = 0; bit < 8; bit++)
+	    for (uint8_t ch = 0; ch < channels; ch++)
+		rx[ch].tick(levels[bit] & (1 << ch));
+	ns += nowNs() - start;
+	for (uint8_t ch = 0; ch < channels; ch++)
+	    drain(rx[ch]);
+    }
+    return ns / (numSamples * 8);
+}
+
+void setup()
+{
+    transmit();
+    for (uint8_t ch = 0; ch < RH_ASK_MULTI_CHANNELS; ch++)
+	rxSamples[ch] = (uint8_t*)malloc(numSamples);
+
+    printf("RH_ASKMulti diversity, %d messages of %d octets at %d bps, independent errors at each receiver\n",
+	   MESSAGES, MESSAGE_LEN, SPEED);
+    printf("Delivered fraction (duplicates dropped)\n");
+    printf("%-8s", "BER");
+    for (uint8_t channels = 1; channels <= RH_ASK_MULTI_CHANNELS; channels++)
+	printf("   %d receivers   ", channels);
+    printf("\n");
+    for (uint8_t b = 0; b < NUM_BERS; b++)
+    {
+	addErrors(bers[b]);
+	printf("%-8.3f", bers[b]);
+	for (uint8_t channels = 1; channels <= RH_ASK_MULTI_CHANNELS; channels++)
+	{
+	    Result r = receive(channels);
+	    printf("   %5.3f (%4u)  ", (double)r.delivered / MESSAGES, r.duplicates);
+	}
+	printf("\n");
+    }
+
+    addErrors(0.01);
+    printf("Timer interrupt, ns per tick: one RH_ASKMulti / separate RH_ASK per receiver\n");
+    for (uint8_t channels = 1; channels <= RH_ASK_MULTI_CHANNELS; channels++)
+	printf("%d receivers: %6.1f / %6.1f\n", channels, timeMulti(channels), timeSeparate(channels));
+    exit(0);
+}
+
+void loop()
+{
+}
@@ -0,0 +1,144 @@
+// simulator_ask_preamble_benchmark.pde
+// -*- mode: C++ -*-
+// Measures how often RH_ASK acquires messages sent with each preamble length (setPreambleLength()),
+// and the resulting goodput, over a range of bit error rates.
+// Like a real ASK receiver, the channel carries random noise between messages, so the receiver PLL
+// is at an arbitrary phase when each preamble starts, and each message starts at a random
+// sample within the bit period. Then each bit period is inverted with the given probability.
+// The report shows the fraction of messages delivered, the goodput (user data delivered
+// per second of airtime, counting a gap of GAP_BITS bits after each message), and the number of
+// times the sync word was matched with a bit error (rxSyncErrors()). That includes messages that
+// would have been missed if RH_ASK_SYNC_ERRORS was 0, and false matches on the noise, which
+// are dropped as soon as they give an invalid length or symbol.
+// Tested on Linux
+// Build with
+// cd whatever/RadioHead
+// tools/simBuild examples/simulator/simulator_ask_preamble_benchmark/simulator_ask_preamble_benchmark.pde
+// Run with ./simulator_ask_preamble_benchmark
+
+#include <RH_ASK.h>
+
+#define SPEED 2000
+#define MESSAGES 1000
+#define MESSAGE_LEN 20   // Like a GPS position
+#define GAP_BITS 100     // 50ms at 2000bps, as in RF_Transmit
+
+static const double bers[] = { 0, 0.001, 0.003, 0.01, 0.02 };
+#define NUM_BERS (sizeof(bers) / sizeof(bers[0]))
+
+#define MAX_PREAMBLE (RH_ASK_PREAMBLE_LEN - 2)
+
+#include "../simulator_samples.h"
+// samples is the channel, one octet per sample
+
+// Record the transmitter output for all the messages, with noise between them
+static void transmit(uint8_t preamble)
+{
+    RH_ASK tx(SPEED);
+    tx.init();
+    tx.setPreambleLength(preamble);
+    numSamples = 0;
+    srandom(preamble);
+    uint8_t buf[MESSAGE_LEN];
+    uint8_t octets[64];
+    for (uint16_t seq = 0; seq < MESSAGES; seq++)
+    {
+	// Noise, a random number of samples long: the receiver sees a new level every few samples
+	uint16_t gap = GAP_BITS * 8 + (random() % 8);
+	uint8_t level = 0;
+	for (uint16_t i = 0; i < gap; i++)
+	{
+	    if ((random() % 3) == 0)
+		level = random() & 1;
+	    addSample(level);
+	}
+	makePayload(seq, buf);
+	tx.send(buf, sizeof(buf));
+	while (tx.mode() == RHGenericDriver::RHModeTx)
+	{
+	    uint32_t len = tx.transmitSamples(octets, sizeof(octets));
+	    for (uint32_t i = 0; i < len; i++)
+		for (uint8_t bit = 0; bit < 8; bit++)
+		    addSample((octets[i] >> bit) & 1);
+	}
+    }
+    while (numSamples % 8)
+	addSample(0);
+}
+
+typedef struct
+{
+    unsigned long delivered;  // Distinct correct messages
+    uint16_t      syncErrors; // Sync word matches with a bit error
+    double        goodput;    // Bits of user data per second of airtime
+} Result;
+
+// Invert each bit period with probability ber, and receive
+static Result receive(double ber)
+{
+    Result r = {};
+    bool seen[MESSAGES] = {false};
+    RH_ASK rx(SPEED);
+    rx.init();
+    uint8_t buf[RH_ASK_MAX_MESSAGE_LEN];
+    uint8_t expected[MESSAGE_LEN];
+    uint8_t len;
+    srandom(100);
+    long threshold = ber * RAND_MAX;
+    for (unsigned long i = 0; i < numSamples; i += 8)
+    {
+	uint8_t octet = 0;
+	for (uint8_t bit = 0; bit < 8; bit++)
+	    octet |= samples[i + bit] << bit;
+	if (random() < threshold)
+	    octet = ~octet;
+	rx.receiveSamples(&octet, 1);
+	len = sizeof(buf);
+	while (rx.recv(buf, &len))
+	{
+	    uint16_t seq = (buf[0] << 8) | buf[1];
+	    makePayload(seq, expected);
+	    if (len == MESSAGE_LEN && seq < MESSAGES && !seen[seq] && memcmp(buf, expected, len) == 0)
+	    {
+		seen[seq] = true;
+		r.delivered++;
+	    }
+	    len = sizeof(buf);
+	}
+    }
+    r.syncErrors = rx.rxSyncErrors();
+    r.goodput = r.delivered * MESSAGE_LEN * 8.0 / ((double)numSamples / 8 / SPEED);
+    return r;
+}
+
+void setup()
+{
+    static Result results[MAX_PREAMBLE + 1][NUM_BERS];
+    for (uint8_t p = 1; p <= MAX_PREAMBLE; p++)
+    {
+	transmit(p);
+	for (uint8_t b = 0; b < NUM_BERS; b++)
+	    results[p][b] = receive(bers[b]);
+    }
+
+    printf("RH_ASK acquisition by preamble length, %d messages of %d octets at %d bps, %d bits of noise between messages\n",
+	   MESSAGES, MESSAGE_LEN, SPEED, GAP_BITS);
+    printf("Delivered fraction / goodput in bps / sync word matches with a bit error\n");
+    printf("%-8s", "BER");
+    for (uint8_t p = 1; p <= MAX_PREAMBLE; p++)
+	printf("   %2d preamble bits  ", p * 6);
+    printf("\n");
+    for (uint8_t b = 0; b < NUM_BERS; b++)
+    {
+	printf("%-8.3f", bers[b]);
+	for (uint8_t p = 1; p <= MAX_PREAMBLE; p++)
+	    printf("  %5.3f / %4.0f / %3u", (double)results[p][b].delivered / MESSAGES,
+		   results[p][b].goodput, results[p][b].syncErrors);
+	printf("\n");
+    }
+    exit(0);
+}
+
+void loop()
+{
+}
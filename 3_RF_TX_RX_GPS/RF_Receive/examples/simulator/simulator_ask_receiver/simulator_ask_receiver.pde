@@ -0,0 +1,99 @@
+// simulator_ask_receiver.pde
+// -*- mode: C++ -*-
+// Example of how to use the RH_ASK modem in the simulator, without a radio.
+// With no arguments, reads a stream of 8x oversampled RH_ASK samples from stdin, 
+// and prints each message as it arrives, eg from simulator_ask_transmitter through a pipe.
+// With a file name argument, batch decodes a capture of samples from the file, and reports
+// the number of messages found and how many megabytes of samples per second the modem decoded.
+// Tested on Linux
+// Build with
+// cd whatever/RadioHead 
+// tools/simBuild examples/simulator/simulator_ask_receiver/simulator_ask_receiver.pde
+// Run with ./simulator_ask_transmitter | ./simulator_ask_receiver
+// or ./simulator_ask_receiver capture.bin
+
+#include <RH_ASK.h>
+#include <time.h>
+
+RH_ASK driver;
+
+static double nowSecs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Decode a whole capture file in memory
+static void batchDecode(const char* filename)
+{
+    FILE* f = fopen(filename, "rb");
+    if (!f)
+    {
+	printf("Cannot read %s\n", filename);
+	exit(1);
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* samples = (uint8_t*)malloc(size ? size : 1);
+    if (fread(samples, 1, size, f) != (size_t)size)
+    {
+	printf("Cannot read %s\n", filename);
+	exit(1);
+    }
+    fclose(f);
+
+    uint8_t buf[RH_ASK_MAX_MESSAGE_LEN];
+    uint8_t len;
+    unsigned long messages = 0;
+    uint32_t pos = 0;
+    double start = nowSecs();
+    while (pos < (uint32_t)size)
+    {
+	pos += driver.receiveSamples(samples + pos, size - pos);
+	len = sizeof(buf);
+	while (driver.recv(buf, &len))
+	{
+	    messages++;
+	    len = sizeof(buf);
+	}
+    }
+    double secs = nowSecs() - start;
+    printf("%lu messages, %u bad, in %ld octets of samples (%.1f s at %u bps): %.1f MB/s, %.0fx real time\n",
+	   messages, driver.rxBad(), size, (double)size / driver.speed(), driver.speed(), 
+	   size / secs / 1e6, size / secs / driver.speed());
+    exit(0);
+}
+
+void setup()
+{
+    if (!driver.init())
+    {
+	printf("init failed\n");
+	exit(1);
+    }
+    if (_simulator_argc >= 2)
+	batchDecode(_simulator_argv[1]);
+    // Samples come from stdin
+    driver.setSampleStreams(0, -1);
+}
+
+void loop()
+{
+    uint8_t buf[RH_ASK_MAX_MESSAGE_LEN];
+    uint8_t len = sizeof(buf);
+
+    if (driver.recv(buf, &len))
+    {
+	printf("got: %.*s\n", len, (char*)buf);
+	fflush(stdout);
+    }
+    else if (driver.sampleStreamEnded())
+    {
+	printf("end of stream, %u bad messages\n", driver.rxBad());
+	exit(0);
+    }
+    else
+	delay(1); // Wait for more samples
+}
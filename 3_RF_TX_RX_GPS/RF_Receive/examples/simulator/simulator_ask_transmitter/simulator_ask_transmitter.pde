@@ -0,0 +1,43 @@
+// simulator_ask_transmitter.pde
+// -*- mode: C++ -*-
+// Example of how to use the RH_ASK modem in the simulator, without a radio.
+// Sends messages as a stream of 8x oversampled RH_ASK samples on stdout, so
+// they can be piped into simulator_ask_receiver, or saved as a capture for it to decode later.
+// Tested on Linux
+// Build with
+// cd whatever/RadioHead 
+// tools/simBuild examples/simulator/simulator_ask_transmitter/simulator_ask_transmitter.pde
+// Run with ./simulator_ask_transmitter [count] | ./simulator_ask_receiver
+// or ./simulator_ask_transmitter [count] > capture.bin
+
+#include <RH_ASK.h>
+
+RH_ASK driver;
+
+void setup()
+{
+    unsigned long count = 10;
+    if (_simulator_argc >= 2)
+	count = atol(_simulator_argv[1]);
+
+    if (!driver.init())
+    {
+	fprintf(stderr, "init failed\n");
+	exit(1);
+    }
+    // Samples go to stdout
+    driver.setSampleStreams(-1, 1);
+
+    char msg[RH_ASK_MAX_MESSAGE_LEN];
+    for (unsigned long i = 0; i < count; i++)
+    {
+	snprintf(msg, sizeof(msg), "hello %lu", i);
+	driver.send((uint8_t*)msg, strlen(msg));
+    }
+    fprintf(stderr, "simulator_ask_transmitter: sent %lu messages\n", count);
+    exit(0);
+}
+
+void loop()
+{
+}
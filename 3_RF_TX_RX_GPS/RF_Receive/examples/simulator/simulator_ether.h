@@ -0,0 +1,193 @@
+// simulator_ether.h
+// -*- mode: C++ -*-
+// An ether for the RHReliableDatagram benchmarks, that works like tools/etherSimulator.pl but in the
+// benchmark process, so the results do not depend on the scheduling of several processes.
+// Each SimNode joins the ether when it is constructed. A message sent by one takes its airtime at BPS
+// to arrive at every other node, plus etherLatencyMs for the receiver to notice it. It is lost with
+// probability etherLoss, and messages whose airtime overlaps at a node collide and are both lost.
+// With etherHalfDuplex, messages that arrive at a node while it is transmitting are lost too, like a radio.
+// A node made deaf with setDeaf() hears nothing, but the others still hear it.
+// Define BPS, and optionally OVERHEAD, ETHER_MESSAGE_LEN, ETHER_FLIGHTS and ETHER_NODES, before including this.
+
+#include <RHGenericDriver.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef BPS
+ #error Define BPS before including simulator_ether.h
+#endif
+#ifndef OVERHEAD
+ #define OVERHEAD 8       // Octets of preamble, headers and FCS per message
+#endif
+#ifndef ETHER_MESSAGE_LEN
+ #define ETHER_MESSAGE_LEN RH_MAX_MESSAGE_LEN // Longest message the nodes can send
+#endif
+#ifndef ETHER_FLIGHTS
+ #define ETHER_FLIGHTS 16 // Messages that can be on their way to each node
+#endif
+#ifndef ETHER_NODES
+ #define ETHER_NODES 16   // Nodes that can join the ether
+#endif
+
+static uint64_t micros64()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+// A message on its way through the ether to a node
+typedef struct
+{
+    uint64_t start;  // When its first bit arrives
+    uint64_t end;    // When its last bit arrives
+    bool     lost;   // Collided, or lost to the loss rate
+    uint8_t  headers[4];
+    uint8_t  len;
+    uint8_t  data[ETHER_MESSAGE_LEN];
+} Flight;
+
+static pthread_mutex_t etherLock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int etherLatencyMs;
+static double etherLoss;
+static bool etherHalfDuplex;
+static unsigned int lossSeed = 1;
+
+class SimNode;
+static SimNode* ether[ETHER_NODES];
+static uint8_t etherNodes;
+
+// A driver for a node on the ether
+class SimNode : public RHGenericDriver
+{
+public:
+    SimNode() : _deaf(false), _flights(0), _txDone(0), _rxBufValid(false)
+    {
+	if (etherNodes < ETHER_NODES)
+	    ether[etherNodes++] = this;
+    }
+
+    void setDeaf(bool deaf) { _deaf = deaf; }
+
+    // Forgets any messages on their way to this node, and any uncollected one
+    void reset()
+    {
+	pthread_mutex_lock(&etherLock);
+	_flights = 0;
+	_rxBufValid = false;
+	pthread_mutex_unlock(&etherLock);
+    }
+
+    bool available()
+    {
+	uint64_t now = micros64();
+	pthread_mutex_lock(&etherLock);
+	// Messages arrive in order. Collided and lost ones, and any that find the last one uncollected, are lost
+	while (_flights && _flight[0].end + etherLatencyMs * 1000 <= now)
+	{
+	    Flight* f = &_flight[0];
+	    if (!f->lost && !_rxBufValid
+		&& (f->headers[0] == _thisAddress || f->headers[0] == RH_BROADCAST_ADDRESS))
+	    {
+		_rxHeaderTo = f->headers[0];
+		_rxHeaderFrom = f->headers[1];
+		_rxHeaderId = f->headers[2];
+		_rxHeaderFlags = f->headers[3];
+		memcpy(_rxBuf, f->data, f->len);
+		_rxBufLen = f->len;
+		_rxBufValid = true;
+		_rxGood++;
+	    }
+	    memmove(&_flight[0], &_flight[1], --_flights * sizeof(Flight));
+	}
+	pthread_mutex_unlock(&etherLock);
+	return _rxBufValid;
+    }
+
+    bool recv(uint8_t* buf, uint8_t* len)
+    {
+	if (!available())
+	    return false;
+	if (buf && len)
+	{
+	    if (*len > _rxBufLen)
+		*len = _rxBufLen;
+	    memcpy(buf, _rxBuf, *len);
+	}
+	_rxBufValid = false;
+	return true;
+    }
+
+    bool send(const uint8_t* data, uint8_t len)
+    {
+	if (len > maxMessageLength())
+	    return false;
+	waitPacketSent();
+	uint64_t now = micros64();
+	uint64_t airtime = (uint64_t)(len + OVERHEAD) * 8 * 1000000 / BPS;
+	pthread_mutex_lock(&etherLock);
+	_txDone = now + airtime;
+	_mode = RHModeTx;
+	for (uint8_t n = 0; n < etherNodes; n++)
+	{
+	    SimNode* peer = ether[n];
+	    if (peer == this || peer->_flights >= ETHER_FLIGHTS)
+		continue;
+	    Flight* f = &peer->_flight[peer->_flights++];
+	    f->start = now;
+	    f->end = now + airtime;
+	    f->lost = peer->_deaf || rand_r(&lossSeed) < etherLoss * RAND_MAX;
+	    f->headers[0] = _txHeaderTo;
+	    f->headers[1] = _txHeaderFrom;
+	    f->headers[2] = _txHeaderId;
+	    f->headers[3] = _txHeaderFlags;
+	    memcpy(f->data, data, len);
+	    f->len = len;
+	    // Collides with anything else arriving at the same time
+	    for (uint8_t i = 0; i < peer->_flights - 1; i++)
+		if (peer->_flight[i].end > f->start)
+		    peer->_flight[i].lost = f->lost = true;
+	    // The peer cant hear this while it is transmitting
+	    if (etherHalfDuplex && peer->_mode == RHModeTx && peer->_txDone > f->start)
+		f->lost = true;
+	}
+	// and this node cant hear anything arriving while it transmits
+	for (uint8_t i = 0; etherHalfDuplex && i < _flights; i++)
+	    if (_flight[i].end > now && _flight[i].start < now + airtime)
+		_flight[i].lost = true;
+	pthread_mutex_unlock(&etherLock);
+	_txGood++;
+	return true;
+    }
+
+    bool waitPacketSent()
+    {
+	while (_mode == RHModeTx)
+	{
+	    uint64_t now = micros64();
+	    if (now >= _txDone)
+		_mode = RHModeIdle;
+	    else
+		usleep(_txDone - now);
+	}
+	return true;
+    }
+
+    bool waitPacketSent(uint16_t timeout)
+    {
+	(void)timeout;
+	return waitPacketSent();
+    }
+
+    uint8_t maxMessageLength() { return ETHER_MESSAGE_LEN; }
+
+private:
+    bool            _deaf;  // Hears nothing from the other nodes
+    Flight          _flight[ETHER_FLIGHTS];
+    uint8_t         _flights;
+    uint64_t        _txDone;
+    bool            _rxBufValid;
+    uint8_t         _rxBuf[ETHER_MESSAGE_LEN];
+    uint8_t         _rxBufLen;
+};
@@ -0,0 +1,154 @@
+// simulator_reliable_gateway_benchmark.pde
+// -*- mode: C++ -*-
+// A gateway collects reports from NODES nodes, each sending one every PERIOD_MS with sendtoWait(),
+// and answers each report with a command to the node. One of the nodes can be heard by the gateway but
+// cannot hear it, so commands to it always fail.
+// Compares a gateway that answers with sendtoWait(), which blocks while it waits for the ACK of each command,
+// with one that queues its commands with sendtoQueue() and calls service(), so one node's missing ACKs do not
+// hold up the others.
+// All the nodes share the in process ether in simulator_ether.h, with LATENCY_MS latency and LOSS loss.
+// Tested on Linux
+// Build with
+// cd whatever/RadioHead
+// CPPFLAGS='-DRH_RELIABLE_WINDOW=8 -DRH_RELIABLE_RECV_QUEUE=4' tools/simBuild examples/simulator/simulator_reliable_gateway_benchmark/simulator_reliable_gateway_benchmark.pde
+// Run with ./simulator_reliable_gateway_benchmark
+
+#include <RHReliableDatagram.h>
+
+#if !RH_RELIABLE_WINDOW || !RH_RELIABLE_RECV_QUEUE
+#error Build with CPPFLAGS='-DRH_RELIABLE_WINDOW=8 -DRH_RELIABLE_RECV_QUEUE=4'
+#endif
+
+#define BPS 100000
+#define LATENCY_MS 5
+#define LOSS 0.05
+#define MESSAGE_LEN 24
+#define NODES 8
+#define PERIOD_MS 1000
+#define RUN_MS 15000
+
+#define GATEWAY_ADDRESS 1
+#define DEAF_ADDRESS (NODES + 1) // The node that cannot hear the gateway
+
+#define ETHER_FLIGHTS 32
+
+#include "../simulator_ether.h"
+
+static SimNode gatewayNode;
+static SimNode nodes[NODES];
+static RHReliableDatagram gateway(gatewayNode, GATEWAY_ADDRESS);
+
+static volatile bool running;
+static volatile uint32_t reportsSent, reportsFailed, commandsReceived;
+
+// A node: sends a report every PERIOD_MS, and collects commands in between
+static void* nodeThread(void* arg)
+{
+    uint8_t n = (uint8_t)(long)arg;
+    RHReliableDatagram manager(nodes[n], n + 2);
+    manager.init();
+    uint8_t buf[RH_MAX_MESSAGE_LEN];
+    memset(buf, 0, sizeof(buf));
+    // Spread the nodes out over the period
+    unsigned long next = millis() + PERIOD_MS * n / NODES;
+    while (running)
+    {
+	if ((long)(millis() - next) >= 0)
+	{
+	    next += PERIOD_MS;
+	    __sync_fetch_and_add(&reportsSent, 1);
+	    if (!manager.sendtoWait(buf, MESSAGE_LEN, GATEWAY_ADDRESS))
+		__sync_fetch_and_add(&reportsFailed, 1);
+	}
+	uint8_t len = sizeof(buf);
+	if (manager.recvfromAckTimeout(buf, &len, 5))
+	    __sync_fetch_and_add(&commandsReceived, 1);
+    }
+    return NULL;
+}
+
+static uint32_t commandsAcked, commandsFailed, commandsSkipped;
+static bool commandPending[256];
+
+static void commandDone(void* context, bool acknowledged)
+{
+    commandPending[(long)context] = false;
+    if (acknowledged)
+	commandsAcked++;
+    else
+	commandsFailed++;
+}
+
+static void run(bool queued)
+{
+    reportsSent = reportsFailed = commandsReceived = 0;
+    commandsAcked = commandsFailed = commandsSkipped = 0;
+    memset(commandPending, 0, sizeof(commandPending));
+    uint32_t reports = 0;
+    running = true;
+    pthread_t threads[NODES];
+    for (long n = 0; n < NODES; n++)
+	pthread_create(&threads[n], NULL, nodeThread, (void*)n);
+
+    uint8_t buf[RH_MAX_MESSAGE_LEN];
+    uint8_t command[MESSAGE_LEN];
+    memset(command, 0, sizeof(command));
+    unsigned long start = millis();
+    while (millis() - start < RUN_MS)
+    {
+	uint8_t len = sizeof(buf);
+	uint8_t from;
+	if (queued)
+	{
+	    gateway.service();
+	    while (gateway.recvfromAck(buf, &len, &from))
+	    {
+		reports++;
+		// One command at a time to each node
+		if (commandPending[from] || !gateway.sendtoQueue(command, sizeof(command), from, commandDone, (void*)(long)from))
+		    commandsSkipped++;
+		else
+		    commandPending[from] = true;
+		len = sizeof(buf);
+	    }
+	    gateway.waitAvailableTimeout(2);
+	}
+	else if (gateway.recvfromAckTimeout(buf, &len, 10, &from))
+	{
+	    reports++;
+	    if (gateway.sendtoWait(command, sizeof(command), from))
+		commandsAcked++;
+	    else
+		commandsFailed++;
+	}
+    }
+    running = false;
+    for (uint8_t n = 0; n < NODES; n++)
+	pthread_join(threads[n], NULL);
+    if (queued)
+	gateway.waitWindow();
+    printf("%-28s %9.1f %9.1f%% %9lu %9lu %9lu\n",
+	   queued ? "sendtoQueue() and service()" : "sendtoWait()",
+	   reports * 1000.0 / RUN_MS,
+	   reportsSent ? reportsFailed * 100.0 / reportsSent : 0.0,
+	   (unsigned long)commandsAcked, (unsigned long)commandsFailed, (unsigned long)commandsSkipped);
+}
+
+void setup()
+{
+    etherLatencyMs = LATENCY_MS;
+    etherLoss = LOSS;
+    nodes[DEAF_ADDRESS - 2].setDeaf(true);
+    gateway.init();
+
+    printf("%d nodes reporting every %d ms to a gateway, %d octets at %d bps, %.0f%% loss, node %d cannot hear the gateway\n",
+	   NODES, PERIOD_MS, MESSAGE_LEN, BPS, LOSS * 100, DEAF_ADDRESS);
+    printf("gateway                      reports/s   failed  commands    failed   skipped\n");
+    run(false);
+    run(true);
+    exit(0);
+}
+
+void loop()
+{
+}
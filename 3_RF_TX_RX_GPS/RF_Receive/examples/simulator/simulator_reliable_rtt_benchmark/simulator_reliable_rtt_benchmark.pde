@@ -0,0 +1,121 @@
+// simulator_reliable_rtt_benchmark.pde
+// -*- mode: C++ -*-
+// Compares RHReliableDatagram with a fixed ACK timeout and with the timeout adapted to the measured
+// round trip time, on a fast link and on a link to a node that is slow to collect its messages.
+// Shows messages per second and retransmissions per message with sendtoWait() and with sendtoWindow().
+// The two nodes are connected by the in process ether in simulator_ether.h, with the latency
+// and loss of each scenario.
+// Tested on Linux
+// Build with
+// cd whatever/RadioHead
+// CPPFLAGS=-DRH_RELIABLE_WINDOW=8 tools/simBuild examples/simulator/simulator_reliable_rtt_benchmark/simulator_reliable_rtt_benchmark.pde
+// Run with ./simulator_reliable_rtt_benchmark
+
+#include <RHReliableDatagram.h>
+
+#if !RH_RELIABLE_WINDOW
+#error sendtoWindow() needs RH_RELIABLE_WINDOW, build with CPPFLAGS=-DRH_RELIABLE_WINDOW=8
+#endif
+
+#define BPS 10000        // Like etherSimulator.pl
+#define MESSAGE_LEN 32
+#define WINDOW 4
+#define RUN_MS 4000
+
+#define SENDER_ADDRESS 1
+
+#include "../simulator_ether.h"
+
+static SimNode senderNode, receiverNode;
+static RHReliableDatagram sender(senderNode, SENDER_ADDRESS);
+static RHReliableDatagram receiver(receiverNode);
+
+static volatile bool receiving;
+static volatile uint32_t delivered;
+
+static void* receiverThread(void*)
+{
+    while (true)
+    {
+	uint8_t buf[RH_MAX_MESSAGE_LEN];
+	uint8_t len = sizeof(buf);
+	if (receiver.recvfromAckTimeout(buf, &len, 10))
+	    delivered++;
+	else if (!receiving)
+	    return NULL;
+    }
+}
+
+// Sends for RUN_MS, then waits for the rest to be acknowledged
+static void run(uint8_t address, bool adaptive, bool windowed)
+{
+    senderNode.reset();
+    receiverNode.reset();
+    sender.setAdaptiveTimeout(adaptive);
+    sender.resetRetransmissions();
+    receiver.setThisAddress(address);
+    delivered = 0;
+    receiving = true;
+    pthread_t thread;
+    pthread_create(&thread, NULL, receiverThread, NULL);
+
+    uint8_t buf[MESSAGE_LEN];
+    memset(buf, 0, sizeof(buf));
+    uint32_t sent = 0;
+    unsigned long start = millis();
+    while (millis() - start < RUN_MS)
+    {
+	if (windowed)
+	    sender.sendtoWindow(buf, sizeof(buf), address);
+	else
+	    sender.sendtoWait(buf, sizeof(buf), address);
+	sent++;
+    }
+    if (windowed)
+	sender.waitWindow();
+    unsigned long elapsed = millis() - start;
+    delay(etherLatencyMs * 2 + 500); // Let the last message arrive
+    receiving = false;
+    pthread_join(thread, NULL);
+    printf(" %6.1f %5.2f", delivered * 1000.0 / elapsed, (float)sender.retransmissions() / sent);
+    fflush(stdout);
+}
+
+void setup()
+{
+    sender.init();
+    receiver.init();
+    sender.setWindow(WINDOW);
+
+    // A fast link with the timeout tuned for a slower one, then a slow receiver with the timeout too short
+    const struct { unsigned int latency; float loss; uint16_t timeout; } scenarios[] =
+    {
+	{ 10,  0.0,  200 },
+	{ 10,  0.05, 200 },
+	{ 10,  0.2,  200 },
+	{ 150, 0.0,  100 },
+	{ 150, 0.05, 100 },
+    };
+    printf("Messages per second and retransmissions per message, %d octets at %d bps\n", MESSAGE_LEN, BPS);
+    printf("                        sendtoWait                  window %d\n", WINDOW);
+    printf("latency loss timeout    fixed        adaptive       fixed        adaptive      rtt/var/rto\n");
+    for (uint8_t s = 0; s < sizeof(scenarios) / sizeof(scenarios[0]); s++)
+    {
+	etherLatencyMs = scenarios[s].latency;
+	etherLoss = scenarios[s].loss;
+	sender.setTimeout(scenarios[s].timeout);
+	// A new node for each scenario, so the adaptive timeout starts from scratch
+	uint8_t address = 2 + s;
+	printf("%4d ms %3.0f%% %4d ms ", etherLatencyMs, etherLoss * 100, scenarios[s].timeout);
+	run(address, false, false);
+	run(address, true, false);
+	run(address, false, true);
+	run(address, true, true);
+	printf("  %d/%d/%d\n", sender.rtt(address), sender.rttVariation(address), sender.retransmitTimeout(address));
+    }
+    exit(0);
+}
+
+void loop()
+{
+}
@@ -0,0 +1,51 @@
+// simulator_samples.h
+// -*- mode: C++ -*-
+// Helpers shared by the RH_ASK benchmarks that record a transmitter output as a stream of samples,
+// pass it through a simulated channel, and check what the receiver makes of it.
+// Define MESSAGE_LEN before including this.
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef MESSAGE_LEN
+ #error Define MESSAGE_LEN before including simulator_samples.h
+#endif
+
+// The sample stream. Each sketch decides what a sample is
+static uint8_t*      samples;
+static unsigned long numSamples;
+static unsigned long maxSamples;
+
+static inline double nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// The MESSAGE_LEN octets of message number seq, so the receiver can check what it got
+static inline void makePayload(uint16_t seq, uint8_t* buf)
+{
+    buf[0] = seq >> 8;
+    buf[1] = seq & 0xff;
+    for (uint8_t i = 2; i < MESSAGE_LEN; i++)
+	buf[i] = (seq * 7) + i;
+}
+
+// Returns room for len more samples at the end of the stream. Add them to numSamples when written
+static inline uint8_t* reserveSamples(unsigned long len)
+{
+    if (numSamples + len > maxSamples)
+    {
+	maxSamples = (numSamples + len) * 2;
+	samples = (uint8_t*)realloc(samples, maxSamples);
+    }
+    return samples + numSamples;
+}
+
+static inline void addSample(uint8_t level)
+{
+    *reserveSamples(1) = level;
+    numSamples++;
+}
@@ -58,6 +58,14 @@ unsigned long millis()
     return time_in_millis() - start_millis;
 }
 
+// Arduino equivalent, microseconds since process start
+unsigned long micros()
+{
+    struct timeval te; 
+    gettimeofday(&te, NULL);
+    return (te.tv_sec*1000000LL + te.tv_usec) - (start_millis * 1000LL);
+}
+
 long random(long from, long to)
 {
     return from + (random() % (to - from));
@@ -28,6 +28,15 @@ const unsigned long gpsInterval = 1000;        // 1 second
 float latitude = 0.0;
 float longitude = 0.0;
 
+// Message being sent, and how many more copies of it are still to be queued
+char pendingMsg[RH_ASK_MAX_MESSAGE_LEN + 1];
+uint8_t pendingCopies = 0;
+
+// Copies are spaced apart, so a burst of noise cannot corrupt all of them
+const unsigned long copyGap = 50; // 50 ms between the end of one copy and the start of the next
+bool copyInFlight = false;
+unsigned long lastCopyDone = 0;
+
 // send state
 volatile bool isTransmitting = false;
 volatile unsigned long lastButtonPress = 0;
@@ -55,6 +64,9 @@ void setup() {
     while (1); // Halt if initialization fails
   }
   Serial.println("RF433MHz transmitter initialized.");
+  // Add FEC parity to each message so the receiver can correct a few corrupted octets.
+  // Receivers without FEC support still get the messages as usual
+  rfDriver.setFec(true);
 }
 
 void togglesend() {
@@ -96,6 +108,9 @@ void loop() {
   
   // Update LED state based on send
   digitalWrite(ledPin, isTransmitting ? HIGH : LOW);
+
+  // Queue any remaining copies as transmit queue slots free up
+  queuePendingCopies();
   
   // send logic
   unsigned long currentTime = millis();
@@ -123,16 +138,8 @@ void sendGPSData() {
     Serial.print("Sending GPS data: ");
     Serial.println(gpsMessage);
     
-    // Convert String to C-string for RadioHead
-    const char* msg = gpsMessage.c_str();
-    
     // Send message multiple times for reliability
-    for (int i = 0; i < 5; i++) {
-      rfDriver.send((uint8_t *)msg, strlen(msg));
-      rfDriver.waitPacketSent();
-      Serial.println("GPS send attempt " + String(i + 1) + " complete.");
-      delay(50);
-    }
+    startSending(gpsMessage.c_str(), 5);
   } else {
     Serial.println("No valid GPS  data to send.");
   }
@@ -144,10 +151,29 @@ void sendNamaskaram() {
   Serial.println(msg);
   
   // Send message multiple times for reliability
-  for (int i = 0; i < 3; i++) {
-    rfDriver.send((uint8_t *)msg, strlen(msg));
-    rfDriver.waitPacketSent();
-    Serial.println("Mesg send attempt " + String(i + 1) + " complete.");
-    delay(50);
+  startSending(msg, 3);
+}
+
+// Starts sending copies of msg, replacing any copies of the previous message not yet queued
+void startSending(const char *msg, uint8_t copies) {
+  strncpy(pendingMsg, msg, RH_ASK_MAX_MESSAGE_LEN);
+  pendingMsg[RH_ASK_MAX_MESSAGE_LEN] = '\0';
+  pendingCopies = copies;
+  queuePendingCopies();
+}
+
+// Queues the next copy once copyGap has passed since the previous one finished. Never blocks:
+// the driver transmits the copy in the background, so loop() keeps reading the GPS
+void queuePendingCopies() {
+  if (copyInFlight) {
+    if (rfDriver.txQueueDepth() > 0)
+      return; // Still transmitting
+    copyInFlight = false;
+    lastCopyDone = millis();
+  }
+  if (pendingCopies > 0 && millis() - lastCopyDone >= copyGap && rfDriver.txQueueSpace() > 0) {
+    rfDriver.send((uint8_t *)pendingMsg, strlen(pendingMsg));
+    pendingCopies--;
+    copyInFlight = true;
   }
 }
@@ -70,6 +70,21 @@ public:
     /// \return true if the message not too loing fot eh driver, and the message was transmitted.
     bool sendto(uint8_t* buf, uint8_t len, uint8_t address);
 
+    /// Starts sending a message to the node(s) with the given address, without waiting for it to be transmitted.
+    /// See RHGenericDriver::sendAsync()
+    /// \param[in] buf Pointer to the binary message to send
+    /// \param[in] len Number of octets to send (> 0)
+    /// \param[in] address The address to send the message to.
+    /// \param[in] callback Function for service() to call when the message has been transmitted, or NULL
+    /// \param[in] context Passed to callback
+    /// \return true if the message was started
+    bool sendtoAsync(uint8_t* buf, uint8_t len, uint8_t address,
+		     RHGenericDriver::SendCallback callback = NULL, void* context = NULL);
+
+    /// Calls the callbacks of messages sent with sendtoAsync() that have been transmitted.
+    /// Call this often, eg in loop()
+    void service();
+
     /// Turns the receiver on if it not already on.
     /// If there is a valid message available for this node, copy it to buf and return true
     /// The SRC address is placed in *from if present and not NULL.
@@ -87,6 +102,23 @@ public:
     /// \return true if a valid message was copied to buf
     bool recvfrom(uint8_t* buf, uint8_t* len, uint8_t* from = NULL, uint8_t* to = NULL, uint8_t* id = NULL, uint8_t* flags = NULL);
 
+    /// Like recvfrom(), but returns a pointer to the message in the driver's receive buffer, which stays
+    /// valid until release(), instead of copying it. See RHGenericDriver::recvView()
+    /// \param[out] buf Set to point to the message
+    /// \param[out] len Set to the length of the message
+    /// \param[in] from If present and not NULL, the referenced uint8_t will be set to the FROM address
+    /// \param[in] to If present and not NULL, the referenced uint8_t will be set to the TO address
+    /// \param[in] id If present and not NULL, the referenced uint8_t will be set to the ID
+    /// \param[in] flags If present and not NULL, the referenced uint8_t will be set to the FLAGS
+    /// \param[in] copy Location to copy the message if the driver cannot lend out its buffer
+    /// \param[in] copyLen Available space in copy
+    /// \return true if there was a valid message
+    bool recvfromView(const uint8_t** buf, uint8_t* len, uint8_t* from = NULL, uint8_t* to = NULL, uint8_t* id = NULL, uint8_t* flags = NULL,
+		      uint8_t* copy = NULL, uint8_t copyLen = 0);
+
+    /// Releases the message returned by recvfromView(), so the driver can receive again
+    void release();
+
     /// Tests whether a new message is available
     /// from the Driver.
     /// On most drivers, this will also put the Driver into RHModeRx mode until
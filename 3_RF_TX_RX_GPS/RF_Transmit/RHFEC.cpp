@@ -0,0 +1,180 @@
+// RHFEC.cpp
+//
+// Reed-Solomon erasure correction for RadioHead. See RHFEC.h
+//
+// Contributed to the RadioHead project
+
+#include "RHFEC.h"
+
+// The tables live in flash on AVR, so they must be read with pgm_read_byte
+#if defined(__AVR__)
+ #include <avr/pgmspace.h>
+ #define RH_FEC_PROGMEM PROGMEM
+ #define RH_FEC_TABLE(t, i) pgm_read_byte(&(t)[(i)])
+#else
+ #define RH_FEC_PROGMEM
+ #define RH_FEC_TABLE(t, i) ((t)[(i)])
+#endif
+
+// Powers of the primitive element 2 in GF(256) with field polynomial x^8+x^4+x^3+x^2+1 (0x11d)
+RH_FEC_PROGMEM static const uint8_t gf_exp[255] =
+{
+      1,   2,   4,   8,  16,  32,  64, 128,  29,  58, 116, 232, 205, 135,  19,  38,
+     76, 152,  45,  90, 180, 117, 234, 201, 143,   3,   6,  12,  24,  48,  96, 192,
+    157,  39,  78, 156,  37,  74, 148,  53, 106, 212, 181, 119, 238, 193, 159,  35,
+     70, 140,   5,  10,  20,  40,  80, 160,  93, 186, 105, 210, 185, 111, 222, 161,
+     95, 190,  97, 194, 153,  47,  94, 188, 101, 202, 137,  15,  30,  60, 120, 240,
+    253, 231, 211, 187, 107, 214, 177, 127, 254, 225, 223, 163,  91, 182, 113, 226,
+    217, 175,  67, 134,  17,  34,  68, 136,  13,  26,  52, 104, 208, 189, 103, 206,
+    129,  31,  62, 124, 248, 237, 199, 147,  59, 118, 236, 197, 151,  51, 102, 204,
+    133,  23,  46,  92, 184, 109, 218, 169,  79, 158,  33,  66, 132,  21,  42,  84,
+    168,  77, 154,  41,  82, 164,  85, 170,  73, 146,  57, 114, 228, 213, 183, 115,
+    230, 209, 191,  99, 198, 145,  63, 126, 252, 229, 215, 179, 123, 246, 241, 255,
+    227, 219, 171,  75, 150,  49,  98, 196, 149,  55, 110, 220, 165,  87, 174,  65,
+    130,  25,  50, 100, 200, 141,   7,  14,  28,  56, 112, 224, 221, 167,  83, 166,
+     81, 162,  89, 178, 121, 242, 249, 239, 195, 155,  43,  86, 172,  69, 138,   9,
+     18,  36,  72, 144,  61, 122, 244, 245, 247, 243, 251, 235, 203, 139,  11,  22,
+     44,  88, 176, 125, 250, 233, 207, 131,  27,  54, 108, 216, 173,  71, 142,
+};
+
+// Discrete logarithms: gf_exp[gf_log[n]] == n. gf_log[0] is not defined
+RH_FEC_PROGMEM static const uint8_t gf_log[256] =
+{
+      0,   0,   1,  25,   2,  50,  26, 198,   3, 223,  51, 238,  27, 104, 199,  75,
+      4, 100, 224,  14,  52, 141, 239, 129,  28, 193, 105, 248, 200,   8,  76, 113,
+      5, 138, 101,  47, 225,  36,  15,  33,  53, 147, 142, 218, 240,  18, 130,  69,
+     29, 181, 194, 125, 106,  39, 249, 185, 201, 154,   9, 120,  77, 228, 114, 166,
+      6, 191, 139,  98, 102, 221,  48, 253, 226, 152,  37, 179,  16, 145,  34, 136,
+     54, 208, 148, 206, 143, 150, 219, 189, 241, 210,  19,  92, 131,  56,  70,  64,
+     30,  66, 182, 163, 195,  72, 126, 110, 107,  58,  40,  84, 250, 133, 186,  61,
+    202,  94, 155, 159,  10,  21, 121,  43,  78, 212, 229, 172, 115, 243, 167,  87,
+      7, 112, 192, 247, 140, 128,  99,  13, 103,  74, 222, 237,  49, 197, 254,  24,
+    227, 165, 153, 119,  38, 184, 180, 124,  17,  68, 146, 217,  35,  32, 137,  46,
+     55,  63, 209,  91, 149, 188, 207, 205, 144, 135, 151, 178, 220, 252, 190,  97,
+    242,  86, 211, 171,  20,  42,  93, 158, 132,  60,  57,  83,  71, 109,  65, 162,
+     31,  45,  67, 216, 183, 123, 164, 118, 196,  23,  73, 236, 127,  12, 111, 246,
+    108, 161,  59,  82,  41, 157,  85, 170, 251,  96, 134, 177, 187, 204,  62,  90,
+    203,  89,  95, 176, 156, 169, 160,  81,  11, 245,  22, 235, 122, 117,  44, 215,
+     79, 174, 213, 233, 230, 231, 173, 232, 116, 214, 244, 234, 168,  80,  88, 175,
+};
+
+// 2 to the power n, for any n
+static uint8_t gf_pow2(uint16_t n)
+{
+    return RH_FEC_TABLE(gf_exp, n % 255);
+}
+
+static uint8_t gf_mul(uint8_t a, uint8_t b)
+{
+    if (a == 0 || b == 0)
+	return 0;
+    return gf_pow2((uint16_t)RH_FEC_TABLE(gf_log, a) + RH_FEC_TABLE(gf_log, b));
+}
+
+// The generator polynomial (x + 1)(x + 2)(x + 2^2)...(x + 2^(parityLen-1)). gen[k] is the coefficient of x^k
+static void gf_generator(uint8_t* gen, uint8_t parityLen)
+{
+    gen[0] = 1;
+    for (uint8_t i = 0; i < parityLen; i++)
+    {
+	uint8_t root = gf_pow2(i);
+	gen[i + 1] = gen[i];
+	for (uint8_t k = i; k > 0; k--)
+	    gen[k] = gen[k - 1] ^ gf_mul(gen[k], root);
+	gen[0] = gf_mul(gen[0], root);
+    }
+}
+
+// The parity is the remainder of data(x) * x^parityLen divided by the generator polynomial, 
+// highest power first, computed with the usual shift register
+void RHfec_rs_encode_block(uint8_t* parity, uint8_t parityLen, const uint8_t* data, uint8_t len)
+{
+    uint8_t gen[RH_FEC_MAX_PARITY_LEN + 1];
+    uint8_t i, k;
+
+    if (parityLen > RH_FEC_MAX_PARITY_LEN)
+	return; // Would overflow gen
+    gf_generator(gen, parityLen);
+    for (i = 0; i < len; i++)
+    {
+	uint8_t feedback = data[i] ^ parity[0];
+	for (k = 0; k + 1 < parityLen; k++)
+	    parity[k] = parity[k + 1] ^ gf_mul(feedback, gen[parityLen - 1 - k]);
+	parity[parityLen - 1] = gf_mul(feedback, gen[0]);
+    }
+}
+
+// Forney's algorithm with the erasure locator polynomial. Codeword octet i is the coefficient of x^(len-1-i),
+// so its locator is 2^(len-1-i)
+bool RHfec_rs_correct_erasures(uint8_t* codeword, uint8_t len, const uint8_t* erasures, uint8_t parityLen)
+{
+    uint8_t position[RH_FEC_MAX_PARITY_LEN];
+    uint8_t syndrome[RH_FEC_MAX_PARITY_LEN];
+    uint8_t locator[RH_FEC_MAX_PARITY_LEN + 1]; // Erasure locator polynomial, lowest power first
+    uint8_t evaluator[RH_FEC_MAX_PARITY_LEN];   // Erasure evaluator polynomial, lowest power first
+    uint8_t numErasures = 0;
+    uint8_t i, j, k;
+
+    if (parityLen > RH_FEC_MAX_PARITY_LEN)
+	return false; // Would overflow the arrays above
+    for (i = 0; i < len; i++)
+    {
+	if (erasures[i >> 3] & (1 << (i & 7)))
+	{
+	    if (numErasures >= parityLen)
+		return false; // Too many to correct
+	    position[numErasures++] = i;
+	    codeword[i] = 0;
+	}
+    }
+    if (numErasures == 0)
+	return true;
+
+    // Syndromes: the received codeword evaluated at each root of the generator
+    for (j = 0; j < numErasures; j++)
+    {
+	uint8_t s = 0;
+	for (i = 0; i < len; i++)
+	    s = (s ? gf_pow2((uint16_t)RH_FEC_TABLE(gf_log, s) + j) : 0) ^ codeword[i];
+	syndrome[j] = s;
+    }
+
+    // locator(x) = product of (1 + X x) for the locator X of each erasure
+    memset(locator, 0, sizeof(locator));
+    locator[0] = 1;
+    for (j = 0; j < numErasures; j++)
+    {
+	uint8_t x = gf_pow2(len - 1 - position[j]);
+	for (k = j + 1; k > 0; k--)
+	    locator[k] ^= gf_mul(locator[k - 1], x);
+    }
+
+    // evaluator(x) = syndrome(x) * locator(x) mod x^numErasures
+    for (k = 0; k < numErasures; k++)
+    {
+	evaluator[k] = 0;
+	for (j = 0; j <= k; j++)
+	    evaluator[k] ^= gf_mul(syndrome[k - j], locator[j]);
+    }
+
+    // The value of each erased octet is X * evaluator(1/X) / locator'(1/X)
+    for (j = 0; j < numErasures; j++)
+    {
+	uint8_t logX = (len - 1 - position[j]) % 255;
+	uint8_t logXinv = (255 - logX) % 255;
+	uint8_t numerator = 0, denominator = 0;
+	for (k = 0; k < numErasures; k++)
+	    numerator ^= gf_mul(evaluator[k], gf_pow2((uint16_t)logXinv * k));
+	// The formal derivative of the locator only has the odd powers
+	for (k = 1; k <= numErasures; k += 2)
+	    denominator ^= gf_mul(locator[k], gf_pow2((uint16_t)logXinv * (k - 1)));
+	if (denominator == 0)
+	    return false; // Cant happen for distinct erasures
+	if (numerator == 0)
+	    codeword[position[j]] = 0;
+	else
+	    codeword[position[j]] = gf_pow2((uint16_t)logX + RH_FEC_TABLE(gf_log, numerator) 
+					    + 255 - RH_FEC_TABLE(gf_log, denominator));
+    }
+    return true;
+}
@@ -0,0 +1,35 @@
+// RHFEC.h
+//
+// Definitions for RadioHead forward error correction routines.
+//
+// Contributed to the RadioHead project
+
+#ifndef RHFEC_h
+#define RHFEC_h
+
+#include "RadioHead.h"
+
+// A systematic Reed-Solomon code over GF(256) (field polynomial 0x11d, first root 1), shortened to the
+// length of each message. parityLen parity octets are appended to the message. The decoder
+// only corrects erasures: octets that are known to be corrupted, such as those in which RH_ASK found
+// an invalid 4 to 6 bit symbol. Up to parityLen erasures anywhere in the message and parity can be corrected.
+// It is cheap enough to run at user level on an 8 bit processor: the GF(256) log and antilog tables are
+// 511 octets of flash (PROGMEM on AVR), and decoding a 64 octet message with 4 parity octets
+// takes a few hundred table lookups. Corrupted octets that are not flagged as erasures are not
+// corrected, so the result must still be checked, eg with the message FCS.
+
+// The largest parityLen supported. The routines below do nothing with a larger one
+#define RH_FEC_MAX_PARITY_LEN 8
+
+// Computes the parityLen parity octets of a message. Start with parity all 0, then pass the message
+// in as many blocks as convenient, in order. Like the CRC block routines, each call continues
+// where the last one left off. The parity is left unchanged if parityLen > RH_FEC_MAX_PARITY_LEN.
+extern void RHfec_rs_encode_block(uint8_t* parity, uint8_t parityLen, const uint8_t* data, uint8_t len);
+
+// Corrects the erased octets of a codeword in place. The codeword is len octets: the message
+// followed by its parityLen parity octets. Octet i of the codeword is erased if bit (i & 7) of
+// erasures[i >> 3] is set. Returns false if there are more than parityLen erasures, or
+// parityLen > RH_FEC_MAX_PARITY_LEN.
+extern bool RHfec_rs_correct_erasures(uint8_t* codeword, uint8_t len, const uint8_t* erasures, uint8_t parityLen);
+
+#endif
@@ -0,0 +1,289 @@
+// RHFragmentedDatagram.h
+//
+// Contributed to the RadioHead project
+
+#ifndef RHFragmentedDatagram_h
+#define RHFragmentedDatagram_h
+
+#include "RHDatagram.h"
+
+/// The first octet of every message sent by RHFragmentedDatagram says what kind it is
+#define RH_FRAGMENT_TYPE_DATA   0x01 ///< A fragment of a transfer
+#define RH_FRAGMENT_TYPE_POLL   0x02 ///< The sender asking for a status report
+#define RH_FRAGMENT_TYPE_STATUS 0x03 ///< The receiver saying which fragments it has
+/// Set in the type of a fragment to ask for a status report, and in the type of a status report that answers one
+#define RH_FRAGMENT_TYPE_POLL_FLAG 0x80
+
+/// Octets of RHFragmentedDatagram header before the data in each fragment:
+/// type, total length and offset (little endian), and fragment size
+#define RH_FRAGMENT_HEADER_LEN 6
+
+/// The default time in milliseconds to wait for a status report
+#define RH_FRAGMENT_DEFAULT_TIMEOUT 200
+
+/// The default number of times to ask again for a lost status report
+#define RH_FRAGMENT_DEFAULT_RETRIES 3
+
+/// How many fragments past the first missing one the receiver keeps track of, and so the most
+/// the sender sends before it asks which have arrived. A multiple of 8. Each 8 cost 1 octet of RAM
+/// in the sender and 1 in the receiver.
+/// Can be pre-defined prior to including this header
+#ifndef RH_FRAGMENT_WINDOW
+ #if defined(__AVR__)
+  #define RH_FRAGMENT_WINDOW 32
+ #else
+  #define RH_FRAGMENT_WINDOW 64
+ #endif
+#endif
+
+/// Octets in the built in reassembly buffer, used until setReceiveBuffer() is called.
+/// 0 leaves it out, and only setReceiveBuffer() or setStreamCallback() can receive transfers.
+/// Can be pre-defined prior to including this header
+#ifndef RH_FRAGMENT_POOL_SIZE
+ #if defined(__AVR__)
+  #define RH_FRAGMENT_POOL_SIZE 0
+ #else
+  #define RH_FRAGMENT_POOL_SIZE 1024
+ #endif
+#endif
+
+/// How long in milliseconds the receiver waits to hear more of an unfinished transfer before it will
+/// start one from a different node.
+/// Can be pre-defined prior to including this header
+#ifndef RH_FRAGMENT_IDLE_TIMEOUT
+ #define RH_FRAGMENT_IDLE_TIMEOUT 2000
+#endif
+
+/////////////////////////////////////////////////////////////////////
+/// \class RHFragmentedDatagram RHFragmentedDatagram.h <RHFragmentedDatagram.h>
+/// \brief RHDatagram subclass for sending messages longer than the driver can carry
+///
+/// Manager class that extends RHDatagram to send transfers of up to 65535 octets, by splitting them
+/// into fragments that each fit in one message. The receiver reassembles them, in whatever order
+/// they arrive, and the sender retransmits only the fragments that were lost.
+///
+/// Each fragment carries its offset in the transfer and the total length, so the receiver can put
+/// it in place as soon as it arrives. The ID header identifies the transfer.
+/// The receiver reports the number of the first fragment it is missing, how many more it has room for,
+/// and a bitmap of those it already has, each time half of that room has been used.
+/// The sender keeps sending as long as the last report says there is room, and so does not stop
+/// on a good link. At the end of the room it asks for a report, waits for it, and then sends the
+/// missing fragments and the next ones there is room for, and so on until the receiver has them all.
+/// If the reply is lost, the sender asks again up to setRetries() times.
+/// So there is one report per RH_FRAGMENT_WINDOW / 2 fragments instead of an ACK
+/// for each one, and a lost fragment costs only its own retransmission.
+///
+/// \par Receiving
+///
+/// The receiver reassembles into a buffer given to setReceiveBuffer(), or else into a built in
+/// buffer of RH_FRAGMENT_POOL_SIZE octets. recvfromTransfer() returns the whole transfer when it is complete.
+/// The data can also be delivered as it arrives, in order, to a function given to setStreamCallback().
+/// Then a transfer may be longer than the buffer: the buffer holds only the fragments received past the
+/// first missing one, and the sender is told how many fit. With no buffer at all, fragments are only
+/// accepted in order, one at a time.
+///
+/// The receiver handles one transfer at a time. Fragments from other nodes are ignored (and retransmitted
+/// later by them) until it is complete, or until nothing has been heard of it for RH_FRAGMENT_IDLE_TIMEOUT.
+///
+/// \par Compatibility
+///
+/// RHFragmentedDatagram uses the first octet of each message to tell its messages apart, so it does not
+/// understand, and must not be mixed on the same addresses with, other managers such as RHReliableDatagram.
+/// Messages to RH_BROADCAST_ADDRESS are sent once, without asking for status reports.
+///
+/// \par Media Access Strategy
+///
+/// Fragments are transmitted back to back, and status reports immediately.
+class RHFragmentedDatagram : public RHDatagram
+{
+public:
+    /// Function that supplies the data of a transfer sent with sendtoWait(SourceCallback, ...).
+    /// It may be asked for the same data more than once, when fragments are retransmitted.
+    /// \param[in] context The context passed to sendtoWait()
+    /// \param[in] offset Offset in the transfer of the first octet wanted
+    /// \param[out] buf Where to put the data
+    /// \param[in] len Number of octets wanted
+    typedef void (*SourceCallback)(void* context, uint16_t offset, uint8_t* buf, uint8_t len);
+
+    /// Function that is given the data of a transfer being received, in order, as it arrives.
+    /// It must not send or receive through this manager.
+    /// \param[in] context The context passed to setStreamCallback()
+    /// \param[in] from The address of the sending node
+    /// \param[in] offset Offset in the transfer of the first octet in buf
+    /// \param[in] buf The data
+    /// \param[in] len Number of octets in buf
+    /// \param[in] total Total length of the transfer
+    typedef void (*StreamCallback)(void* context, uint8_t from, uint16_t offset, const uint8_t* buf, uint16_t len, uint16_t total);
+
+    /// Constructor.
+    /// \param[in] driver The RadioHead driver to use to transport messages.
+    /// \param[in] thisAddress The address to assign to this node. Defaults to 0
+    RHFragmentedDatagram(RHGenericDriver& driver, uint8_t thisAddress = 0);
+
+    /// Sets the time to wait for a status report before asking again.
+    /// \param[in] timeout The new timeout period in milliseconds
+    void setTimeout(uint16_t timeout);
+
+    /// Sets how many times to ask again for a status report, and how many reports in a row
+    /// may show no progress, before sendtoWait() gives up.
+    /// \param[in] retries The new number of retries
+    void setRetries(uint8_t retries);
+
+    /// Sets the buffer to reassemble received transfers in, instead of the built in one.
+    /// Do not change it while a transfer is being received.
+    /// \param[in] buf The buffer, or NULL to go back to the built in one
+    /// \param[in] size Octets available in buf
+    void setReceiveBuffer(uint8_t* buf, uint16_t size);
+
+    /// Sets a function to be given the data of received transfers, in order, as it arrives.
+    /// With one, transfers longer than the receive buffer can be received.
+    /// \param[in] callback The function, or NULL for none
+    /// \param[in] context Passed to callback
+    void setStreamCallback(StreamCallback callback, void* context = NULL);
+
+    /// Returns the most data a single fragment can carry with the driver in use
+    /// \return octets of data per fragment
+    uint8_t fragmentSize();
+
+    /// Sends a transfer to the node with the given address, and waits until the receiver has it all.
+    /// Status reports and fragments from other nodes received in the meantime are handled.
+    /// \param[in] buf Pointer to the data to send
+    /// \param[in] len Number of octets to send (> 0)
+    /// \param[in] address The address to send it to.
+    /// \return true if the receiver has the whole transfer, or it was broadcast. false if
+    /// it gave up, or the receiver cannot take a transfer that long
+    bool sendtoWait(const uint8_t* buf, uint16_t len, uint8_t address);
+
+    /// Like sendtoWait(const uint8_t*, uint16_t, uint8_t), but the data is read by source as it is needed,
+    /// so it does not have to be in memory all at once.
+    /// \param[in] source Function that supplies the data
+    /// \param[in] context Passed to source
+    /// \param[in] len Number of octets to send (> 0)
+    /// \param[in] address The address to send it to.
+    /// \return true if the receiver has the whole transfer, or it was broadcast.
+    bool sendtoWait(SourceCallback source, void* context, uint16_t len, uint8_t address);
+
+    /// Handles any received fragments and status requests, and returns a transfer if one is complete.
+    /// You must call this often enough to keep up with the sender.
+    /// \param[out] buf If not NULL, set to point to the reassembled transfer, which stays valid until the next
+    /// call to recvfromTransfer() or sendtoWait(). Set to NULL if the transfer was longer than the receive buffer,
+    /// and was only given to the stream callback.
+    /// \param[out] len If not NULL, set to the length of the transfer
+    /// \param[out] from If not NULL, set to the address of the sending node
+    /// \return true if a transfer was completed
+    bool recvfromTransfer(const uint8_t** buf, uint16_t* len, uint8_t* from = NULL);
+
+    /// Like recvfromTransfer(), but waits up to timeout milliseconds for a transfer to be completed.
+    /// \param[out] buf See recvfromTransfer()
+    /// \param[out] len See recvfromTransfer()
+    /// \param[in] timeout Maximum time to wait in milliseconds
+    /// \param[out] from See recvfromTransfer()
+    /// \return true if a transfer was completed
+    bool recvfromTransferTimeout(const uint8_t** buf, uint16_t* len, uint16_t timeout, uint8_t* from = NULL);
+
+    /// Returns the number of fragments that have been retransmitted since startup or the last
+    /// resetRetransmissions()
+    /// \return The number of retransmitted fragments
+    uint32_t retransmissions();
+
+    /// Resets the count of retransmitted fragments to 0.
+    void resetRetransmissions();
+
+protected:
+    /// Sends a transfer, the data coming from buf or source
+    bool sendTransfer(const uint8_t* buf, SourceCallback source, void* context, uint16_t len, uint8_t address);
+
+    /// Sends one fragment of the transfer being sent
+    void sendFragment(const uint8_t* buf, SourceCallback source, void* context, uint16_t index, bool poll);
+
+    /// Waits for a reply to the last status request about the transfer being sent, asking again if it is lost
+    /// \return true if one was received
+    bool waitStatus();
+
+    /// Returns the first fragment from index that the receiver has not reported having
+    uint16_t nextMissing(uint16_t index);
+
+    /// Returns how many fragments the receiver has reported having
+    uint16_t reportedFragments();
+
+    /// Receives and handles one message, if there is one
+    void receive();
+
+    /// Handles a fragment
+    /// \return true if a status report should be sent
+    bool receiveData(uint8_t from, uint8_t id, const uint8_t* buf, uint8_t len);
+
+    /// Handles a status report
+    void receiveStatus(uint8_t from, uint8_t id, const uint8_t* buf, uint8_t len);
+
+    /// Finds or starts the transfer a fragment or status request belongs to
+    /// \return true if it belongs to the transfer being received
+    bool receiveTransfer(uint8_t from, uint8_t id, uint16_t total, uint8_t fragSize);
+
+    /// Returns how many fragments from the first missing one can be accepted
+    uint16_t receiveWindow();
+
+    /// Hands the fragments received in order to the stream callback and moves past them
+    /// \return true if the transfer has just been completed
+    bool receiveAdvance();
+
+    /// Sends a status report about the transfer being received
+    /// \param[in] reply true if it answers a status request
+    void sendStatus(bool reply);
+
+private:
+    /// Time to wait for a status report
+    uint16_t        _timeout;
+
+    /// Number of retries
+    uint8_t         _retries;
+
+    /// Count of fragments retransmitted
+    uint32_t        _retransmissions;
+
+    /// ID of the last transfer sent
+    uint8_t         _lastTransferId;
+
+    // The transfer being sent
+    bool            _txActive;
+    uint8_t         _txAddress;
+    uint8_t         _txId;
+    uint16_t        _txLen;
+    uint8_t         _txFragSize;
+    uint16_t        _txFragments;
+    uint16_t        _txSent;      ///< Fragments sent at least once
+    uint16_t        _txBase;      ///< First fragment the receiver is missing
+    uint16_t        _txCount;     ///< Fragments from _txBase the receiver has room for
+    bool            _txStatus;    ///< A reply to a status request has been received
+    uint8_t         _txBits[RH_FRAGMENT_WINDOW / 8]; ///< Fragments from _txBase the receiver has
+
+    // The transfer being received
+    bool            _rxActive;
+    bool            _rxComplete;
+    bool            _rxReady;     ///< Complete, and not yet returned by recvfromTransfer()
+    uint8_t         _rxFrom;
+    uint8_t         _rxId;
+    uint16_t        _rxTotal;
+    uint8_t         _rxFragSize;
+    uint16_t        _rxFragments;
+    uint16_t        _rxBase;      ///< First fragment missing
+    uint16_t        _rxReported;  ///< _rxBase in the last status report
+    uint16_t        _rxOrigin;    ///< Offset in the transfer of _rxBuf[0]
+    unsigned long   _rxHeard;     ///< When the transfer was last heard from
+    uint8_t         _rxBits[RH_FRAGMENT_WINDOW / 8]; ///< Fragments from _rxBase already received
+
+    /// Buffer for reassembly
+    uint8_t*        _rxBuf;
+    uint16_t        _rxBufSize;
+
+    /// Function to give the data to as it arrives
+    StreamCallback  _streamCallback;
+    void*           _streamContext;
+
+#if RH_FRAGMENT_POOL_SIZE
+    /// The built in reassembly buffer
+    uint8_t         _pool[RH_FRAGMENT_POOL_SIZE];
+#endif
+};
+
+#endif
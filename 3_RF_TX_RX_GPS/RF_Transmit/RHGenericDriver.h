@@ -17,6 +17,97 @@
 // Default timeout for waitCAD() in ms
 #define RH_CAD_DEFAULT_TIMEOUT            10000
 
+/// Set to 1 to measure how long each driver interrupt handler takes, see isrStats().
+/// Costs a few clocks and about 50 octets of SRAM per driver when enabled, nothing when not.
+/// Can be pre-defined prior to including this header
+#ifndef RH_ISR_STATS
+ #define RH_ISR_STATS 0
+#endif
+
+/// Number of buckets in the interrupt handler time histogram. Bucket 0 counts handlers that
+/// took fewer than 64 clocks, bucket n fewer than 64 << n clocks, and the last bucket all the rest.
+/// On AVR the clock only advances in steps of 64, so bucket 0 counts the handlers timed as 0
+#define RH_ISR_STATS_BUCKETS 8
+
+#if RH_ISR_STATS
+ // The clock used to time interrupt handlers, its rate in Hz, and the bits of it that count
+ #if (RH_PLATFORM == RH_PLATFORM_UNIX)
+  // clock_gettime(CLOCK_MONOTONIC), in ns
+  #include <time.h>
+  #define RH_ISR_CLOCK_HZ   1000000000UL
+  #define RH_ISR_CLOCK_MASK 0xffffffffUL
+ #elif defined(RH_PLATFORM_ATTINY)
+  // RH_ASK takes over Timer 0 on ATtiny, with its own prescaler and wrap, so there is no clock to use
+  #error RH_ISR_STATS is not supported on ATtiny
+ #elif defined(__AVR__)
+  // TCNT0 in CPU clocks. Arduino runs Timer 0 with a prescaler of 64, so TCNT0 wraps every 16384
+  // clocks, which is longer than any interrupt handler should take. Times are only measured in
+  // steps of 64 clocks (see RH_ISR_STATS_BUCKETS)
+  #define RH_ISR_CLOCK_HZ   F_CPU
+  #define RH_ISR_CLOCK_MASK 0x3fffUL
+ #elif defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+  // DWT cycle counter on Cortex-M3, M4 and M7, in CPU clocks
+  #define RH_ISR_CLOCK_HZ   F_CPU
+  #define RH_ISR_CLOCK_MASK 0xffffffffUL
+ #else
+  // Anything else, including Cortex-M0 which has no cycle counter: micros()
+  #define RH_ISR_CLOCK_HZ   1000000UL
+  #define RH_ISR_CLOCK_MASK 0xffffffffUL
+ #endif
+ /// Put at the start of an interrupt handler to time it
+ #define RH_ISR_STATS_START uint32_t isrStatsStart = RHGenericDriver::isrClock();
+ /// Put at the end of an interrupt handler to record in the stats of driver how long it took
+ /// since RH_ISR_STATS_START
+ #define RH_ISR_STATS_END(driver) (driver)->isrStatsRecord(isrStatsStart);
+#else
+ #define RH_ISR_STATS_START
+ #define RH_ISR_STATS_END(driver)
+#endif
+
+/// Set to 1 to keep the airtime and latency statistics returned by stats(). The message counts are
+/// always kept. Costs about 200 octets of SRAM per driver and a few us per message when enabled.
+/// 1 by default, except on AVR where SRAM is short.
+/// Can be pre-defined prior to including this header
+#ifndef RH_DRIVER_STATS
+ #if defined(__AVR__)
+  #define RH_DRIVER_STATS 0
+ #else
+  #define RH_DRIVER_STATS 1
+ #endif
+#endif
+
+/// Number of buckets in the latency histograms of stats(). Bucket 0 counts messages that took fewer
+/// than 64 us, bucket n fewer than 64 << n us, and the last bucket all the rest (about 1 s and more)
+#define RH_DRIVER_STATS_BUCKETS 16
+
+/// Set to 1 to make waitAvailable(), waitAvailableTimeout() and waitPacketSent() sleep between polls
+/// of the driver, until its interrupt handler calls notifyEvent() or the timeout expires, instead of
+/// spinning. On Linux the wait is on a pthread condition variable, on Arduino ARM (SAMD, SAM, STM32
+/// and Teensy) the CPU waits for an interrupt with WFE. 1 by default on those platforms.
+/// Can be pre-defined prior to including this header
+#ifndef RH_WAIT_EVENTS
+ #if (RH_PLATFORM == RH_PLATFORM_UNIX) || (RH_PLATFORM == RH_PLATFORM_RASPI)
+  #define RH_WAIT_EVENTS 1
+ #elif (RH_PLATFORM == RH_PLATFORM_ARDUINO) && defined(__arm__) \
+     && (defined(ARDUINO_ARCH_SAMD) || defined(ARDUINO_ARCH_SAM) || defined(ARDUINO_ARCH_STM32) || defined(TEENSYDUINO))
+  // These all run millis() from the SysTick interrupt, so WFE always wakes within 1 ms
+  #define RH_WAIT_EVENTS 1
+ #else
+  #define RH_WAIT_EVENTS 0
+ #endif
+#endif
+
+/// On Linux, drivers whose interrupt handler does not call notifyEvent() (such as drivers that are polled)
+/// are polled this often in ms by the wait functions. On Arduino ARM they are polled after every interrupt.
+/// Can be pre-defined prior to including this header
+#ifndef RH_WAIT_POLL_MS
+ #define RH_WAIT_POLL_MS 1
+#endif
+
+#if RH_WAIT_EVENTS && ((RH_PLATFORM == RH_PLATFORM_UNIX) || (RH_PLATFORM == RH_PLATFORM_RASPI))
+ #include <pthread.h>
+#endif
+
 /////////////////////////////////////////////////////////////////////
 /// \class RHGenericDriver RHGenericDriver.h <RHGenericDriver.h>
 /// \brief Abstract base class for a RadioHead driver.
@@ -38,6 +129,57 @@
 /// -ID A message ID, distinct (over short time scales) for each message sent by a particilar node
 /// -FLAGS A bitmask of flags. The most significant 4 bits are reserved for use by RadioHead. The least
 /// significant 4 bits are reserved for applications.
+///
+/// \par Waiting
+///
+/// waitAvailable(), waitAvailableTimeout() and waitPacketSent() poll the driver with available() or mode().
+/// With RH_WAIT_EVENTS, which is the default on Linux and Arduino ARM, they sleep between polls instead of spinning.
+/// Drivers that take interrupts from the radio (RH_RF95, RH_RF22, RH_RF69, RH_RF24, RH_CC110, RH_MRF89 and RH_ASK)
+/// call notifyEvent() from their interrupt handler, which wakes the waiting code within microseconds.
+/// On Linux the interrupt handler must run in a thread of its own (not a signal handler), and
+/// the waiting thread uses no CPU until it is woken or the timeout expires. Drivers that are polled, such as
+/// RH_NRF24, are polled every RH_WAIT_POLL_MS on Linux, and after each interrupt (at least every SysTick)
+/// on Arduino ARM, rather than continuously.
+///
+/// \par Sending asynchronously
+///
+/// send() starts a transmission, but the usual pattern of send() then waitPacketSent() blocks until it has finished.
+/// sendAsync() starts a transmission and returns at once, and service() calls a callback function when it has
+/// finished, so the application can get on with other things in the meantime. Call service() often, eg in loop().
+/// The radios whose interrupt handler sees the end of a transmission (RH_RF95, RH_RF22, RH_RF69, RH_RF24 and RH_MRF89),
+/// RH_ASK and RH_TCP really do send asynchronously. Other drivers wait in sendAsync() for the transmission to finish,
+/// and call the callback before they return.
+/// Only one transmission can be in progress at once (except with RH_ASK, which has a transmit queue), so sendAsync() and
+/// send() first wait for any earlier transmission to finish, and sendAsync() calls its callback before starting the new one.
+/// The callback is called at user level, not from the interrupt handler, so it may do anything, including
+/// calling sendAsync() again.
+///
+/// \par Receiving without copying
+///
+/// recv() copies each message out of the driver into the application's buffer. recvView() instead returns
+/// a pointer to the message where it lies in the driver's own receive buffer, which stays valid (and
+/// headerTo() etc stay the same) until release(). RH_ASK keeps the message's slot in its receive queue, and the
+/// other drivers that support this (RH_RF95, RH_NRF24, RH_Serial and RH_TCP) hold off the receiver, so that
+/// nothing overwrites it in the meantime: call release() as soon as you are finished with it. Messages may still
+/// be sent while a view is held. Other drivers copy the message into a buffer supplied by the caller, so
+/// code written for recvView() works with all drivers, copying each message at most once.
+/// RHDatagram, RHReliableDatagram and RHRouter use this to avoid copying messages more than once
+/// on their way to the application, or to the next hop.
+///
+/// \par Statistics
+///
+/// rxGood(), rxBad() and txGood() are 16 bit, and wrap within hours on a busy gateway. stats() returns
+/// 32 bit versions of them, the count of messages lost because the application did not collect them in time,
+/// the time spent transmitting and receiving, and histograms of how long messages wait between the interrupt
+/// handler receiving them and recv() collecting them, and between send() and the end of their transmission.
+/// It copies them with interrupts disabled, so the snapshot is consistent, and optionally starts counting again.
+/// Airtime and latencies are only kept with RH_DRIVER_STATS. Latencies are measured with micros().
+/// The radios (RH_RF95, RH_RF22, RH_RF69, RH_RF24, RH_CC110, RH_MRF89) count transmit airtime from when
+/// send() starts the transmitter, which is also their send() to sent latency, as they have no transmit queue.
+/// RH_CC110 has no interrupt at the end of a transmission, so counts it when waitPacketSent() sees it finish.
+/// They do not know when a message started arriving, so do not count receive airtime. RH_ASK works out both
+/// from the bit rate: the whole transmission including the preamble, and received messages from the end of
+/// their start symbol.
 class RHGenericDriver
 {
 public:
@@ -83,6 +225,21 @@ public:
     /// \return true if a valid message was copied to buf
     virtual bool recv(uint8_t* buf, uint8_t* len) = 0;
 
+    /// Like recv(), but returns a pointer to the message in the driver's receive buffer instead of
+    /// copying it. The message is held, and the pointer stays valid, until release() is called.
+    /// Drivers that cannot lend out their buffer copy the message into copy instead (or discard it if copy is NULL).
+    /// Calling recvView() again before release() returns the same message.
+    /// \param[out] buf Set to point to the message
+    /// \param[out] len Set to the length of the message
+    /// \param[in] copy Location to copy the message if the driver cannot lend out its buffer, or NULL
+    /// \param[in] copyLen Available space in copy
+    /// \return true if there was a valid message. If false, there is no need to call release()
+    virtual bool recvView(const uint8_t** buf, uint8_t* len, uint8_t* copy = NULL, uint8_t copyLen = 0);
+
+    /// Releases the message returned by recvView(), so the driver can receive into its buffer again.
+    /// Does nothing if no message is held.
+    virtual void release();
+
     /// Waits until any previous transmit packet is finished being transmitted with waitPacketSent().
     /// Then optionally waits for Channel Activity Detection (CAD) 
     /// to show the channnel is clear (if the radio supports CAD) by calling waitCAD().
@@ -96,6 +253,24 @@ public:
     /// if CAD was requested and the CAD timeout timed out before clear channel was detected.
     virtual bool send(const uint8_t* data, uint8_t len) = 0;
 
+    /// Function called by service() when a message sent with sendAsync() has been transmitted
+    /// \param[in] context The context passed to sendAsync()
+    typedef void (*SendCallback)(void* context);
+
+    /// Starts sending a message like send(), but returns without waiting for the transmission to finish.
+    /// When it has finished, service() calls callback. Drivers that cannot tell when a transmission
+    /// has finished without waiting for it wait here, and call callback before they return.
+    /// \param[in] data Array of data to be sent
+    /// \param[in] len Number of bytes of data to send (> 0)
+    /// \param[in] callback Function to call when the message has been transmitted, or NULL
+    /// \param[in] context Passed to callback
+    /// \return true if the message was started. If false, callback will not be called
+    virtual bool sendAsync(const uint8_t* data, uint8_t len, SendCallback callback = NULL, void* context = NULL);
+
+    /// Calls the callback of any message sent with sendAsync() that has finished transmitting.
+    /// Call this often, eg in loop().
+    virtual void service();
+
     /// Returns the maximum message length 
     /// available in this Driver.
     /// \return The maximum legal message length
@@ -234,6 +409,7 @@ public:
     /// which were rejected and not delivered to the application.
     /// Caution: not all drivers can correctly report this count. Some underlying hardware only report
     /// good packets.
+    /// This and rxGood() and txGood() are the low 16 bits of the counts in stats().
     /// \return The number of bad packets received.
     virtual uint16_t       rxBad();
 
@@ -247,7 +423,115 @@ public:
     /// \return The number of packets successfully transmitted
     virtual uint16_t       txGood();
 
+    /// \brief Driver statistics, returned by stats()
+    ///
+    /// Airtimes and latencies are all 0 unless RH_DRIVER_STATS is enabled, or the driver does not measure them
+    typedef struct
+    {
+	uint32_t elapsed;     ///< Time in ms since the stats were reset, for working out duty cycles and rates
+	uint32_t rxGood;      ///< Good messages received, as for rxGood()
+	uint32_t rxBad;       ///< Corrupted messages received, as for rxBad()
+	uint32_t txGood;      ///< Messages transmitted, as for txGood()
+	uint32_t rxOverflow;  ///< Messages lost because there was nowhere to put them, eg a full receive queue
+	uint32_t rxDropped;   ///< Messages dropped by the driver because they were for another node
+	uint64_t rxAirtime;   ///< Total time spent receiving messages, good or bad, in us
+	uint64_t txAirtime;   ///< Total time spent transmitting, in us
+	uint32_t rxLatencyMax; ///< Longest time from the interrupt handler receiving a message to recv() collecting it, in us
+	uint32_t txLatencyMax; ///< Longest time from send() to the end of the transmission, in us
+	uint32_t rxLatency[RH_DRIVER_STATS_BUCKETS]; ///< Messages by receive latency: bucket n took less than 64 << n us
+	uint32_t txLatency[RH_DRIVER_STATS_BUCKETS]; ///< Messages by transmit latency: bucket n took less than 64 << n us
+    } Stats;
+
+    /// Returns a snapshot of the driver statistics, so you can see how busy the channel is, and how long
+    /// messages take to get through the driver.
+    /// The stats are copied with interrupts disabled, so they are consistent.
+    /// \param[out] stats Where to put the stats
+    /// \param[in] reset If true, starts counting again after copying the stats. This also resets
+    /// rxGood(), rxBad() and txGood()
+    /// \return true if RH_DRIVER_STATS is enabled, false if only the message counts are available
+    bool                   stats(Stats* stats, bool reset = false);
+
+    /// \brief Interrupt handler timing statistics, returned by isrStats()
+    ///
+    /// Times are in clocks of RH_ISR_CLOCK_HZ: CPU clocks on AVR and Cortex-M3/M4/M7,
+    /// ns on Linux, and us elsewhere
+    typedef struct
+    {
+	uint32_t count;     ///< Number of interrupt handler calls timed
+	uint32_t min;       ///< Shortest handler time
+	uint32_t max;       ///< Longest handler time
+	uint32_t mean;      ///< Mean handler time
+	uint32_t overruns;  ///< Number of handler calls that took longer than the budget set by setIsrBudget()
+	uint32_t histogram[RH_ISR_STATS_BUCKETS]; ///< Calls by time: bucket n took less than 64 << n clocks
+    } IsrStats;
+
+    /// Returns how long the interrupt handler of this driver has been taking, so you can see how
+    /// much of the CPU it uses, and whether it keeps up with the bit rate.
+    /// Only available when RH_ISR_STATS is defined to 1.
+    /// The stats are copied with interrupts disabled, so they are consistent.
+    /// \param[out] stats Where to put the stats. All 0 if RH_ISR_STATS is not enabled
+    /// \param[in] reset If true, starts counting again after copying the stats
+    /// \return true if RH_ISR_STATS is enabled
+    bool                   isrStats(IsrStats* stats, bool reset = false);
+
+    /// Sets the longest time the interrupt handler may take before it is counted as an overrun in
+    /// IsrStats::overruns. Drivers with a periodic interrupt, such as RH_ASK, set this to the interrupt
+    /// period in init(). 0 means no budget
+    /// \param[in] clocks Handler time budget in clocks of RH_ISR_CLOCK_HZ
+    void                   setIsrBudget(uint32_t clocks);
+
+    /// Reads the clock used to time interrupt handlers. Used by RH_ISR_STATS_START
+    /// \return The clock in units of 1/RH_ISR_CLOCK_HZ, 0 if RH_ISR_STATS is not enabled
+    static uint32_t        isrClock();
+
+    /// dont call this it used by the interrupt handler, through RH_ISR_STATS_END
+    /// \param[in] start The isrClock() when the handler started
+    void                   isrStatsRecord(uint32_t start);
+
+    /// Wakes up anything waiting in waitAvailable(), waitAvailableTimeout() or waitPacketSent(),
+    /// so it polls the driver again. Drivers call this from their interrupt handler when a message
+    /// has been received or a transmission has finished. Spurious calls are harmless.
+    void                   notifyEvent();
+
 protected:
+    /// Reads the clock used for the airtime and latency statistics
+    /// \return micros(), or 0 if RH_DRIVER_STATS is not enabled
+    static uint32_t        statsClock();
+
+    /// Radios call this just before they start the transmitter in send()
+    void                   statsTxStart();
+
+    /// Radios call this from the interrupt handler at the end of a transmission started with statsTxStart()
+    void                   statsTxDone();
+
+    /// Records the end of a transmission in the stats
+    /// \param[in] sendTime The statsClock() when send() was called for the message
+    /// \param[in] airtime How long it took to transmit in us
+    void                   statsTxDone(uint32_t sendTime, uint32_t airtime);
+
+    /// Radios call this from the interrupt handler when a good message is ready for recv()
+    void                   statsRxDone();
+
+    /// Adds to the receive airtime
+    /// \param[in] airtime How long a message took to receive in us
+    void                   statsRxAirtime(uint32_t airtime);
+
+    /// Radios call this in recv() when they hand over the message from statsRxDone()
+    void                   statsRecv();
+
+    /// Records how long a message waited for recv()
+    /// \param[in] rxDoneTime The statsClock() when the interrupt handler received the message
+    void                   statsRecv(uint32_t rxDoneTime);
+
+    /// If the callback of a message sent with sendAsync() has not been called yet, waits for the
+    /// message to finish and calls it. sendAsync() calls this before starting another message
+    void                   sendAsyncFinish();
+
+    /// Sleeps until notifyEvent() is called, or until the timeout, whichever is first.
+    /// May return early (for example after any interrupt on ARM), so callers poll and wait again.
+    /// Without RH_WAIT_EVENTS, just YIELDs
+    /// \param[in] timeout Maximum time to sleep in ms. 0 means no limit
+    void                   waitEvent(uint16_t timeout);
 
     /// The current transport operating mode
     volatile RHMode     _mode;
@@ -286,13 +570,22 @@ protected:
     volatile int16_t     _lastRssi;
 
     /// Count of the number of bad messages (eg bad checksum etc) received
-    volatile uint16_t   _rxBad;
+    volatile uint32_t   _rxBad;
 
     /// Count of the number of successfully transmitted messaged
-    volatile uint16_t   _rxGood;
+    volatile uint32_t   _rxGood;
 
     /// Count of the number of bad messages (correct checksum etc) received
-    volatile uint16_t   _txGood;
+    volatile uint32_t   _txGood;
+
+    /// Count of messages lost because there was nowhere to put them
+    volatile uint32_t   _rxOverflow;
+
+    /// Count of messages dropped because they were for another node
+    volatile uint32_t   _rxDropped;
+
+    /// millis() when the stats were last reset
+    unsigned long       _statsSince;
     
     /// Channel activity detected
     volatile bool       _cad;
@@ -300,6 +593,56 @@ protected:
     /// Channel activity timeout in ms
     unsigned int        _cad_timeout;
 
+    /// True if the interrupt handler calls notifyEvent() whenever available() or mode() may have changed,
+    /// so the wait functions need not poll
+    bool                _eventDriven;
+
+    /// Set by notifyEvent(), cleared by waitEvent()
+    volatile bool       _eventPending;
+
+    /// True if send() returns as soon as the transmitter has started, and the interrupt handler takes
+    /// the driver out of RHModeTx when it has finished, so sendAsync() need not wait
+    bool                _asyncSend;
+
+    /// Callback of the message started by sendAsync(), until service() calls it
+    SendCallback        _sendCallback;
+
+    /// Context for _sendCallback
+    void*               _sendContext;
+
+    /// True while the message returned by recvView() is held for the application, until release()
+    bool                _rxView;
+
+#if RH_WAIT_EVENTS && ((RH_PLATFORM == RH_PLATFORM_UNIX) || (RH_PLATFORM == RH_PLATFORM_RASPI))
+    /// Protects _eventPending between the interrupt handler thread and waiting threads
+    pthread_mutex_t     _eventMutex;
+
+    /// Signalled by notifyEvent()
+    pthread_cond_t      _eventCond;
+#endif
+
+#if RH_DRIVER_STATS
+    /// Airtime and latency stats so far. The counts are kept in _rxGood etc
+    volatile Stats      _stats;
+
+    /// statsClock() when the transmitter was started by a radio
+    volatile uint32_t   _statsTxStart;
+
+    /// statsClock() when a radio received the message waiting for recv()
+    volatile uint32_t   _statsRxDone;
+#endif
+
+#if RH_ISR_STATS
+    /// Interrupt handler timing stats so far. mean holds nothing, it is worked out from _isrTotal
+    volatile IsrStats   _isrStats;
+
+    /// Total of all the handler times
+    volatile uint64_t   _isrTotal;
+
+    /// Interrupt handler time budget, see setIsrBudget()
+    uint32_t            _isrBudget;
+#endif
+
 private:
 
 };
@@ -14,6 +14,9 @@ RHNRFSPIDriver::RHNRFSPIDriver(uint8_t slaveSelectPin, RHGenericSPI& spi)
 
 bool RHNRFSPIDriver::init()
 {
+    if (!RHGenericDriver::init())
+	return false;
+
     // start the SPI library with the default speeds etc:
     // On Arduino Due this defaults to SPI1 on the central group of 6 SPI pins
     _spi.begin();
@@ -105,6 +108,23 @@ uint8_t RHNRFSPIDriver::spiBurstWrite(uint8_t reg, const uint8_t* src, uint8_t l
     return status;
 }
 
+uint8_t RHNRFSPIDriver::spiBurstWrite(uint8_t reg, const uint8_t* header, uint8_t headerLen, const uint8_t* src, uint8_t len)
+{
+    uint8_t status = 0;
+    ATOMIC_BLOCK_START;
+    _spi.beginTransaction();
+    digitalWrite(_slaveSelectPin, LOW);
+    status = _spi.transfer(reg); // Send the start address
+    while (headerLen--)
+	_spi.transfer(*header++);
+    while (len--)
+	_spi.transfer(*src++);
+    digitalWrite(_slaveSelectPin, HIGH);
+    _spi.endTransaction();
+    ATOMIC_BLOCK_END;
+    return status;
+}
+
 void RHNRFSPIDriver::setSlaveSelectPin(uint8_t slaveSelectPin)
 {
     _slaveSelectPin = slaveSelectPin;
@@ -32,9 +32,66 @@
 /// the default retry timeout in milliseconds
 #define RH_DEFAULT_TIMEOUT 200
 
+/// How many destinations the round trip times are remembered for, to adapt the retransmit timeout to each.
+/// Each costs 6 octets of RAM. 0 disables adaptive timeouts: the timeout is always the one set by setTimeout().
+/// Can be pre-defined prior to including this header
+#ifndef RH_RELIABLE_RTT_PEERS
+ #define RH_RELIABLE_RTT_PEERS 8
+#endif
+
+/// The shortest adaptive retransmit timeout in milliseconds. Can be pre-defined prior to including this header
+#ifndef RH_RELIABLE_MIN_TIMEOUT
+ #define RH_RELIABLE_MIN_TIMEOUT 20
+#endif
+
+/// The longest adaptive retransmit timeout in milliseconds, after backing off. Can be pre-defined prior to including this header
+#ifndef RH_RELIABLE_MAX_TIMEOUT
+ #define RH_RELIABLE_MAX_TIMEOUT 60000
+#endif
+
+/// The most times the adaptive retransmit timeout is doubled after timeouts in a row
+#define RH_RELIABLE_MAX_BACKOFF 6
+
 /// The default number of retries
 #define RH_DEFAULT_RETRIES 3
 
+/// The maximum number of messages sendtoWindow() can have waiting for ACKs, over all destinations.
+/// Each costs RH_RELIABLE_WINDOW_MESSAGE_LEN + 10 octets of RAM. The default 0 disables windowed sending,
+/// and window ACKs: sendtoWindow() is then the same as sendtoWait(). 8 is a good size if you have the RAM.
+/// Can be pre-defined prior to including this header
+#ifndef RH_RELIABLE_WINDOW
+ #define RH_RELIABLE_WINDOW 0
+#endif
+
+/// The longest message sendtoWindow() and sendtoQueue() can send, and the longest message that can be queued
+/// for the application while sending. Can be pre-defined prior to including this header
+#ifndef RH_RELIABLE_WINDOW_MESSAGE_LEN
+ #define RH_RELIABLE_WINDOW_MESSAGE_LEN RH_MAX_MESSAGE_LEN
+#endif
+
+/// The number of messages for this node that can be queued for the application while sending. Each costs
+/// RH_RELIABLE_WINDOW_MESSAGE_LEN + 5 octets of RAM. The default 0 discards them while sending, unacknowledged,
+/// as in earlier versions. Can be pre-defined prior to including this header
+#ifndef RH_RELIABLE_RECV_QUEUE
+ #define RH_RELIABLE_RECV_QUEUE 0
+#endif
+
+/// How many nodes sending to this one are remembered for duplicate detection and window ACKs.
+/// A power of 2 spreads them best. Each costs 8 octets of RAM. When there are more, the least recently
+/// heard from is forgotten, and a retransmission from it of a message already received would be delivered again.
+/// Can be pre-defined prior to including this header
+#ifndef RH_RELIABLE_SEEN_PEERS
+ #if defined(__AVR__)
+  #define RH_RELIABLE_SEEN_PEERS 8
+ #else
+  #define RH_RELIABLE_SEEN_PEERS 16
+ #endif
+#endif
+
+/// The number of earlier message IDs acknowledged by the bitmap in a window ACK. A window can have
+/// this many messages waiting for ACKs besides the latest one
+#define RH_RELIABLE_WINDOW_ACK_BITS 8
+
 /////////////////////////////////////////////////////////////////////
 /// \class RHReliableDatagram RHReliableDatagram.h <RHReliableDatagram.h>
 /// \brief RHDatagram subclass for sending addressed, acknowledged, retransmitted datagrams.
@@ -53,6 +110,8 @@
 ///
 /// The retransmit timeout is randomly varied between timeout and timeout*2 to prevent collisions on all
 /// retries when 2 nodes happen to start sending at the same time .
+/// Unless adaptive timeouts are disabled, the timeout for each destination is then adapted to its
+/// measured round trip time, see below.
 ///
 /// Each new message sent by sendtoWait() has its ID incremented.
 ///
@@ -62,6 +121,71 @@
 /// - ID set to the ID of the original message
 /// - FLAGS with the RH_FLAGS_ACK bit set
 /// - 1 octet of payload containing ASCII '!' (since some drivers cannot handle 0 length payloads)
+/// - Optionally (see below), 1 more octet acknowledging earlier messages from the same node
+///
+/// \par Duplicate detection
+///
+/// A message is retransmitted when its ACK is lost, so the receiver may get it more than once.
+/// The receiver remembers the last 32 IDs received from each of the last RH_RELIABLE_SEEN_PEERS nodes it
+/// has heard from, in a small table hashed by address. A retransmission (with RH_FLAGS_RETRY) of any of them,
+/// or a repeat of the latest, is acknowledged again but not returned by recvfromAck(), even when several
+/// messages are in flight at once or they arrive out of order. The first transmission of an older ID is
+/// returned, since a node that restarts starts its IDs again.
+///
+/// \par Windowed sending
+///
+/// sendtoWait() sends one message and waits for its ACK before the next can be sent, so on a fast link
+/// much of the time is spent waiting for the ACK to come back. sendtoWindow() returns as soon as the
+/// message has been transmitted, and keeps it until it is acknowledged, so up to window() messages to each
+/// destination can be waiting for ACKs at once. Each has its own retransmit timer, and is retransmitted
+/// up to retries() times like sendtoWait(). sendtoWindow() waits only when the window is full, and waitWindow()
+/// waits for all of them, telling whether any failed. While waiting, they queue incoming messages
+/// other than ACKs, like sendtoWait(). Messages may be delivered out of order when some are lost.
+/// The window slots take a lot of RAM, so windowed sending must be enabled by defining RH_RELIABLE_WINDOW
+/// to the number of slots, eg 8, when building RadioHead.
+///
+/// When RH_RELIABLE_WINDOW is not 0, the ACK sent by recvfromAck() has a second octet of payload,
+/// a bitmap of the RH_RELIABLE_WINDOW_ACK_BITS IDs before the one being acknowledged: bit n is set if ID-n-1 has been
+/// received from that node. So each ACK also acknowledges the earlier messages whose own ACKs were lost,
+/// and they need not be retransmitted. Nodes with older versions of RadioHead ignore the extra octet.
+/// They send 1 octet ACKs, which acknowledge only their own ID. They only recognise retries of the latest message
+/// from a node, so sendtoWindow() sends them one message at a time, until it gets a window ACK from them.
+/// Window ACKs also cost 1 octet more airtime.
+/// Radios are half duplex, and a sender that sends the next message while the receiver is sending its
+/// ACK loses both: setWindowGap() makes the sender wait for each ACK, but only for as long as it usually takes.
+///
+/// \par Sending without blocking
+///
+/// While sendtoWait() waits for an ACK from one node, other nodes can get no ACKs from this one.
+/// A gateway that serves many nodes can instead queue its messages with sendtoQueue(), and call service() often,
+/// eg in loop(). sendtoQueue() returns at once, and service() transmits the queued messages as their destinations'
+/// windows allow (see setWindow()), retransmits them when their ACK timers run out, and handles the
+/// incoming ACKs, so messages to different nodes do not wait for each other. A callback tells when each
+/// message has been acknowledged or has failed. Messages sent by sendtoWindow() and sendtoQueue() share the
+/// RH_RELIABLE_WINDOW slots. When RH_RELIABLE_WINDOW is 0, sendtoQueue() is the same as sendtoWait().
+///
+/// Messages for this node that arrive while sendtoWait(), sendtoWindow(), waitWindow() or service()
+/// is waiting for ACKs are acknowledged and queued, up to RH_RELIABLE_RECV_QUEUE of them, and are returned
+/// by recvfromAck() and available() before any new messages. When the queue is full, or RH_RELIABLE_RECV_QUEUE
+/// is 0 (the default), they are discarded without an ACK, so the sender retransmits them later.
+///
+/// \par Adaptive timeouts
+///
+/// The best timeout depends on the radio, the bit rate, the message length and how quickly the
+/// destination collects its messages. Too short, and messages are retransmitted when their ACK is
+/// merely late, too long and the sender sits idle after every lost message.
+/// So by default, sendtoWait() and sendtoWindow() measure the round trip time to each destination, from the end of
+/// the transmission to the arrival of its ACK, and keep a smoothed round trip time and its mean variation like TCP
+/// (Jacobson/Karels). The timeout is then the smoothed round trip time plus 4 times its variation, at least
+/// RH_RELIABLE_MIN_TIMEOUT, and randomly lengthened by up to a quarter. Following Karn's rule, the ACKs of
+/// retransmitted messages are not measured, since it is not known which transmission they acknowledge.
+/// Each retransmission of a message doubles the timeout for that destination, up to RH_RELIABLE_MAX_BACKOFF times
+/// and RH_RELIABLE_MAX_TIMEOUT. It stays backed off until a message gets through at the first attempt, or until
+/// a message fails altogether, so messages to a node that has gone away take no longer than the first.
+/// Until the first round trip to a destination is measured, the timeout set by setTimeout() is used, backed off
+/// in the same way, so a timeout that is too short still gets long enough to measure the round trip.
+/// The last RH_RELIABLE_RTT_PEERS destinations are remembered. rtt(), rttVariation() and retransmitTimeout()
+/// tell how a link is doing, and setAdaptiveTimeout(false) restores the fixed timeout.
 ///
 /// \par Media Access Strategy
 ///
@@ -74,12 +198,12 @@
 /// This will be recognised as "pure ALOHA". 
 /// The addition of Clear Channel Assessment (CCA) is desirable and planned.
 ///
-/// There is no message queuing or threading in RHReliableDatagram. 
+/// There is no threading in RHReliableDatagram. 
 /// sendtoWait() waits until an acknowledgement is received, retransmitting
 /// up to (by default) 3 retries time with a default 200ms timeout. 
 /// During this transmit-acknowledge phase, any received message (other than the expected
-/// acknowledgement) will be ignored. Your sketch will be unresponsive to new messages 
-/// until an acknowledgement is received or the retries are exhausted. 
+/// acknowledgement) will be queued, or ignored when the queue is full. Your sketch will not see new messages 
+/// until an acknowledgement is received or the retries are exhausted: use sendtoQueue() to avoid that. 
 /// Central server-type sketches should be very cautious about their
 /// retransmit strategy and configuration lest they hang for a long time
 /// trying to reply to clients that are unreachable.
@@ -98,7 +222,7 @@ public:
     /// \param[in] thisAddress The address to assign to this node. Defaults to 0
     RHReliableDatagram(RHGenericDriver& driver, uint8_t thisAddress = 0);
 
-    /// Sets the minimum retransmit timeout. If sendtoWait is waiting for an ack 
+    /// Sets the retransmit timeout. If sendtoWait is waiting for an ack 
     /// longer than this time (in milliseconds), 
     /// it will retransmit the message. Defaults to 200ms. The timeout is measured from the end of
     /// transmission of the message. It must be at least longer than the the transmit 
@@ -107,9 +231,33 @@ public:
     /// Caution: if you are using slow packet rates and long packets 
     /// you may need to change the timeout for reliable operations.
     /// The actual timeout is randomly varied between timeout and timeout*2.
+    /// With adaptive timeouts, this is only the timeout for destinations whose round trip time has not been
+    /// measured yet.
     /// \param[in] timeout The new timeout period in milliseconds
     void setTimeout(uint16_t timeout);
 
+    /// Enables or disables adapting the retransmit timeout to the round trip time to each destination.
+    /// Enabled by default, unless RH_RELIABLE_RTT_PEERS is 0.
+    /// \param[in] adaptive true to adapt the timeout, false to always use the timeout set by setTimeout()
+    void setAdaptiveTimeout(bool adaptive);
+
+    /// Returns the smoothed round trip time to a node, from the end of the transmission of a message
+    /// to the arrival of its ACK.
+    /// \param[in] address The node
+    /// \return The round trip time in milliseconds, or 0 if it has not been measured
+    uint16_t rtt(uint8_t address);
+
+    /// Returns the mean variation of the round trip time to a node
+    /// \param[in] address The node
+    /// \return The variation in milliseconds, or 0 if the round trip time has not been measured
+    uint16_t rttVariation(uint8_t address);
+
+    /// Returns the retransmit timeout that will be used for the next message to a node, including any backoff,
+    /// before the random lengthening.
+    /// \param[in] address The node
+    /// \return The timeout in milliseconds
+    uint16_t retransmitTimeout(uint8_t address);
+
     /// Sets the maximum number of retries. Defaults to 3 at construction time. 
     /// If set to 0, each message will only ever be sent once.
     /// sendtoWait will give up and return false if there is no ack received after all transmissions time out
@@ -134,6 +282,68 @@ public:
     /// \return true if the message was transmitted and an acknowledgement was received.
     bool sendtoWait(uint8_t* buf, uint8_t len, uint8_t address);
 
+    /// Sets the number of messages sendtoWindow() can have waiting for ACKs from each destination.
+    /// Defaults to 1, which sends one message at a time like sendtoWait(), but without waiting for the ACK.
+    /// \param[in] window The new window size, limited to RH_RELIABLE_WINDOW and RH_RELIABLE_WINDOW_ACK_BITS + 1
+    void setWindow(uint8_t window);
+
+    /// Returns the window size set by setWindow()
+    /// \return The maximum number of messages waiting for ACKs from each destination
+    uint8_t window();
+
+    /// Sets how long sendtoWindow() waits for the ACK of each message before it returns. Defaults to 0,
+    /// which sends messages back to back. On half duplex radios, the ACK of one message collides with
+    /// the next unless the sender leaves a gap for it: set the gap to the time the receiver takes
+    /// to ACK, ie its latency plus the airtime of the ACK. Messages whose ACK does not come in time are
+    /// retransmitted later, as usual, without holding up the rest.
+    /// \param[in] gap The gap in milliseconds
+    void setWindowGap(uint16_t gap);
+
+    /// Sends the message and returns without waiting for its acknowledgement. It is retransmitted
+    /// as necessary by later calls to sendtoWindow(), waitWindow() and recvfromAck().
+    /// If window() messages to the address are already waiting for ACKs, waits until one of them is
+    /// acknowledged or fails. Broadcasts are sent as by sendtoWait().
+    /// \param[in] buf Pointer to the binary message to send
+    /// \param[in] len Number of octets to send, up to RH_RELIABLE_WINDOW_MESSAGE_LEN
+    /// \param[in] address The address to send the message to.
+    /// \return true if the message was transmitted. Use waitWindow() to find whether it was acknowledged
+    bool sendtoWindow(uint8_t* buf, uint8_t len, uint8_t address);
+
+    /// Function called when a message queued by sendtoQueue() has been acknowledged, or its retries are exhausted
+    /// \param[in] context The context passed to sendtoQueue()
+    /// \param[in] acknowledged true if the message was acknowledged
+    typedef void (*AckCallback)(void* context, bool acknowledged);
+
+    /// Queues the message and returns without waiting. The message is transmitted when window() messages
+    /// to the address are not already waiting for ACKs, and retransmitted as necessary, by later calls
+    /// to service(), sendtoQueue(), sendtoWindow(), waitWindow() and recvfromAck().
+    /// Broadcasts are sent at once.
+    /// The callback is called from those functions. It may call sendtoQueue(), but not functions that wait.
+    /// \param[in] buf Pointer to the binary message to send
+    /// \param[in] len Number of octets to send, up to RH_RELIABLE_WINDOW_MESSAGE_LEN
+    /// \param[in] address The address to send the message to.
+    /// \param[in] callback Function to call when the message has been acknowledged or has failed, or NULL
+    /// \param[in] context Passed to callback
+    /// \return true if the message was queued. false if all RH_RELIABLE_WINDOW slots are in use, or it is too long
+    bool sendtoQueue(uint8_t* buf, uint8_t len, uint8_t address, AckCallback callback = NULL, void* context = NULL);
+
+    /// Transmits the messages queued by sendtoQueue(), retransmits those whose ACK timers have run out,
+    /// and handles incoming ACKs, without waiting. Messages for this node are acknowledged and queued
+    /// for recvfromAck(). Also calls the callbacks of messages sent with sendtoAsync().
+    /// Call this often, eg in loop(), while messages are queued
+    void service();
+
+    /// Retransmits messages sent by sendtoWindow() and sendtoQueue() as necessary until they have all been acknowledged,
+    /// or their retries are exhausted.
+    /// \return true if all the messages sent by sendtoWindow() and sendtoQueue() since the last call to
+    /// waitWindow() were acknowledged
+    bool waitWindow();
+
+    /// Returns the number of messages sent by sendtoWindow() and sendtoQueue() that are waiting to be
+    /// transmitted or for ACKs
+    /// \return The number of messages waiting
+    uint8_t windowPending();
+
     /// If there is a valid message available for this node, send an acknowledgement to the SRC
     /// address (blocking until this is complete), then copy the message to buf and return true
     /// else return false. 
@@ -157,6 +367,21 @@ public:
     /// - 3. There was a correctly addressed message but it was a duplicate of an earlier correctly received message
     bool recvfromAck(uint8_t* buf, uint8_t* len, uint8_t* from = NULL, uint8_t* to = NULL, uint8_t* id = NULL, uint8_t* flags = NULL);
 
+    /// Like recvfromAck(), but returns a pointer to the message in the driver's receive buffer, which stays
+    /// valid until release(), instead of copying it. See RHGenericDriver::recvView()
+    /// \param[out] buf Set to point to the message
+    /// \param[out] len Set to the length of the message
+    /// \param[in] from If present and not NULL, the referenced uint8_t will be set to the SRC address
+    /// \param[in] to If present and not NULL, the referenced uint8_t will be set to the DEST address
+    /// \param[in] id If present and not NULL, the referenced uint8_t will be set to the ID
+    /// \param[in] flags If present and not NULL, the referenced uint8_t will be set to the FLAGS
+    /// \param[in] copy Location to copy the message if the driver cannot lend out its buffer
+    /// \param[in] copyLen Available space in copy
+    /// \return true if there was a valid, new message for this node. If false, no message is held
+    /// Messages queued while sending are returned first
+    bool recvfromAckView(const uint8_t** buf, uint8_t* len, uint8_t* from = NULL, uint8_t* to = NULL, uint8_t* id = NULL, uint8_t* flags = NULL,
+			 uint8_t* copy = NULL, uint8_t copyLen = 0);
+
     /// Similar to recvfromAck(), this will block until either a valid message available for this node
     /// or the timeout expires. Starts the receiver automatically.
     /// You should be sure to call this function frequently enough to not miss any messages.
@@ -172,6 +397,21 @@ public:
     /// \return true if a valid message was copied to buf
     bool recvfromAckTimeout(uint8_t* buf, uint8_t* len,  uint16_t timeout, uint8_t* from = NULL, uint8_t* to = NULL, uint8_t* id = NULL, uint8_t* flags = NULL);
 
+    /// Releases the message returned by recvfromAckView()
+    void release();
+
+    /// Tests whether a message is available, either queued while sending or in the driver
+    /// \return true if recvfromAck() may have a message to return
+    bool available();
+
+    /// Starts the receiver and blocks until a message is available, see available()
+    void waitAvailable();
+
+    /// Starts the receiver and blocks until a message is available, see available(), or the timeout expires
+    /// \param[in] timeout Maximum time to wait in milliseconds.
+    /// \return true if a message is available
+    bool waitAvailableTimeout(uint16_t timeout);
+
     /// Returns the number of retransmissions 
     /// we have had to send since starting or since the last call to resetRetransmissions().
     /// \return The number of retransmissions since initialisation.
@@ -186,11 +426,153 @@ protected:
     /// Blocks until the ACK has been sent
     void acknowledge(uint8_t id, uint8_t from);
 
+    /// Returns the timeout to wait for an ACK from a node, randomly lengthened to prevent collisions
+    /// \param[in] address The node
+    /// \return The timeout in milliseconds
+    uint16_t ackTimeout(uint8_t address);
+
+#if RH_RELIABLE_RTT_PEERS
+    /// Round trip time estimates for a node
+    typedef struct
+    {
+	uint8_t       address;  ///< The node, or RH_BROADCAST_ADDRESS if unused
+	uint8_t       backoff;  ///< Number of times the timeout is doubled
+	uint16_t      srtt;     ///< Smoothed round trip time, in 1/8 milliseconds, 0 if not measured yet
+	uint16_t      rttvar;   ///< Mean variation of the round trip time, in 1/4 milliseconds
+    } RttPeer;
+
+    /// Finds the round trip time estimates for a node
+    /// \param[in] address The node
+    /// \param[in] create If true and the node is not known, replaces the oldest entry
+    /// \return The estimates, or NULL if the node is not known and create is false
+    RttPeer* rttPeer(uint8_t address, bool create);
+#endif
+
+    /// Updates the round trip time estimates for a node with the time taken by an ACK
+    /// to a message that was transmitted only once
+    /// \param[in] address The node
+    /// \param[in] rtt The measured round trip time in milliseconds
+    void rttSample(uint8_t address, unsigned long rtt);
+
+    /// Backs off the retransmit timeout for a node after an ACK timeout
+    /// \param[in] address The node
+    /// \param[in] tries The number of times the message has been transmitted
+    void rttTimedOut(uint8_t address, uint8_t tries);
+
+    /// Decides whether a message that is not an ACK is a new one, to be returned to the application.
+    /// Messages for this node are acknowledged, unless they are new and there is no room for them
+    /// \param[in] from The FROM header of the message
+    /// \param[in] to The TO header of the message
+    /// \param[in] id The ID header of the message
+    /// \param[in] flags The FLAGS header of the message
+    /// \param[in] room false if new messages cannot be kept, so they are not acknowledged
+    /// \return true if the message is new and room is true
+    bool acceptMessage(uint8_t from, uint8_t to, uint8_t id, uint8_t flags, bool room);
+
+    /// Receives a message from the driver while waiting for ACKs. ACKs are passed to
+    /// the window slots, and other messages for this node are acknowledged and queued if there is room
+    /// \param[in] address The node an ACK is being waited for by sendtoWait()
+    /// \param[in] id The ID of the message sendtoWait() is waiting for the ACK of
+    /// \return true if it was the ACK sendtoWait() is waiting for
+    bool receiveWhileSending(uint8_t address, uint8_t id);
+
     /// Checks whether the message currently in the Rx buffer is a new message, not previously received
     /// based on the from address and the sequence.  If it is new, it is acknowledged and returns true
     /// \return true if there is a message received and it is a new message
     bool haveNewMessage();
 
+#if RH_RELIABLE_WINDOW
+    /// A message sent by sendtoWindow() or sendtoQueue(), waiting to be transmitted or for its ACK
+    typedef struct
+    {
+	uint8_t       address;  ///< Destination, or RH_BROADCAST_ADDRESS if the slot is free
+	uint8_t       id;       ///< The message ID
+	uint8_t       tries;    ///< Number of times transmitted, 0 if queued
+	uint8_t       len;      ///< Length of buf
+	unsigned long sentAt;   ///< millis() at the end of the last transmission
+	uint16_t      timeout;  ///< The ACK timeout from sentAt, in milliseconds
+	AckCallback   callback; ///< Called when acknowledged or failed, or NULL
+	void*         context;  ///< Passed to callback
+	uint8_t       buf[RH_RELIABLE_WINDOW_MESSAGE_LEN]; ///< The message
+    } WindowSlot;
+
+    /// Transmits or retransmits the message in a window slot and starts its ACK timer
+    void windowTransmit(WindowSlot* slot);
+
+    /// Handles incoming messages, retransmits messages whose ACK timers have run out,
+    /// gives up on those whose retries are exhausted, and transmits queued messages
+    /// \param[in] wait First waits up to this many milliseconds for a message, or for the next ACK timer to run out
+    /// \param[in] retransmit If false, only handles incoming messages
+    void windowService(uint16_t wait, bool retransmit = true);
+
+    /// Transmits the queued messages that fit in their destination's window
+    void windowStart();
+
+    /// Returns the oldest queued message that fits in its destination's window
+    /// \return The slot, or NULL if there is none
+    WindowSlot* windowNext();
+
+    /// Tells whether the sender is leaving a gap for the ACK to the last new message, see setWindowGap()
+    bool windowGapping();
+
+    /// Frees a window slot and calls its callback
+    /// \param[in] slot The slot
+    /// \param[in] acked true if the message was acknowledged, false if its retries are exhausted
+    void windowDone(WindowSlot* slot, bool acked);
+
+    /// Frees the window slots of the messages acknowledged by an ACK
+    /// \param[in] from The node that sent the ACK
+    /// \param[in] id The ID acknowledged
+    /// \param[in] payload The payload of the ACK
+    /// \param[in] len The length of payload
+    void windowAcked(uint8_t from, uint8_t id, const uint8_t* payload, uint8_t len);
+
+    /// Returns the number of messages that can wait for ACKs from a node at once
+    uint8_t windowFor(uint8_t address);
+
+    /// Returns the number of messages to a node that have been transmitted and are waiting for ACKs
+    uint8_t windowInFlight(uint8_t address);
+#endif
+
+    /// IDs recently received from a node, for duplicate detection and window ACKs
+    typedef struct
+    {
+	uint8_t       address;  ///< The node, or RH_BROADCAST_ADDRESS if unused
+	uint8_t       id;       ///< The newest ID received from it
+	uint16_t      used;     ///< _seenClock when it was last heard from
+	uint32_t      seen;     ///< Bit n is set if ID id-n has been received
+    } SeenPeer;
+
+    /// Finds the IDs received from a node in the hashed table
+    /// \param[in] address The node
+    /// \param[in] create If true and the node is not known, replaces the least recently used entry
+    /// \return The entry, or NULL if the node is not known and create is false
+    SeenPeer* seenPeer(uint8_t address, bool create);
+
+    /// Records that a message has been received from a node
+    /// \param[in] from The node
+    /// \param[in] id The ID of the message
+    void recordSeen(uint8_t from, uint8_t id);
+
+    /// Tells whether a message has been received from a node recently
+    /// \param[in] from The node
+    /// \param[in] id The ID of the message
+    /// \return true if id is one of the last 32 IDs received from the node
+    bool wasSeen(uint8_t from, uint8_t id);
+
+#if RH_RELIABLE_RECV_QUEUE
+    /// A message received while sending, queued for the application
+    typedef struct
+    {
+	uint8_t       from;     ///< The FROM header
+	uint8_t       to;       ///< The TO header
+	uint8_t       id;       ///< The ID header
+	uint8_t       flags;    ///< The FLAGS header
+	uint8_t       len;      ///< Length of buf
+	uint8_t       buf[RH_RELIABLE_WINDOW_MESSAGE_LEN]; ///< The message
+    } QueuedMessage;
+#endif
+
 private:
     /// Count of retransmissions we have had to send
     uint32_t _retransmissions;
@@ -207,11 +589,62 @@ private:
     /// Defaults to 3
     uint8_t _retries;
 
-    /// Array of the last seen sequence number indexed by node address that sent it
+    /// True if the timeout adapts to the round trip time
+    bool _adaptiveTimeout;
+
+#if RH_RELIABLE_RTT_PEERS
+    /// Round trip times to the nodes sent to recently
+    RttPeer _rttPeers[RH_RELIABLE_RTT_PEERS];
+
+    /// The entry in _rttPeers to be replaced next
+    uint8_t _rttPeerNext;
+#endif
+
+    /// The IDs recently received from each node, hashed by address.
     /// It is used for duplicate detection. Duplicated messages are re-acknowledged when received 
     /// (this is generally due to lost ACKs, causing the sender to retransmit, even though we have already
     /// received that message)
-    uint8_t _seenIds[256];
+    SeenPeer _seenPeers[RH_RELIABLE_SEEN_PEERS];
+
+    /// Counts messages recorded in _seenPeers, to find the least recently used
+    uint16_t _seenClock;
+
+    /// Messages sendtoWindow() can have waiting for ACKs from each destination
+    uint8_t _window;
+
+    /// How long sendtoWindow() waits for each ACK, in milliseconds
+    uint16_t _windowGap;
+
+    /// True if a message sent by sendtoWindow() has failed since the last waitWindow()
+    bool _windowFailed;
+
+#if RH_RELIABLE_WINDOW
+    /// Messages sent by sendtoWindow(), waiting for ACKs
+    WindowSlot _windowSlots[RH_RELIABLE_WINDOW];
+
+    /// Bit n of octet n/8 is set when node n has sent a window ACK, so it recognises retries of earlier messages
+    uint8_t _windowNodes[32];
+
+    /// The last message transmitted for the first time
+    WindowSlot* _windowGapSlot;
+
+    /// millis() at the end of its transmission
+    unsigned long _windowGapStart;
+#endif
+
+#if RH_RELIABLE_RECV_QUEUE
+    /// Messages received while sending, for recvfromAck()
+    QueuedMessage _recvQueue[RH_RELIABLE_RECV_QUEUE];
+
+    /// Index of the oldest message in _recvQueue
+    uint8_t _recvQueueHead;
+
+    /// Number of messages in _recvQueue
+    uint8_t _recvQueueLen;
+
+    /// True if recvfromAckView() returned the oldest message in _recvQueue, until release()
+    bool _recvQueueView;
+#endif
 };
 
 /// @example rf22_reliable_datagram_client.pde
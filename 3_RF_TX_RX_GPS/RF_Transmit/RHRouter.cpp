@@ -205,13 +205,19 @@ void RHRouter::peekAtMessage(RoutedMessage* message, uint8_t messageLen)
 ////////////////////////////////////////////////////////////////////
 bool RHRouter::recvfromAck(uint8_t* buf, uint8_t* len, uint8_t* source, uint8_t* dest, uint8_t* id, uint8_t* flags)
 {  
-    uint8_t tmpMessageLen = sizeof(_tmpMessage);
+    const uint8_t* view;
+    uint8_t messageLen;
     uint8_t _from;
     uint8_t _to;
     uint8_t _id;
     uint8_t _flags;
-    if (RHReliableDatagram::recvfromAck((uint8_t*)&_tmpMessage, &tmpMessageLen, &_from, &_to, &_id, &_flags))
+    // Look at the message where it lies in the driver, so it is copied only once: to buf if its
+    // for us, or to _tmpMessage if it has to be routed. Other drivers copy it to _tmpMessage
+    if (RHReliableDatagram::recvfromAckView(&view, &messageLen, &_from, &_to, &_id, &_flags,
+					    (uint8_t*)&_tmpMessage, sizeof(_tmpMessage)))
     {
+	RoutedMessage* message = (RoutedMessage*)view; // Not modified until it is copied to _tmpMessage
+
 	// Here we simulate networks with limited visibility between nodes
 	// so we can test routing
 #ifdef RH_TEST_NETWORK
@@ -257,34 +263,43 @@ bool RHRouter::recvfromAck(uint8_t* buf, uint8_t* len, uint8_t* source, uint8_t*
 	}
 	else
 	{
+	    release();
 	    return false; // Pretend we got nothing
 	}
 #endif
 
-	peekAtMessage(&_tmpMessage, tmpMessageLen);
+	peekAtMessage(message, messageLen);
 	// See if its for us or has to be routed
-	if (_tmpMessage.header.dest == _thisAddress || _tmpMessage.header.dest == RH_BROADCAST_ADDRESS)
+	if (message->header.dest == _thisAddress || message->header.dest == RH_BROADCAST_ADDRESS)
 	{
 	    // Deliver it here
-	    if (source) *source  = _tmpMessage.header.source;
-	    if (dest)   *dest    = _tmpMessage.header.dest;
-	    if (id)     *id      = _tmpMessage.header.id;
-	    if (flags)  *flags   = _tmpMessage.header.flags;
-	    uint8_t msgLen = tmpMessageLen - sizeof(RoutedMessageHeader);
+	    if (source) *source  = message->header.source;
+	    if (dest)   *dest    = message->header.dest;
+	    if (id)     *id      = message->header.id;
+	    if (flags)  *flags   = message->header.flags;
+	    uint8_t msgLen = messageLen - sizeof(RoutedMessageHeader);
 	    if (*len > msgLen)
 		*len = msgLen;
-	    memcpy(buf, _tmpMessage.data, *len);
+	    memcpy(buf, message->data, *len);
+	    release();
 	    return true; // Its for you!
 	}
-	else if (   _tmpMessage.header.dest != RH_BROADCAST_ADDRESS
-		 && _tmpMessage.header.hops++ < _max_hops)
+	else if (   message->header.dest != RH_BROADCAST_ADDRESS
+		 && message->header.hops < _max_hops)
 	{
-	    // Maybe it has to be routed to the next hop
+	    // Maybe it has to be routed to the next hop. The driver has to be free to
+	    // receive the ACK from the next hop, so get it out of the driver first
+	    if (message != &_tmpMessage)
+		memcpy(&_tmpMessage, message, messageLen);
+	    release();
+	    _tmpMessage.header.hops++;
 	    // REVISIT: if it fails due to no route or unable to deliver to the next hop, 
 	    // tell the originator. BUT HOW?
-	    route(&_tmpMessage, tmpMessageLen);
+	    route(&_tmpMessage, messageLen);
+	    return false;
 	}
 	// Discard it and maybe wait for another
+	release();
     }
     return false;
 }
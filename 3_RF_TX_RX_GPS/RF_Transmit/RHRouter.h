@@ -288,6 +288,7 @@ protected:
     /// Lets sublasses peek at messages going 
     /// past before routing or local delivery.
     /// Called by recvfromAck() immediately after it gets the message from RHReliableDatagram
+    /// The message may still be in the driver's receive buffer (see RHGenericDriver::recvView()), so must not be modified.
     /// \param [in] message Pointer to the RHRouter message that was received.
     /// \param [in] messageLen Length of message in octets
     virtual void peekAtMessage(RoutedMessage* message, uint8_t messageLen);
@@ -5,6 +5,11 @@
 
 #include "RH_ASK.h"
 #include "RHCRC.h"
+#include "RHFEC.h"
+#if (RH_PLATFORM == RH_PLATFORM_UNIX)
+ #include <unistd.h>
+ #include <fcntl.h>
+#endif
 
 #ifndef __SAMD51__
 
@@ -35,25 +40,147 @@ static uint8_t symbols[] =
     0x23, 0x25, 0x26, 0x29, 0x2a, 0x2c, 0x32, 0x34
 };
 
-// This is the value of the start symbol after 6-bit conversion and nybble swapping
-#define RH_ASK_START_SYMBOL 0xb38
+// 6 bit to 4 bit symbol converter table, the reverse of symbols[]
+// Used by the receiver to decode each received 6 bit symbol in constant time.
+// Any 6 bit value that is not a valid symbol decodes to RH_ASK_INVALID_SYMBOL
+// On AVR it lives in flash and is read with pgm_read_byte
+#if defined(__AVR__)
+ #include <avr/pgmspace.h>
+ #define RH_ASK_PROGMEM PROGMEM
+ #define RH_ASK_READ_TABLE(t, i) pgm_read_byte(&(t)[(i)])
+#else
+ #define RH_ASK_PROGMEM
+ #define RH_ASK_READ_TABLE(t, i) ((t)[(i)])
+#endif
+RH_ASK_PROGMEM static const uint8_t symbols_6to4[64] =
+{
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff,    0,    1, 0xff,
+    0xff, 0xff, 0xff,    2, 0xff,    3,    4, 0xff,
+    0xff,    5,    6, 0xff,    7, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff,    8, 0xff,    9,   10, 0xff,
+    0xff,   11,   12, 0xff,   13, 0xff, 0xff, 0xff,
+    0xff, 0xff,   14, 0xff,   15, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+// Rate adaptation control message types, the first octet of the user data
+#define RH_ASK_RATE_REPORT  1 // Index of the sender's speed, frame error rate, messages counted
+#define RH_ASK_RATE_REQUEST 2 // Index of the speed the sender wants to change to
+#define RH_ASK_RATE_ACCEPT  3 // Index of the speed the sender agrees to change to
+
+// No speed index
+#define RH_ASK_RATE_NONE 0xff
 
-RH_ASK::RH_ASK(uint16_t speed, uint8_t rxPin, uint8_t txPin, uint8_t pttPin, bool pttInverted)
+// Octet i of a message contained an invalid symbol
+#define RH_ASK_ERASED(erasures, i) ((erasures)[(i) >> 3] & (1 << ((i) & 7)))
+
+RH_ASK::RH_ASK(uint16_t speed, uint8_t rxPin, uint8_t txPin, uint8_t pttPin, bool pttInverted, RxEngine rxEngine,
+	       LineCode lineCode)
     :
     _speed(speed),
     _rxPin(rxPin),
     _txPin(txPin),
     _pttPin(pttPin),
     _rxInverted(false),
-    _pttInverted(pttInverted)
+    _pttInverted(pttInverted),
+    _rxEngine(rxEngine),
+    _lineCode(lineCode),
+    _rxEdgePeriod(speed ? 1000000UL / speed : 0),
+    _rxEdgeTime(0),
+    _rxEdgeLast(0),
+    _rxEdgeHigh(0),
+#if (RH_PLATFORM == RH_PLATFORM_UNIX)
+    _rxLevel(false),
+    _txLevel(false),
+    _rxFd(-1),
+    _txFd(-1),
+    _rxStreamLen(0),
+    _rxStreamPos(0),
+    _rxStreamEnded(false),
+#endif
+    _rxBufValid(false),
+    _rxActive(false),
+    _rxHead(0),
+    _rxTail(0),
+    _rxSymbolErrors(0),
+    _rxSymbolErrorPosition(0),
+    _rxEarlyAddressFilter(false),
+    _rxAddressDrops(0),
+    _rxSyncErrors(0),
+    _rxCombining(false),
+    _rxCombined(0),
+    _rxCadScore(0),
+    _rxCadQuiet(255),
+    _csma(false),
+    _txBackoff(0),
+    _txFec(false),
+    _rxFecCorrected(0),
+#if RH_ASK_ERASURES
+    _rxFecFrame(false),
+    _rxErasureCount(0),
+#endif
+#if RH_ASK_COMBINE_COPIES > 0
+    _rxCopyCount(0),
+    _rxCopyNext(0),
+    _rxCopyTime(0),
+#endif
+#if RH_ASK_RATE_ADAPTATION
+    _rateNumSpeeds(0),
+    _rateIndex(0),
+    _ratePending(RH_ASK_RATE_NONE),
+    _rateRequested(RH_ASK_RATE_NONE),
+    _rateRevert(RH_ASK_RATE_NONE),
+    _rateSendType(0),
+    _rateSendIndex(0),
+    _ratePeer(RH_BROADCAST_ADDRESS),
+    _rateRxData(0),
+    _rateRxBad(0),
+    _rateCleanReports(0),
+    _rateProbing(false),
+    _rateFer(0),
+    _rateChanges(0),
+    _rateTicks(0),
+    _rateTimeout(0),
+    _rateReportDue(0),
+#endif
+    _txStart(0),
+    _txHead(0),
+    _txTail(0),
+    _txServiced(0)
 {
     // Initialise the first 8 nibbles of the tx buffer to be the standard
     // preamble. We will append messages after that. 0x38, 0x2c is the start symbol before
     // 6-bit conversion to RH_ASK_START_SYMBOL
     uint8_t preamble[RH_ASK_PREAMBLE_LEN] = {0x2a, 0x2a, 0x2a, 0x2a, 0x2a, 0x2a, 0x38, 0x2c};
-    memcpy(_txBuf, preamble, sizeof(preamble));
+    uint16_t startSymbol = RH_ASK_START_SYMBOL;
+    _txSymbolBits = 6;
+    if (_lineCode == LineCodeManchester)
+    {
+	startSymbol = RH_ASK_START_SYMBOL_MANCHESTER;
+	_txSymbolBits = 8;
+    }
+    else if (_lineCode == LineCodeScrambled)
+    {
+	startSymbol = RH_ASK_START_SYMBOL_SCRAMBLED;
+	_txSymbolBits = 5;
+    }
+    preamble[RH_ASK_PREAMBLE_LEN - 2] = startSymbol & 0x3f;
+    preamble[RH_ASK_PREAMBLE_LEN - 1] = startSymbol >> 6;
+    for (uint8_t i = 0; i < RH_ASK_TX_QUEUE_LEN; i++)
+	memcpy(_txBuf[i], preamble, sizeof(preamble));
+    _rxSyncWord = RH_ASK_SYNC_WORD(startSymbol);
+    _rxOctetBits = _txSymbolBits * 2;
 }
 
+#if (RH_PLATFORM != RH_PLATFORM_UNIX) && (RH_PLATFORM != RH_PLATFORM_GENERIC_AVR8)
+// Pin change interrupt handler for the edge receive engine
+static void RH_INTERRUPT_ATTR edgeInterrupt()
+{
+    thisASKDriver->handleEdgeInterrupt();
+}
+#endif
+
 bool RH_ASK::init()
 {
     if (!RHGenericDriver::init())
@@ -69,16 +196,44 @@ bool RH_ASK::init()
     RH_ASK_TX_DDR   |=  (1<<RH_ASK_TX_PIN);
     RH_ASK_RX_DDR   &= ~(1<<RH_ASK_RX_PIN);
  #endif
+    if (_rxEngine == RxEngineEdge)
+	return false; // No attachInterrupt() here
+#elif (RH_PLATFORM == RH_PLATFORM_UNIX)
+    // No pins: the simulated levels are in _rxLevel and _txLevel
 #else
     // Set up digital IO pins for arduino
     pinMode(_txPin, OUTPUT);
     pinMode(_rxPin, INPUT);
     pinMode(_pttPin, OUTPUT);
+
+    if (_rxEngine == RxEngineEdge)
+    {
+	// Determine the interrupt number that corresponds to the rxPin
+	int interruptNumber = digitalPinToInterrupt(_rxPin);
+	if (interruptNumber == NOT_AN_INTERRUPT)
+	    return false;
+ #ifdef RH_ATTACHINTERRUPT_TAKES_PIN_NUMBER
+	interruptNumber = _rxPin;
+ #endif
+	_rxLastSample = readRx();
+	_rxEdgeTime = _rxEdgeLast = micros();
+	attachInterrupt(interruptNumber, edgeInterrupt, CHANGE);
+    }
 #endif
 
+#if RH_ISR_STATS
+    // The timer handler must finish before the next tick
+    setIsrBudget(RH_ISR_CLOCK_HZ / (8UL * _speed));
+#endif
+    // The interrupt handler wakes up the wait functions when a message is queued or sent.
+    // The edge engine finishes messages in available(), so has to be polled
+    _eventDriven = _rxEngine != RxEngineEdge;
+
     // Ready to go
     setModeIdle();
     timerSetup();
+    if (_rxEngine == RxEngineEdge)
+	timerEnable(false); // Only needed for transmitting
 
     return true;
 }
@@ -145,10 +300,29 @@ uint8_t RH_ASK::timerCalc(uint16_t speed, uint16_t max_ticks, uint16_t *nticks)
     *nticks = ulticks;
     return prescaler;
 #else
+    (void)speed;
+    (void)max_ticks;
+    (void)nticks;
     return 0; // not implemented or needed on other platforms
 #endif
 }
 
+bool RH_ASK::timerSupports(uint16_t speed)
+{
+    if (speed == 0)
+	return false;
+#if (RH_PLATFORM == RH_PLATFORM_GENERIC_AVR8) || ((RH_PLATFORM == RH_PLATFORM_ARDUINO) && defined(__AVR__))
+    uint16_t nticks;
+ #if defined(RH_PLATFORM_ATTINY) || defined(RH_ASK_ARDUINO_USE_TIMER2)
+    return timerCalc(speed, (uint8_t)-1, &nticks) != 0;
+ #else
+    return timerCalc(speed, (uint16_t)-1, &nticks) != 0;
+ #endif
+#else
+    return true; // The other timers have plenty of range
+#endif
+}
+
 // The idea here is to get 8 timer interrupts per bit period
 void RH_ASK::timerSetup()
 {
@@ -224,10 +398,11 @@ void RH_ASK::timerSetup()
 
 
  #elif defined(__arm__) && defined(CORE_TEENSY)
-    // on Teensy 3.0 (32 bit ARM), use an interval timer
-    IntervalTimer *t = new IntervalTimer();
+    // on Teensy 3.0 (32 bit ARM), use an interval timer.
+    // Static, so setSpeed() restarts the same one at the new period
+    static IntervalTimer t;
     void TIMER1_COMPA_vect(void);
-    t->begin(TIMER1_COMPA_vect, 125000 / _speed);
+    t.begin(TIMER1_COMPA_vect, 125000 / _speed);
 
  #elif defined (__arm__) && defined(ARDUINO_ARCH_SAMD)
     // Arduino Zero
@@ -375,7 +550,12 @@ void RH_ASK::timerSetup()
 #elif (RH_PLATFORM == RH_PLATFORM_CHIPKIT_CORE)
     // UsingChipKIT Core on Arduino IDE
     uint32_t chipkit_timer_interrupt_handler(uint32_t currentTime); // Forward declaration
-    attachCoreTimerService(chipkit_timer_interrupt_handler);
+    static bool attached = false; // Only attach once, the handler reads the new speed() each time
+    if (!attached)
+    {
+	attachCoreTimerService(chipkit_timer_interrupt_handler);
+	attached = true;
+    }
 
 #elif (RH_PLATFORM == RH_PLATFORM_UNO32)
     // Under old MPIDE, which has been discontinued:
@@ -393,14 +573,54 @@ void RH_ASK::timerSetup()
 //    timer0_write(ESP.getCycleCount() + 41660000);
 #elif (RH_PLATFORM == RH_PLATFORM_ESP32)
     void IRAM_ATTR esp32_timer_interrupt_handler(); // Forward declaration
-    hw_timer_t * timer = timerBegin(0, 80, true); // Alarm value will be in in us
-    timerAttachInterrupt(timer, &esp32_timer_interrupt_handler, true);
+    static hw_timer_t * timer = NULL; // Only set up once, setSpeed() just changes the alarm
+    if (!timer)
+    {
+	timer = timerBegin(0, 80, true); // Alarm value will be in in us
+	timerAttachInterrupt(timer, &esp32_timer_interrupt_handler, true);
+    }
     timerAlarmWrite(timer, 1000000 / _speed / 8, true);
     timerAlarmEnable(timer);
 #endif
 
 }
 
+// Only implemented on AVR, where the timer interrupt is the largest CPU cost. Elsewhere the timer keeps 
+// running, but handleTimerInterrupt() does nothing unless transmitting
+void RH_INTERRUPT_ATTR RH_ASK::timerEnable(bool enable)
+{
+#if (RH_PLATFORM == RH_PLATFORM_ARDUINO) && defined(__AVR__)
+ #if defined(RH_PLATFORM_ATTINY)
+  #ifdef TIMSK0
+    volatile uint8_t& timsk = TIMSK0;
+  #else
+    volatile uint8_t& timsk = TIMSK;
+  #endif
+    const uint8_t mask = _BV(OCIE0A);
+ #elif defined(RH_ASK_ARDUINO_USE_TIMER2)
+  #ifdef TIMSK2
+    volatile uint8_t& timsk = TIMSK2;
+  #else
+    volatile uint8_t& timsk = TIMSK;
+  #endif
+    const uint8_t mask = _BV(OCIE2A);
+ #else
+  #ifdef TIMSK1
+    volatile uint8_t& timsk = TIMSK1;
+  #else
+    volatile uint8_t& timsk = TIMSK;
+  #endif
+    const uint8_t mask = _BV(OCIE1A);
+ #endif
+    if (enable)
+	timsk |= mask;
+    else
+	timsk &= ~mask;
+#else
+    (void)enable;
+#endif
+}
+
 void RH_INTERRUPT_ATTR RH_ASK::setModeIdle()
 {
     if (_mode != RHModeIdle)
@@ -409,6 +629,11 @@ void RH_INTERRUPT_ATTR RH_ASK::setModeIdle()
 	writePtt(LOW);
 	writeTx(LOW);
 	_mode = RHModeIdle;
+	// A backoff only counts down in RHModeRx, so cancel it. Any queued messages
+	// stay queued, and the next send() starts them again
+	_txBackoff = 0;
+	if (_rxEngine == RxEngineEdge)
+	    timerEnable(false);
     }
 }
 
@@ -420,15 +645,21 @@ void RH_ASK::setModeRx()
 	writePtt(LOW);
 	writeTx(LOW);
 	_mode = RHModeRx;
+	// We have not been listening, so we know nothing about the channel
+	_rxCadScore = 0;
+	_rxCadQuiet = 255;
+	if (_rxEngine == RxEngineEdge && !_txBackoff)
+	    timerEnable(false); // Still needed to count down any backoff
     }
 }
 
-void RH_ASK::setModeTx()
+// Called by the interrupt handler at the end of a CSMA backoff
+void RH_INTERRUPT_ATTR RH_ASK::setModeTx()
 {
     if (_mode != RHModeTx)
     {
 	// PRepare state varibles for a new transmission
-	_txIndex = 0;
+	_txIndex = _txStart;
 	_txBit = 0;
 	_txSample = 0;
 
@@ -436,112 +667,262 @@ void RH_ASK::setModeTx()
 	writePtt(HIGH);
 
 	_mode = RHModeTx;
+	if (_rxEngine == RxEngineEdge)
+	    timerEnable(true);
     }
 }
 
 // Call this often
 bool RH_ASK::available()
 {
-    if (_mode == RHModeTx)
-	return false;
-    setModeRx();
-    if (_rxBufFull)
+    if (_mode != RHModeTx)
+	setModeRx();
+    if (_rxEngine == RxEngineEdge)
+	receiveEdgeTimeout();
+#if (RH_PLATFORM == RH_PLATFORM_UNIX)
+    receiveStream();
+#endif
+    // Validate queued messages in order of arrival until we find a good one
+    while (!_rxBufValid && _rxTail != _rxHead)
     {
 	validateRxBuf();
-	_rxBufFull= false;
+#if RH_ASK_RATE_ADAPTATION
+	if (_rxBufValid && _rateNumSpeeds)
+	{
+	    // The link works at this speed
+	    ATOMIC_BLOCK_START;
+	    _rateTimeout = RH_ASK_RATE_TIMEOUT_BITS;
+	    ATOMIC_BLOCK_END;
+	    _ratePeer = _rxHeaderFrom;
+	    _rateRevert = RH_ASK_RATE_NONE;
+	}
+	if (_rxBufValid && (_rxHeaderFlags & RH_ASK_FLAGS_RATE))
+	    rateReceived(); // Not for the application
+	else if (_rxBufValid)
+	    _rateRxData++;
+#else
+	if (_rxBufValid && (_rxHeaderFlags & RH_ASK_FLAGS_RATE))
+	    _rxBufValid = false; // Never delivered to the application
+#endif
+	if (!_rxBufValid)
+	    _rxTail++; // Bad or not for us, free the slot for the interrupt handler
     }
+#if RH_ASK_RATE_ADAPTATION
+    if (_rateNumSpeeds)
+	rateService();
+#endif
     return _rxBufValid;
 }
 
+bool RH_ASK::waitPacketSent()
+{
+    // A backoff only counts down in RHModeRx: dont wait for one that cannot finish
+    while (_mode == RHModeTx || (_txBackoff && _mode == RHModeRx))
+	waitEvent(0); // Wait for any previous transmit to finish
+    return true;
+}
+
+bool RH_ASK::waitPacketSent(uint16_t timeout)
+{
+    unsigned long starttime = millis();
+    unsigned long elapsed;
+    while ((elapsed = millis() - starttime) < timeout)
+    {
+	if (_mode != RHModeTx && !(_txBackoff && _mode == RHModeRx)) // Any previous transmit finished?
+	    return true;
+	waitEvent(timeout - elapsed);
+    }
+    return false;
+}
+
+bool RH_ASK::isChannelActive()
+{
+    if (_mode == RHModeIdle)
+	setModeRx();
+    if (_rxEngine == RxEngineEdge)
+	receiveEdgeTimeout();
+#if (RH_PLATFORM == RH_PLATFORM_UNIX)
+    receiveStream();
+#endif
+    return channelActive();
+}
+
 bool RH_ASK::recv(uint8_t* buf, uint8_t* len)
 {
-    if (!available())
+    const uint8_t* message;
+    uint8_t message_len;
+    if (!RH_ASK::recvView(&message, &message_len))
 	return false;
 
     if (buf && len)
     {
-	// Skip the length and 4 headers that are at the beginning of the rxBuf
-	// and drop the trailing 2 bytes of FCS
-	uint8_t message_len = _rxBufLen-RH_ASK_HEADER_LEN - 3;
 	if (*len > message_len)
 	    *len = message_len;
-	memcpy(buf, _rxBuf+RH_ASK_HEADER_LEN+1, *len);
+	memcpy(buf, message, *len);
     }
-    _rxBufValid = false; // Got the most recent message, delete it
+    RH_ASK::release(); // Got the oldest message, delete it
 //    printBuffer("recv:", buf, *len);
     return true;
 }
 
-// Caution: this may block
+bool RH_ASK::recvView(const uint8_t** buf, uint8_t* len, uint8_t* copy, uint8_t copyLen)
+{
+    (void)copy; // The message can always be lent out of its slot
+    (void)copyLen;
+    if (!available())
+	return false;
+
+    uint8_t slot = _rxTail & (RH_ASK_RX_QUEUE_LEN - 1);
+    // Skip the length and 4 headers that are at the beginning of the rxBuf
+    // and drop the trailing 2 bytes of FCS and any FEC parity
+    *buf = _rxBuf[slot]+RH_ASK_HEADER_LEN+1;
+    *len = _rxBuf[slot][0]-RH_ASK_HEADER_LEN - 3;
+#if RH_DRIVER_STATS
+    if (!_rxView)
+	statsRecv(_rxDoneTime[slot]);
+#endif
+    _rxView = true; // _rxTail stays put, so the interrupt handler leaves the slot alone
+    return true;
+}
+
+void RH_ASK::release()
+{
+    if (!_rxView)
+	return;
+    _rxView = false;
+    _rxBufValid = false;
+    _rxTail++; // Give its slot back to the interrupt handler
+}
+
+// Caution: this may block if the transmit queue is full
 bool RH_ASK::send(const uint8_t* data, uint8_t len)
+{
+    return sendAsync(data, len);
+}
+
+// Caution: this may block if the transmit queue is full
+bool RH_ASK::sendAsync(const uint8_t* data, uint8_t len, SendCallback callback, void* context)
 {
     uint8_t i;
-    uint16_t index = 0;
     uint16_t crc = 0xffff;
-    uint8_t *p = _txBuf + RH_ASK_PREAMBLE_LEN; // start of the message area
     uint8_t count = len + 3 + RH_ASK_HEADER_LEN; // Added byte count and FCS and headers to get total number of bytes
 
     if (len > RH_ASK_MAX_MESSAGE_LEN)
 	return false;
 
-    // Wait for transmitter to become available
-    waitPacketSent();
+    // Wait for a free slot in the transmit queue, and for the callback of the message that was in it
+    while ((uint8_t)(_txHead - _txServiced) >= RH_ASK_TX_QUEUE_LEN)
+    {
+	if (txQueueSpace())
+	    service(); // The callback may send another message, so check again
+	else
+	{
+	    startTransmitter(); // In case setModeIdle() stopped it
+	    waitEvent(0);
+	}
+    }
+    uint8_t slot = _txHead & (RH_ASK_TX_QUEUE_LEN - 1);
+    uint8_t *p = _txBuf[slot] + RH_ASK_PREAMBLE_LEN; // start of the message area
 
-    if (!waitCAD()) 
+    // Only check channel activity if we are not already in the middle of transmitting
+    if (_txHead == _txTail && !waitCAD()) 
 	return false;  // Check channel activity
 
-    // Encode the message length
-    crc = RHcrc_ccitt_update(crc, count);
-    p[index++] = symbols[count >> 4];
-    p[index++] = symbols[count & 0xf];
-
-    // Encode the headers
-    crc = RHcrc_ccitt_update(crc, _txHeaderTo);
-    p[index++] = symbols[_txHeaderTo >> 4];
-    p[index++] = symbols[_txHeaderTo & 0xf];
-    crc = RHcrc_ccitt_update(crc, _txHeaderFrom);
-    p[index++] = symbols[_txHeaderFrom >> 4];
-    p[index++] = symbols[_txHeaderFrom & 0xf];
-    crc = RHcrc_ccitt_update(crc, _txHeaderId);
-    p[index++] = symbols[_txHeaderId >> 4];
-    p[index++] = symbols[_txHeaderId & 0xf];
-    crc = RHcrc_ccitt_update(crc, _txHeaderFlags);
-    p[index++] = symbols[_txHeaderFlags >> 4];
-    p[index++] = symbols[_txHeaderFlags & 0xf];
-
-    // Encode the message into 6 bit symbols. Each byte is converted into 
-    // 2 6-bit symbols, high nybble first, low nybble second
+    // The message length and the headers
+    uint8_t header[RH_ASK_HEADER_LEN + 1] = { count, _txHeaderTo, _txHeaderFrom, _txHeaderId, _txHeaderFlags };
+    if (_txFec)
+	header[RH_ASK_HEADER_LEN] |= RH_ASK_FLAGS_FEC;
+    crc = RHcrc_ccitt_block(crc, header, sizeof(header));
+    crc = RHcrc_ccitt_block(crc, data, len);
+
+    // Encode the message length and headers
+    _txWhitening = 0x1ff;
+    for (i = 0; i < sizeof(header); i++)
+	p = encodeOctet(p, header[i]);
+
+    // Encode the message into symbols. Each byte is converted into 
+    // 2 symbols, high nybble first, low nybble second
     for (i = 0; i < len; i++)
-    {
-	crc = RHcrc_ccitt_update(crc, data[i]);
-	p[index++] = symbols[data[i] >> 4];
-	p[index++] = symbols[data[i] & 0xf];
-    }
+	p = encodeOctet(p, data[i]);
 
-    // Append the fcs, 16 bits before encoding (4 6-bit symbols after encoding)
+    // Append the fcs, 16 bits before encoding (4 symbols after encoding)
     // Caution: VW expects the _ones_complement_ of the CCITT CRC-16 as the FCS
     // VW sends FCS as low byte then hi byte
     crc = ~crc;
-    p[index++] = symbols[(crc >> 4)  & 0xf];
-    p[index++] = symbols[crc & 0xf];
-    p[index++] = symbols[(crc >> 12) & 0xf];
-    p[index++] = symbols[(crc >> 8)  & 0xf];
+    p = encodeOctet(p, crc & 0xff);
+    p = encodeOctet(p, crc >> 8);
 
-    // Total number of 6-bit symbols to send
-    _txBufLen = index + RH_ASK_PREAMBLE_LEN;
+#if RH_ASK_FEC
+    if (_txFec)
+    {
+	// Reed-Solomon parity over everything from the byte count to the FCS. 
+	// Not included in the byte count, so older receivers ignore it
+	uint8_t parity[RH_ASK_FEC_PARITY_LEN] = { 0 };
+	uint8_t fcs[2] = { (uint8_t)(crc & 0xff), (uint8_t)(crc >> 8) };
+	RHfec_rs_encode_block(parity, sizeof(parity), header, sizeof(header));
+	RHfec_rs_encode_block(parity, sizeof(parity), data, len);
+	RHfec_rs_encode_block(parity, sizeof(parity), fcs, sizeof(fcs));
+	for (i = 0; i < sizeof(parity); i++)
+	    p = encodeOctet(p, parity[i]);
+    }
+#endif
 
-    // Start the low level interrupt handler sending symbols
-    setModeTx();
+    // Total number of symbols to send
+    _txBufLen[slot] = p - _txBuf[slot];
+#if RH_DRIVER_STATS
+    _txSendTime[slot] = statsClock();
+#endif
+    _txCallback[slot] = callback;
+    _txContext[slot] = context;
+
+    // Hand the slot over to the interrupt handler. If it is still sending an earlier message
+    // it will chain into this one, else start the low level interrupt handler sending symbols
+    _txHead++;
+    startTransmitter();
+#if (RH_PLATFORM == RH_PLATFORM_UNIX)
+    // No timer in the simulator: write the whole message to the sample stream now
+    transmitStream();
+#endif
 
     return true;
 }
 
+void RH_ASK::startTransmitter()
+{
+    if (_mode == RHModeTx || _txBackoff || _txHead == _txTail)
+	return;
+    if (_csma)
+    {
+	// Listen for a random backoff first. The interrupt handler starts the transmitter at the end of it
+	setModeRx();
+	_txSample = 0;
+	_txBackoff = random(1, RH_ASK_CSMA_WINDOW + 1);
+	if (_rxEngine == RxEngineEdge)
+	    timerEnable(true); // To count the backoff
+    }
+    else
+	setModeTx();
+}
+
+void RH_ASK::service()
+{
+    // Call the callbacks of the transmitted messages in order
+    while (_txServiced != _txTail)
+    {
+	uint8_t slot = _txServiced++ & (RH_ASK_TX_QUEUE_LEN - 1);
+	if (_txCallback[slot])
+	    _txCallback[slot](_txContext[slot]);
+    }
+}
+
 // Read the RX data input pin, taking into account platform type and inversion.
 bool RH_INTERRUPT_ATTR RH_ASK::readRx()
 {
     bool value;
 #if (RH_PLATFORM == RH_PLATFORM_GENERIC_AVR8)
     value = ((RH_ASK_RX_PORT & (1<<RH_ASK_RX_PIN)) ? 1 : 0);
+#elif (RH_PLATFORM == RH_PLATFORM_UNIX)
+    value = _rxLevel;
 #else
     value = digitalRead(_rxPin);
 #endif
@@ -553,6 +934,8 @@ void RH_INTERRUPT_ATTR RH_ASK::writeTx(bool value)
 {
 #if (RH_PLATFORM == RH_PLATFORM_GENERIC_AVR8)
     ((value) ? (RH_ASK_TX_PORT |= (1<<RH_ASK_TX_PIN)) : (RH_ASK_TX_PORT &= ~(1<<RH_ASK_TX_PIN)));
+#elif (RH_PLATFORM == RH_PLATFORM_UNIX)
+    _txLevel = value;
 #else
     digitalWrite(_txPin, value);
 #endif
@@ -567,6 +950,8 @@ void RH_INTERRUPT_ATTR RH_ASK::writePtt(bool value)
  #else
     ((value) ? (RH_ASK_TX_PORT |= (1<<RH_ASK_TX_PIN)) : (RH_ASK_TX_PORT &= ~(1<<RH_ASK_TX_PIN)));
  #endif
+#elif (RH_PLATFORM == RH_PLATFORM_UNIX)
+    (void)value; // No PTT in the simulator
 #else
     digitalWrite(_pttPin, value ^ _pttInverted);
 #endif
@@ -577,6 +962,541 @@ uint8_t RH_ASK::maxMessageLength()
     return RH_ASK_MAX_MESSAGE_LEN;
 }
 
+uint8_t RH_ASK::rxQueueDepth()
+{
+    return _rxHead - _rxTail;
+}
+
+uint16_t RH_ASK::rxOverflow()
+{
+    return _rxOverflow;
+}
+
+uint16_t RH_ASK::rxSymbolErrors()
+{
+    return _rxSymbolErrors;
+}
+
+uint8_t RH_ASK::rxSymbolErrorPosition()
+{
+    return _rxSymbolErrorPosition;
+}
+
+void RH_ASK::setEarlyAddressFilter(bool enable)
+{
+    _rxEarlyAddressFilter = enable;
+}
+
+uint16_t RH_ASK::rxAddressDrops()
+{
+    return _rxAddressDrops;
+}
+
+void RH_ASK::setCombining(bool enable)
+{
+#if RH_ASK_COMBINE_COPIES > 0
+    _rxCombining = enable;
+#else
+    (void)enable;
+#endif
+}
+
+uint16_t RH_ASK::rxCombined()
+{
+    return _rxCombined;
+}
+
+void RH_ASK::setFec(bool enable)
+{
+#if RH_ASK_FEC
+    _txFec = enable;
+#else
+    (void)enable;
+#endif
+}
+
+void RH_ASK::setPreambleLength(uint8_t symbols)
+{
+    if (symbols < 1)
+	symbols = 1;
+    else if (symbols > RH_ASK_PREAMBLE_LEN - 2)
+	symbols = RH_ASK_PREAMBLE_LEN - 2;
+    // The preamble is always in the tx buffer: start sending part way through it
+    _txStart = RH_ASK_PREAMBLE_LEN - 2 - symbols;
+}
+
+uint16_t RH_ASK::rxSyncErrors()
+{
+    return _rxSyncErrors;
+}
+
+void RH_ASK::setCsma(bool enable)
+{
+    _csma = enable;
+}
+
+uint16_t RH_ASK::rxFecCorrected()
+{
+    return _rxFecCorrected;
+}
+
+bool RH_ASK::setSpeed(uint16_t speed)
+{
+    if (!timerSupports(speed))
+	return false;
+    waitPacketSent();
+
+    ATOMIC_BLOCK_START;
+    _speed = speed;
+    _rxEdgePeriod = 1000000UL / speed;
+    // Whatever was being received is lost, and the channel activity detector starts again
+    _rxActive = false;
+    _rxIntegrator = 0;
+    _rxPllRamp = 0;
+    _rxCadScore = 0;
+    _rxCadQuiet = 255;
+    ATOMIC_BLOCK_END;
+
+    timerSetup();
+    if (_rxEngine == RxEngineEdge && _mode != RHModeTx && !_txBackoff)
+	timerEnable(false); // Only needed for transmitting
+#if RH_ISR_STATS
+    setIsrBudget(RH_ISR_CLOCK_HZ / (8UL * _speed));
+#endif
+    return true;
+}
+
+bool RH_ASK::setRateAdaptation(const uint16_t* speeds, uint8_t numSpeeds)
+{
+#if RH_ASK_RATE_ADAPTATION
+    _rateNumSpeeds = 0;
+    _rateRevert = RH_ASK_RATE_NONE;
+    ATOMIC_BLOCK_START;
+    _rateTimeout = 0;
+    _rateReportDue = 0;
+    ATOMIC_BLOCK_END;
+    if (!speeds || !numSpeeds)
+	return true;
+    if (_rxEngine == RxEngineEdge || numSpeeds > RH_ASK_RATE_MAX_SPEEDS)
+	return false;
+    for (uint8_t i = 0; i < numSpeeds; i++)
+	if (!timerSupports(speeds[i]))
+	    return false;
+
+    memcpy(_rateSpeeds, speeds, numSpeeds * sizeof(uint16_t));
+    _rateNumSpeeds = numSpeeds;
+    for (uint8_t i = 0; i < numSpeeds; i++)
+	_rateUpReports[i] = RH_ASK_RATE_UP_REPORTS;
+    _rateIndex = 0;
+    _rateProbing = false;
+    rateSwitch(0, false);
+    _rateChanges = 0;
+    return true;
+#else
+    return !speeds || !numSpeeds; // Can only disable it
+#endif
+}
+
+uint16_t RH_ASK::rateChanges()
+{
+#if RH_ASK_RATE_ADAPTATION
+    return _rateChanges;
+#else
+    return 0;
+#endif
+}
+
+uint8_t RH_ASK::rateFrameErrorRate()
+{
+#if RH_ASK_RATE_ADAPTATION
+    return _rateFer;
+#else
+    return 0;
+#endif
+}
+
+#if RH_ASK_RATE_ADAPTATION
+void RH_ASK::rateReceived()
+{
+    uint8_t slot = _rxTail & (RH_ASK_RX_QUEUE_LEN - 1);
+    const uint8_t* data = _rxBuf[slot] + RH_ASK_HEADER_LEN + 1;
+    uint8_t len = _rxBuf[slot][0] - RH_ASK_HEADER_LEN - 3;
+    _rxBufValid = false; // Never delivered to the application
+    if (!_rateNumSpeeds || len < 4 || data[1] >= _rateNumSpeeds)
+	return;
+
+    uint8_t index = data[1];
+    switch (data[0])
+    {
+    case RH_ASK_RATE_REPORT:
+	// How the messages this node sent are getting through.
+	// Ignore reports from before a speed change, and ones that counted too few messages to go by
+	if (index != _rateIndex || _ratePending != RH_ASK_RATE_NONE || data[3] < RH_ASK_RATE_REPORT_FRAMES / 2)
+	    break;
+	_rateFer = data[2];
+	// If the other end had accepted a request, it would not be reporting at this speed
+	_rateRequested = RH_ASK_RATE_NONE;
+	if (_rateSendType == RH_ASK_RATE_REQUEST)
+	    _rateSendType = 0; // Decide again
+	if (_rateFer > RH_ASK_RATE_DOWN_FER)
+	{
+	    _rateCleanReports = 0;
+	    if (_rateIndex > 0)
+		rateRequest(_rateIndex - 1);
+	}
+	else if (_rateFer <= RH_ASK_RATE_UP_FER)
+	{
+	    if (_rateProbing)
+		_rateUpReports[_rateIndex - 1] = RH_ASK_RATE_UP_REPORTS; // The last step up worked
+	    _rateProbing = false;
+	    if (++_rateCleanReports >= _rateUpReports[_rateIndex] && _rateIndex + 1 < _rateNumSpeeds)
+		rateRequest(_rateIndex + 1);
+	}
+	else
+	{
+	    _rateCleanReports = 0;
+	    _rateProbing = false; // Usable, so stay here
+	}
+	break;
+
+    case RH_ASK_RATE_REQUEST:
+	// The other end wants to change speed. Agree, and change once the acceptance has been sent
+	_rateSendType = RH_ASK_RATE_ACCEPT;
+	_rateSendIndex = index;
+	_rateRequested = RH_ASK_RATE_NONE;
+	break;
+
+    case RH_ASK_RATE_ACCEPT:
+	// The other end agreed to our request
+	if (index == _rateRequested)
+	    _ratePending = index; // _rateRequested stays set until the change, see rateSwitch()
+	break;
+    }
+}
+
+void RH_ASK::rateService()
+{
+    // Send any handshake message as soon as there is room in the transmit queue
+    if (_rateSendType && rateSend(_rateSendType, _rateSendIndex))
+    {
+	if (_rateSendType == RH_ASK_RATE_ACCEPT)
+	    _ratePending = _rateSendIndex;
+	else
+	    _rateRequested = _rateSendIndex;
+	_rateSendType = 0;
+    }
+
+    // Change speed once everything queued at the old speed has gone
+    bool idle = _mode != RHModeTx && !_txBackoff && _txHead == _txTail;
+    if (_ratePending != RH_ASK_RATE_NONE)
+    {
+	if (idle)
+	    rateSwitch(_ratePending, true);
+	return;
+    }
+
+    if (_rateTimeout == 0 && _rateRevert != RH_ASK_RATE_NONE)
+    {
+	// Nothing heard since the change: the link does not work at the new speed, or the
+	// other end did not hear the acceptance and is still at the old one
+	if (idle)
+	    rateSwitch(_rateRevert, false);
+	return;
+    }
+    if (_rateTimeout == 0 && _rateIndex != 0)
+    {
+	// Nothing heard for too long, so the link does not work at this speed, or the
+	// two ends have lost track of each other. Step down until they meet: the lower end
+	// takes longer to time out, so the higher one catches up
+	if (idle)
+	    rateSwitch(_rateIndex - 1, false);
+	return;
+    }
+
+    // Report the frame error rate of the messages received since the last report.
+    // Only if some were application messages: reports are not reported
+    uint16_t bad = _rxBad - _rateRxBad;
+    uint16_t frames = _rateRxData + bad;
+    if (_rateRxData && (frames >= RH_ASK_RATE_REPORT_FRAMES || _rateReportDue == 0))
+    {
+	uint16_t fer = ((uint32_t)bad * 256) / frames;
+	if (rateSend(RH_ASK_RATE_REPORT, _rateIndex, fer > 255 ? 255 : fer, frames > 255 ? 255 : frames))
+	{
+	    _rateRxData = 0;
+	    _rateRxBad = _rxBad;
+	    ATOMIC_BLOCK_START;
+	    _rateReportDue = RH_ASK_RATE_TIMEOUT_BITS / 4;
+	    ATOMIC_BLOCK_END;
+	}
+    }
+}
+
+bool RH_ASK::rateSend(uint8_t type, uint8_t index, uint8_t fer, uint8_t frames)
+{
+    if (!txQueueSpace())
+	return false; // Dont block. Reports are sent later, and requests are made again after the next report
+
+    uint8_t data[4] = { type, index, fer, frames };
+    uint8_t to = _txHeaderTo;
+    uint8_t flags = _txHeaderFlags;
+    _txHeaderTo = _ratePeer;
+    _txHeaderFlags = RH_ASK_FLAGS_RATE;
+    bool ret = send(data, sizeof(data));
+    _txHeaderTo = to;
+    _txHeaderFlags = flags;
+    return ret;
+}
+
+void RH_ASK::rateRequest(uint8_t index)
+{
+    _rateSendType = RH_ASK_RATE_REQUEST; // Sent by rateService()
+    _rateSendIndex = index;
+}
+
+void RH_ASK::rateSwitch(uint8_t index, bool agreed)
+{
+    // After an agreed change, go back if nothing is heard soon. The end that asked for the change
+    // waits longer, because it hears nothing until the other end sends a report, which may be lost
+    uint16_t timeout = RH_ASK_RATE_TIMEOUT_BITS;
+    if (agreed)
+	timeout = (index == _rateRequested) ? RH_ASK_RATE_TIMEOUT_BITS / 2 : RH_ASK_RATE_TIMEOUT_BITS / 8;
+    _rateRevert = agreed ? _rateIndex : RH_ASK_RATE_NONE;
+    if (index < _rateIndex && _rateProbing && _rateUpReports[index] < 64)
+	_rateUpReports[index] *= 2; // The last step up did not work: wait longer before trying it again
+    _rateProbing = index > _rateIndex;
+    _rateIndex = index;
+    _ratePending = _rateRequested = RH_ASK_RATE_NONE;
+    _rateSendType = 0;
+    _rateCleanReports = 0;
+    _rateRxData = 0;
+    _rateRxBad = _rxBad;
+    setSpeed(_rateSpeeds[index]);
+    ATOMIC_BLOCK_START;
+    _rateTimeout = timeout;
+    _rateReportDue = RH_ASK_RATE_TIMEOUT_BITS / 16; // Soon, to show the other end the new speed works
+    ATOMIC_BLOCK_END;
+    _rateChanges++;
+}
+#endif
+
+uint8_t RH_ASK::txQueueSpace()
+{
+    return RH_ASK_TX_QUEUE_LEN - txQueueDepth();
+}
+
+uint8_t RH_ASK::txQueueDepth()
+{
+    return _txHead - _txTail;
+}
+
+#if RH_ASK_COMBINE_COPIES > 0
+bool RH_ASK::combineRxBuf(uint8_t* rxBuf, const uint8_t* erasures, uint8_t len)
+{
+    uint8_t i, j, k;
+
+    // Are the copies we have kept of the same message?
+    // The byte count must be the same, and the headers too, where they are not erased
+    bool same = _rxCopyCount && (uint32_t)(millis() - _rxCopyTime) <= RH_ASK_COMBINE_TIMEOUT;
+    for (j = 0; same && j < _rxCopyCount; j++)
+    {
+	if (_rxCopies[j][0] != len)
+	    same = false;
+	for (i = 1; same && i <= RH_ASK_HEADER_LEN; i++)
+	    if (!RH_ASK_ERASED(erasures, i) && !RH_ASK_ERASED(_rxCopyErasures[j], i) && _rxCopies[j][i] != rxBuf[i])
+		same = false;
+    }
+    if (!same)
+	_rxCopyCount = _rxCopyNext = 0; // Start again with this one
+
+    // Vote on each octet. Where there is no majority, remember the 2 best candidates
+    uint8_t combined[RH_ASK_MAX_PAYLOAD_LEN];
+    uint8_t alternative[RH_ASK_MAX_PAYLOAD_LEN];
+    uint8_t ambiguous[RH_ASK_COMBINE_MAX_TRIALS];
+    uint8_t numAmbiguous = 0;
+    bool possible = _rxCopyCount > 0;
+    combined[0] = len;
+    for (i = 1; possible && i < len; i++)
+    {
+	// Candidate values for this octet, the new copy first
+	uint8_t values[RH_ASK_COMBINE_COPIES + 1];
+	uint8_t numValues = 0;
+	if (!RH_ASK_ERASED(erasures, i))
+	    values[numValues++] = rxBuf[i];
+	for (j = 0; j < _rxCopyCount; j++)
+	    if (!RH_ASK_ERASED(_rxCopyErasures[j], i))
+		values[numValues++] = _rxCopies[j][i];
+	if (numValues == 0)
+	{
+	    possible = false; // Erased in every copy
+	    break;
+	}
+	uint8_t votes[RH_ASK_COMBINE_COPIES + 1];
+	for (j = 0; j < numValues; j++)
+	    for (k = 0, votes[j] = 0; k < numValues; k++)
+		if (values[k] == values[j])
+		    votes[j]++;
+	uint8_t best = 0, bestVotes = 0, second = 0, secondVotes = 0;
+	for (j = 0; j < numValues; j++)
+	    if (votes[j] > bestVotes)
+	    {
+		best = values[j];
+		bestVotes = votes[j];
+	    }
+	for (j = 0; j < numValues; j++)
+	    if (values[j] != best && votes[j] > secondVotes)
+	    {
+		second = values[j];
+		secondVotes = votes[j];
+	    }
+	combined[i] = best;
+	if (secondVotes == bestVotes)
+	{
+	    // A tie: try both
+	    if (numAmbiguous >= RH_ASK_COMBINE_MAX_TRIALS)
+		possible = false;
+	    else
+	    {
+		alternative[i] = second;
+		ambiguous[numAmbiguous++] = i;
+	    }
+	}
+    }
+
+    // Try each combination of the alternatives for the ambiguous octets
+    for (uint8_t trial = 0; possible && trial < (1 << numAmbiguous); trial++)
+    {
+	uint8_t candidate[RH_ASK_MAX_PAYLOAD_LEN];
+	memcpy(candidate, combined, len);
+	for (j = 0; j < numAmbiguous; j++)
+	    if (trial & (1 << j))
+		candidate[ambiguous[j]] = alternative[ambiguous[j]];
+	if (RHcrc_ccitt_block(0xffff, candidate, len) == 0xf0b8)
+	{
+	    memcpy(rxBuf, candidate, len);
+	    _rxCopyCount = 0; // Done with this message
+	    _rxCombined++;
+	    return true;
+	}
+    }
+
+    // No luck, keep this copy for next time, replacing the oldest if necessary
+    memcpy(_rxCopies[_rxCopyNext], rxBuf, len);
+    memcpy(_rxCopyErasures[_rxCopyNext], erasures, sizeof(_rxCopyErasures[0]));
+    _rxCopyNext = (_rxCopyNext + 1) % RH_ASK_COMBINE_COPIES;
+    if (_rxCopyCount < RH_ASK_COMBINE_COPIES)
+	_rxCopyCount++;
+    _rxCopyTime = millis();
+    return false;
+}
+#endif
+
+
+#if (RH_PLATFORM == RH_PLATFORM_UNIX)
+// Sample streams have 8 samples per octet (one nominal bit period), the first sample in bit 0
+uint32_t RH_ASK::receiveSamples(const uint8_t* samples, uint32_t len)
+{
+    uint32_t i;
+    for (i = 0; i < len; i++)
+    {
+	// Dont let the receiver drop messages because the caller has not collected them yet
+	if ((uint8_t)(_rxHead - _rxTail) >= RH_ASK_RX_QUEUE_LEN)
+	    break;
+	uint8_t octet = samples[i];
+	for (uint8_t bit = 0; bit < 8; bit++)
+	    receiveSample(octet & (1 << bit));
+    }
+    return i;
+}
+
+uint32_t RH_ASK::transmitSamples(uint8_t* samples, uint32_t len)
+{
+    uint32_t i;
+    for (i = 0; i < len && _mode == RHModeTx; i++)
+    {
+	uint8_t octet = 0;
+	for (uint8_t bit = 0; bit < 8; bit++)
+	{
+	    if (_mode == RHModeTx)
+		transmitTimer(); // Goes idle, with the tx output LOW, after the last message in the queue
+	    if (_txLevel)
+		octet |= (1 << bit);
+	}
+	samples[i] = octet;
+    }
+    return i;
+}
+
+void RH_ASK::setSampleStreams(int rxFd, int txFd)
+{
+    _rxFd = rxFd;
+    _txFd = txFd;
+    _rxStreamLen = _rxStreamPos = 0;
+    _rxStreamEnded = false;
+    // available() must not block waiting for samples
+    if (_rxFd >= 0)
+	fcntl(_rxFd, F_SETFL, fcntl(_rxFd, F_GETFL) | O_NONBLOCK);
+    // and reads them, so has to be polled
+    _eventDriven = _rxFd < 0 && _rxEngine != RxEngineEdge;
+}
+
+bool RH_ASK::sampleStreamEnded()
+{
+    return _rxStreamEnded && _rxStreamPos >= _rxStreamLen;
+}
+
+// Feed whatever samples are waiting in the rx stream to the receiver, until there are no more
+// or the receive queue is full
+void RH_ASK::receiveStream()
+{
+    while (_rxFd >= 0)
+    {
+	if (_rxStreamPos >= _rxStreamLen)
+	{
+	    ssize_t n = read(_rxFd, _rxStreamBuf, sizeof(_rxStreamBuf));
+	    if (n <= 0)
+	    {
+		if (n == 0)
+		    _rxStreamEnded = true;
+		return; // End of stream, or no samples available yet
+	    }
+	    _rxStreamLen = n;
+	    _rxStreamPos = 0;
+	}
+	_rxStreamPos += receiveSamples(_rxStreamBuf + _rxStreamPos, _rxStreamLen - _rxStreamPos);
+	if (_rxStreamPos < _rxStreamLen)
+	    return; // Receive queue is full
+    }
+}
+
+// Write the whole transmit queue to the tx stream, followed by RH_ASK_STREAM_TRAILER_LEN
+// bit periods of idle, so the receiver can clock out the last bit
+void RH_ASK::transmitStream()
+{
+    if (_txFd < 0)
+	return;
+    uint8_t buf[256];
+    while (_mode == RHModeTx)
+    {
+	uint32_t len = transmitSamples(buf, sizeof(buf) - RH_ASK_STREAM_TRAILER_LEN);
+	if (_mode != RHModeTx)
+	{
+	    memset(buf + len, 0, RH_ASK_STREAM_TRAILER_LEN);
+	    len += RH_ASK_STREAM_TRAILER_LEN;
+	}
+	for (uint32_t written = 0; written < len; )
+	{
+	    ssize_t n = write(_txFd, buf + written, len - written);
+	    if (n <= 0)
+	    {
+		_txFd = -1; // Stream closed, stop using it
+		return;
+	    }
+	    written += n;
+	}
+    }
+}
+#endif
+
 #if (RH_PLATFORM == RH_PLATFORM_ARDUINO) 
  #if defined(RH_PLATFORM_ATTINY)
   #define RH_ASK_TIMER_VECTOR TIM0_COMPA_vect
@@ -688,44 +1608,132 @@ void IRAM_ATTR esp32_timer_interrupt_handler()
 #endif
 
 // Convert a 6 bit encoded symbol into its 4 bit decoded equivalent
-uint8_t RH_INTERRUPT_ATTR RH_ASK::symbol_6to4(uint8_t symbol)
+// Returns RH_ASK_INVALID_SYMBOL if it is not one of the 16 valid symbols
+// Manchester symbols for each 4 bits. Each bit is sent as itself then its complement, LSB first
+static uint8_t manchester[] =
 {
-    uint8_t i;
-    uint8_t count;
-    
-    // Linear search :-( Could have a 64 byte reverse lookup table?
-    // There is a little speedup here courtesy Ralph Doncaster:
-    // The shortcut works because bit 5 of the symbol is 1 for the last 8
-    // symbols, and it is 0 for the first 8.
-    // So we only have to search half the table
-    for (i = (symbol>>2) & 8, count=8; count-- ; i++)
-	if (symbol == symbols[i]) return i;
+    0xaa, 0xa9, 0xa6, 0xa5, 0x9a, 0x99, 0x96, 0x95,
+    0x6a, 0x69, 0x66, 0x65, 0x5a, 0x59, 0x56, 0x55
+};
 
-    return 0; // Not found
+// Returns the next 8 bits of the PN9 whitening sequence (x^9 + x^5 + 1, starting from 0x1ff),
+// and advances the generator
+static uint8_t RH_INTERRUPT_ATTR whitening(uint16_t* lfsr)
+{
+    uint8_t octet = *lfsr & 0xff;
+    for (uint8_t i = 0; i < 8; i++)
+	*lfsr = (*lfsr >> 1) | ((((*lfsr >> 5) ^ *lfsr) & 1) << 8);
+    return octet;
 }
 
-// Check whether the latest received message is complete and uncorrupted
-// We should always check the FCS at user level, not interrupt level
-// since it is slow
+uint8_t* RH_ASK::encodeOctet(uint8_t* p, uint8_t octet)
+{
+    uint8_t hi, lo;
+    switch (_lineCode)
+    {
+    case LineCodeManchester:
+	*p++ = manchester[octet >> 4];
+	*p++ = manchester[octet & 0xf];
+	break;
+
+    case LineCodeScrambled:
+	// Each 4 bits then the complement of the last of them, so there is a transition at least every 5 bits
+	octet ^= whitening(&_txWhitening);
+	hi = octet >> 4;
+	lo = octet & 0xf;
+	*p++ = hi | ((~hi & 0x8) << 1);
+	*p++ = lo | ((~lo & 0x8) << 1);
+	break;
+
+    default:
+	*p++ = symbols[octet >> 4];
+	*p++ = symbols[octet & 0xf];
+	break;
+    }
+    return p;
+}
+
+uint8_t RH_INTERRUPT_ATTR RH_ASK::decodeSymbol(uint16_t symbol)
+{
+    switch (_lineCode)
+    {
+    case LineCodeManchester:
+	// Each pair of bits must be different. The first of each pair is the data bit
+	if (((symbol ^ (symbol >> 1)) & 0x55) != 0x55)
+	    return RH_ASK_INVALID_SYMBOL;
+	return (symbol & 0x1) | ((symbol >> 1) & 0x2) | ((symbol >> 2) & 0x4) | ((symbol >> 3) & 0x8);
+
+    case LineCodeScrambled:
+	// The 5th bit must be the complement of the 4th
+	if (!(((symbol >> 4) ^ (symbol >> 3)) & 1))
+	    return RH_ASK_INVALID_SYMBOL;
+	return symbol & 0xf;
+
+    default:
+	return symbol_6to4(symbol);
+    }
+}
+
+uint8_t RH_INTERRUPT_ATTR RH_ASK::symbol_6to4(uint8_t symbol)
+{
+    return RH_ASK_READ_TABLE(symbols_6to4, symbol & 0x3f);
+}
+
+// Check whether the oldest received message in the queue is for us
+// Unless RH_ASK_USER_LEVEL_CRC is defined, the interrupt handler has already
+// checked the FCS, and only queues uncorrupted messages
 void RH_ASK::validateRxBuf()
 {
-    uint16_t crc = 0xffff;
+    uint8_t slot = _rxTail & (RH_ASK_RX_QUEUE_LEN - 1);
+    uint8_t* rxBuf = _rxBuf[slot];
+    uint8_t len = rxBuf[0]; // The byte count, not including any FEC parity
+    bool bad = false;
+#if RH_ASK_ERASURES
+    // Only queued so we can try to recover it
+    bad = _rxFrameBad[slot];
+#endif
+#ifdef RH_ASK_USER_LEVEL_CRC
     // The CRC covers the byte count, headers and user data
-    for (uint8_t i = 0; i < _rxBufLen; i++)
-	crc = RHcrc_ccitt_update(crc, _rxBuf[i]);
-    if (crc != 0xf0b8) // CRC when buffer and expected CRC are CRC'd
+    if (!bad && RHcrc_ccitt_block(0xffff, rxBuf, len) != 0xf0b8) // CRC when buffer and expected CRC are CRC'd
     {
-	// Reject and drop the message
 	_rxBad++;
-	_rxBufValid = false;
-	return;
+	bad = true;
+    }
+#endif
+    if (bad)
+    {
+#if RH_ASK_FEC
+	// Reconstruct the erased octets from the parity, if we have it
+	if (_rxFrameLen[slot] > len
+	    && RHfec_rs_correct_erasures(rxBuf, _rxFrameLen[slot], _rxErasures[slot], RH_ASK_FEC_PARITY_LEN)
+	    && RHcrc_ccitt_block(0xffff, rxBuf, len) == 0xf0b8)
+	{
+	    _rxFecCorrected++;
+	    bad = false;
+	}
+#endif
+#if RH_ASK_COMBINE_COPIES > 0
+	if (bad && _rxCombining && combineRxBuf(rxBuf, _rxErasures[slot], len))
+	    bad = false;
+#endif
+	if (bad)
+	{
+	    // Reject and drop the message
+	    _rxBufValid = false;
+	    return;
+	}
     }
+#if RH_ASK_COMBINE_COPIES > 0
+    else if (_rxCopyCount && len == _rxCopies[0][0]
+	     && memcmp(rxBuf, _rxCopies[0], RH_ASK_HEADER_LEN + 1) == 0)
+	_rxCopyCount = 0; // Got a good copy, so the corrupted ones we kept are no longer needed
+#endif
 
     // Extract the 4 headers that follow the message length
-    _rxHeaderTo    = _rxBuf[1];
-    _rxHeaderFrom  = _rxBuf[2];
-    _rxHeaderId    = _rxBuf[3];
-    _rxHeaderFlags = _rxBuf[4];
+    _rxHeaderTo    = rxBuf[1];
+    _rxHeaderFrom  = rxBuf[2];
+    _rxHeaderId    = rxBuf[3];
+    _rxHeaderFlags = rxBuf[4];
     if (_promiscuous ||
 	_rxHeaderTo == _thisAddress ||
 	_rxHeaderTo == RH_BROADCAST_ADDRESS)
@@ -733,18 +1741,21 @@ void RH_ASK::validateRxBuf()
 	_rxGood++;
 	_rxBufValid = true;
     }
+    else
+	_rxDropped++;
 }
 
-void RH_INTERRUPT_ATTR RH_ASK::receiveTimer()
+void RH_INTERRUPT_ATTR RH_ASK::receiveSample(bool rxSample)
 {
-    bool rxSample = readRx();
-
     // Integrate each sample
     if (rxSample)
 	_rxIntegrator++;
 
     if (rxSample != _rxLastSample)
     {
+	// When locked, transitions are seen in the first sample or so after the ramp wraps
+	receiveTransition(_rxPllRamp < (RH_ASK_RAMP_INC * 2) || _rxPllRamp >= (RH_ASK_RX_RAMP_LEN - RH_ASK_RAMP_INC));
+
 	// Transition, advance if ramp > 80, retard if < 80
 	_rxPllRamp += ((_rxPllRamp < RH_ASK_RAMP_TRANSITION) 
 			   ? RH_ASK_RAMP_INC_RETARD 
@@ -759,68 +1770,307 @@ void RH_INTERRUPT_ATTR RH_ASK::receiveTimer()
     }
     if (_rxPllRamp >= RH_ASK_RX_RAMP_LEN)
     {
-	// Add this to the 12th bit of _rxBits, LSB first
-	// The last 12 bits are kept
-	_rxBits >>= 1;
-
 	// Check the integrator to see how many samples in this cycle were high.
 	// If < 5 out of 8, then its declared a 0 bit, else a 1;
-	if (_rxIntegrator >= 5)
-	    _rxBits |= 0x800;
+	bool bit = _rxIntegrator >= 5;
 
 	_rxPllRamp -= RH_ASK_RX_RAMP_LEN;
 	_rxIntegrator = 0; // Clear the integral for the next cycle
 
-	if (_rxActive)
+	receiveBit(bit);
+    }
+}
+
+// Edge receive engine. Called on each change of the rx pin with the time of the change.
+// This is the integrate and dump receiver of receiveSample() done with timestamps instead of samples:
+// the time the line spends high in each bit period is measured exactly from the edges, and each edge
+// nudges the bit period boundaries towards itself, which does the job of the PLL.
+void RH_INTERRUPT_ATTR RH_ASK::receiveEdge(uint32_t when, bool level)
+{
+    if (level == _rxLastSample)
+	return; // We missed the other edge of a very short pulse: nothing to measure
+
+    receiveEdgeBits(when);
+    if (_rxLastSample)
+	_rxEdgeHigh += when - _rxEdgeLast;
+    _rxEdgeLast = when;
+    _rxLastSample = level;
+
+    // Transitions should happen at the bit boundaries. Move the boundary a fraction of the
+    // way towards this one
+    uint32_t offset = when - _rxEdgeTime;
+    receiveTransition(offset < (_rxEdgePeriod / 8) || offset >= (uint32_t)(_rxEdgePeriod - (_rxEdgePeriod / 8)));
+    if (offset < (_rxEdgePeriod / 2))
+	_rxEdgeTime += offset >> RH_ASK_EDGE_PLL_SHIFT; // Late, retard
+    else
+	_rxEdgeTime -= (_rxEdgePeriod - offset) >> RH_ASK_EDGE_PLL_SHIFT; // Early, advance
+}
+
+// Completes each bit period that ends before when, at the current level, and decodes its bit. 
+// If the line has been quiet for more than RH_ASK_EDGE_MAX_RUN bits, start afresh at when
+void RH_INTERRUPT_ATTR RH_ASK::receiveEdgeBits(uint32_t when)
+{
+    uint8_t bits = 0;
+    while ((uint32_t)(when - _rxEdgeTime) >= _rxEdgePeriod)
+    {
+	if (++bits > RH_ASK_EDGE_MAX_RUN)
+	{
+	    _rxEdgeTime = _rxEdgeLast = when;
+	    _rxEdgeHigh = 0;
+	    _rxCadScore = 0;
+	    _rxCadQuiet = 255;
+	    return;
+	}
+	uint32_t end = _rxEdgeTime + _rxEdgePeriod;
+	if (_rxLastSample)
+	    _rxEdgeHigh += end - _rxEdgeLast;
+	// If the line was high for more than half the bit period, its a 1 bit
+	if (_mode == RHModeRx)
+	    receiveBit(_rxEdgeHigh > (_rxEdgePeriod / 2));
+	_rxEdgeTime = _rxEdgeLast = end;
+	_rxEdgeHigh = 0;
+    }
+}
+
+// Called at user level by available(). Bits are only decoded by the interrupt handler when an edge arrives,
+// so decode any that have been completed since the last edge. Otherwise a message that ends in a run
+// of bits at the idle level would not be completed until the next edge
+void RH_ASK::receiveEdgeTimeout()
+{
+    ATOMIC_BLOCK_START;
+    receiveEdgeBits(micros());
+    ATOMIC_BLOCK_END;
+}
+
+void RH_INTERRUPT_ATTR RH_ASK::receiveTransition(bool onClock)
+{
+    if (onClock)
+    {
+	if (_rxCadScore < (RH_ASK_CAD_THRESHOLD * 2))
+	    _rxCadScore++;
+	_rxCadQuiet = 0;
+    }
+    else
+	_rxCadScore = (_rxCadScore > 2) ? _rxCadScore - 2 : 0;
+}
+
+bool RH_INTERRUPT_ATTR RH_ASK::channelActive()
+{
+    return _rxActive || (_rxCadScore >= RH_ASK_CAD_THRESHOLD && _rxCadQuiet < RH_ASK_CAD_HOLD_BITS);
+}
+
+void RH_INTERRUPT_ATTR RH_ASK::csmaTimer()
+{
+    // The edge receive engine only decodes bits when edges arrive, so bring it up to date
+    // once per bit, in case the line has gone quiet
+    if (_rxEngine == RxEngineEdge && (_txSample & 7) == 0)
+	receiveEdgeBits(micros());
+    if (channelActive())
+	return; // Someone else is transmitting: pause the backoff until they have finished
+    if (++_txSample >= (RH_ASK_CSMA_SLOT_BITS * 8))
+    {
+	_txSample = 0;
+	if (--_txBackoff == 0)
+	    setModeTx();
+    }
+}
+
+void RH_INTERRUPT_ATTR RH_ASK::receiveBit(bool bit)
+{
+    if (_rxCadQuiet < 255)
+	_rxCadQuiet++;
+
+    // Add this to the 16th bit of _rxBits, LSB first
+    // The last 16 bits are kept
+    _rxBits >>= 1;
+    if (bit)
+	_rxBits |= 0x8000;
+
+    if (_rxActive)
+    {
+	// We have the start symbol and now we are collecting message bits,
+	// _rxOctetBits / 2 per symbol, each which has to be decoded to 4 bits
+	if (++_rxBitCount >= _rxOctetBits)
 	{
-	    // We have the start symbol and now we are collecting message bits,
-	    // 6 per symbol, each which has to be decoded to 4 bits
-	    if (++_rxBitCount >= 12)
+	    // Have 1 byte encoded, in the most recent bits of _rxBits
+	    // Decode as 2 symbols into 2 lots of 4 bits
+	    // The first symbol is the high nybble
+	    uint8_t hi = decodeSymbol(_rxBits >> (16 - _rxOctetBits));
+	    uint8_t lo = decodeSymbol(_rxBits >> (16 - (_rxOctetBits / 2)));
+	    uint8_t slot = _rxHead & (RH_ASK_RX_QUEUE_LEN - 1);
+	    if ((hi | lo) == RH_ASK_INVALID_SYMBOL)
 	    {
-		// Have 12 bits of encoded message == 1 byte encoded
-		// Decode as 2 lots of 6 bits into 2 lots of 4 bits
-		// The 6 lsbits are the high nybble
-		uint8_t this_byte = 
-		    (symbol_6to4(_rxBits & 0x3f)) << 4 
-		    | symbol_6to4(_rxBits >> 6);
-
-		// The first decoded byte is the byte count of the following message
-		// the count includes the byte count and the 2 trailing FCS bytes
-		// REVISIT: may also include the ACK flag at 0x40
-		if (_rxBufLen == 0)
+#if RH_ASK_ERASURES
+		if ((_rxCombining || _rxFecFrame) && _rxBufLen > 0)
 		{
-		    // The first byte is the byte count
-		    // Check it for sensibility. It cant be less than 7, since it
-		    // includes the byte count itself, the 4 byte header and the 2 byte FCS
-		    _rxCount = this_byte;
-		    if (_rxCount < 7 || _rxCount > RH_ASK_MAX_PAYLOAD_LEN)
+		    // The message is corrupted, but the rest of it may help to recover it
+		    // with FEC parity or by combining with other copies. Mark this octet as erased and carry on
+		    if (_rxErasureCount++ == 0)
 		    {
-			// Stupid message length, drop the whole thing
+			_rxSymbolErrors++;
+			_rxSymbolErrorPosition = _rxBufLen;
+		    }
+#if RH_ASK_FEC
+		    if (_rxErasureCount > RH_ASK_FEC_PARITY_LEN && !_rxCombining)
+		    {
+			// Too many to correct. Probably not a message at all, but noise that
+			// happened to match the sync word: drop it before it hides the next one
 			_rxActive = false;
 			_rxBad++;
-                        return;
+			return;
 		    }
+#endif
+		    _rxErasures[slot][_rxBufLen >> 3] |= 1 << (_rxBufLen & 7);
+		    hi = lo = 0;
 		}
-		_rxBuf[_rxBufLen++] = this_byte;
-
-		if (_rxBufLen >= _rxCount)
+		else
+#endif
+		{
+		    // Not a valid symbol, so the message is corrupted. No point waiting
+		    // for the FCS: drop it now and start looking for the next start symbol
+		    _rxActive = false;
+		    _rxBad++;
+		    _rxSymbolErrors++;
+		    _rxSymbolErrorPosition = _rxBufLen;
+		    return;
+		}
+	    }
+	    uint8_t this_byte = (hi << 4) | lo;
+	    if (_lineCode == LineCodeScrambled)
+		this_byte ^= whitening(&_rxWhitening);
+
+	    // The first decoded byte is the byte count of the following message
+	    // the count includes the byte count and the 2 trailing FCS bytes
+	    // REVISIT: may also include the ACK flag at 0x40
+	    if (_rxBufLen == 0)
+	    {
+		// The first byte is the byte count
+		// Check it for sensibility. It cant be less than 7, since it
+		// includes the byte count itself, the 4 byte header and the 2 byte FCS
+		_rxCount = this_byte;
+		if (_rxCount < 7 || _rxCount > RH_ASK_MAX_PAYLOAD_LEN)
 		{
-		    // Got all the bytes now
+		    // Stupid message length, drop the whole thing
 		    _rxActive = false;
-		    _rxBufFull = true;
-		    setModeIdle();
+		    _rxBad++;
+		    return;
+		}
+	    }
+#if RH_ASK_FEC
+	    if (_rxBufLen == RH_ASK_HEADER_LEN && _rxFecFrame && !RH_ASK_ERASED(_rxErasures[slot], _rxBufLen)
+		&& !(this_byte & RH_ASK_FLAGS_FEC))
+	    {
+		// The FLAGS header says no FEC parity follows
+		_rxFecFrame = false;
+		if (_rxErasureCount && !_rxCombining)
+		{
+		    // Corrupted, and nothing can recover it. Drop it now
+		    _rxActive = false;
+		    _rxBad++;
+		    return;
+		}
+	    }
+#endif
+	    if (_rxBufLen == 1
+		&& _rxEarlyAddressFilter
+#if RH_ASK_ERASURES
+		&& !_rxErasureCount // Cant tell who it is for
+#endif
+		&& !_promiscuous
+		&& this_byte != _thisAddress
+		&& this_byte != RH_BROADCAST_ADDRESS)
+	    {
+		// The TO header says this message is for some other node. Dont bother
+		// with the rest of it, start looking for the next start symbol
+		_rxActive = false;
+		_rxAddressDrops++;
+		_rxDropped++;
+		return;
+	    }
+	    _rxBuf[slot][_rxBufLen++] = this_byte;
+#ifndef RH_ASK_USER_LEVEL_CRC
+	    _rxCrc = RHcrc_ccitt_update(_rxCrc, this_byte);
+#endif
+
+	    if (_rxBufLen == _rxCount)
+	    {
+		// Got all the bytes up to the FCS now
+		bool bad = false;
+#if RH_DRIVER_STATS
+		statsRxAirtime((uint32_t)_rxBufLen * _rxOctetBits * 1000000UL / _speed);
+#endif
+#ifndef RH_ASK_USER_LEVEL_CRC
+		bad = (_rxCrc != 0xf0b8); // CRC when buffer and expected CRC are CRC'd
+#endif
+#if RH_ASK_ERASURES
+		if (_rxErasureCount)
+		    bad = true;
+		_rxFrameBad[slot] = bad;
+#endif
+		if (bad)
+		    _rxBad++;
+#if RH_ASK_FEC
+		if (_rxFecFrame)
+		{
+		    // Keep going to collect the FEC parity. Even if the message is good, so
+		    // the parity is not mistaken for the sync word of another message
+		    _rxBitCount = 0;
+		    return;
 		}
-		_rxBitCount = 0;
+#endif
+		_rxActive = false;
+		if (bad && !_rxCombining)
+		    return; // Corrupted: leave the slot free for the next message
+		// Hand the slot over to the application
+		// and keep listening for the next message
+		_rxFrameLen[slot] = _rxBufLen;
+#if RH_DRIVER_STATS
+		_rxDoneTime[slot] = statsClock();
+#endif
+		_rxHead++;
+		notifyEvent();
 	    }
+#if RH_ASK_FEC
+	    else if (_rxBufLen >= _rxCount + RH_ASK_FEC_PARITY_LEN)
+	    {
+		// Got the FEC parity too. If the message is bad, available() will try to correct it
+		_rxActive = false;
+		_rxFrameLen[slot] = _rxBufLen;
+#if RH_DRIVER_STATS
+		statsRxAirtime((uint32_t)RH_ASK_FEC_PARITY_LEN * _rxOctetBits * 1000000UL / _speed);
+		_rxDoneTime[slot] = statsClock();
+#endif
+		_rxHead++;
+		notifyEvent();
+	    }
+#endif
+	    _rxBitCount = 0;
 	}
-	// Not in a message, see if we have a start symbol
-	else if (_rxBits == RH_ASK_START_SYMBOL)
+    }
+    // Not in a message, see if we have a start symbol
+    else if (syncMatch(_rxBits))
+    {
+	if ((uint8_t)(_rxHead - _rxTail) >= RH_ASK_RX_QUEUE_LEN)
 	{
-	    // Have start symbol, start collecting message
-	    _rxActive = true;
-	    _rxBitCount = 0;
-	    _rxBufLen = 0;
+	    // No free slot in the receive queue: the application is not
+	    // collecting messages fast enough
+	    _rxOverflow++;
+	    return;
 	}
+	// Have start symbol, start collecting message
+	_rxActive = true;
+	_rxBitCount = 0;
+	_rxWhitening = 0x1ff;
+	_rxBufLen = 0;
+#ifndef RH_ASK_USER_LEVEL_CRC
+	_rxCrc = 0xffff;
+#endif
+#if RH_ASK_ERASURES
+	_rxErasureCount = 0;
+	_rxFecFrame = RH_ASK_FEC; // Until the FLAGS header says otherwise
+	if (_rxCombining || _rxFecFrame)
+	    memset(_rxErasures[_rxHead & (RH_ASK_RX_QUEUE_LEN - 1)], 0, sizeof(_rxErasures[0]));
+#endif
     }
 }
 
@@ -832,19 +2082,34 @@ void RH_INTERRUPT_ATTR RH_ASK::transmitTimer()
 	// Symbols are sent LSB first
 	// Finished sending the whole message? (after waiting one bit period 
 	// since the last bit)
-	if (_txIndex >= _txBufLen)
+	uint8_t slot = _txTail & (RH_ASK_TX_QUEUE_LEN - 1);
+	if (_txIndex >= _txBufLen[slot])
 	{
-	    setModeIdle();
+#if RH_DRIVER_STATS
+	    // The preamble in 6 bit symbols, the rest in _txSymbolBits symbols, and the bit period just waited
+	    uint16_t bits = (RH_ASK_PREAMBLE_LEN - _txStart) * 6
+		+ (_txBufLen[slot] - RH_ASK_PREAMBLE_LEN) * _txSymbolBits + 1;
+	    statsTxDone(_txSendTime[slot], (uint32_t)bits * 1000000UL / _speed);
+#endif
 	    _txGood++;
-	}
-	else
-	{
-	    writeTx(_txBuf[_txIndex] & (1 << _txBit++));
-	    if (_txBit >= 6)
+	    _txTail++;
+	    notifyEvent(); // A slot is free for send()
+	    if (_txTail == _txHead)
 	    {
-		_txBit = 0;
-		_txIndex++;
+		// Queue is empty
+		setModeIdle();
+		return;
 	    }
+	    // Chain straight into the preamble of the next queued message
+	    slot = _txTail & (RH_ASK_TX_QUEUE_LEN - 1);
+	    _txIndex = _txStart;
+	    _txBit = 0;
+	}
+	writeTx(_txBuf[slot][_txIndex] & (1 << _txBit++));
+	if (_txBit >= ((_txIndex < RH_ASK_PREAMBLE_LEN) ? 6 : _txSymbolBits))
+	{
+	    _txBit = 0;
+	    _txIndex++;
 	}
     }
 	
@@ -852,12 +2117,36 @@ void RH_INTERRUPT_ATTR RH_ASK::transmitTimer()
 	_txSample = 0;
 }
 
+void RH_INTERRUPT_ATTR RH_ASK::handleEdgeInterrupt()
+{
+    RH_ISR_STATS_START
+    receiveEdge(micros(), readRx());
+    RH_ISR_STATS_END(this)
+}
+
 void RH_INTERRUPT_ATTR RH_ASK::handleTimerInterrupt()
 {
+    RH_ISR_STATS_START
+#if RH_ASK_RATE_ADAPTATION
+    if ((++_rateTicks & 7) == 0)
+    {
+	// Rate adaptation timers, once per bit period. available() has work to do when they run out
+	if (_rateTimeout && --_rateTimeout == 0)
+	    notifyEvent();
+	if (_rateReportDue && --_rateReportDue == 0)
+	    notifyEvent();
+    }
+#endif
     if (_mode == RHModeRx)
-	receiveTimer(); // Receiving
+    {
+	if (_rxEngine == RxEngineOversample)
+	    receiveSample(readRx()); // Receiving
+	if (_txBackoff)
+	    csmaTimer(); // Waiting to transmit
+    }
     else if (_mode == RHModeTx)
         transmitTimer(); // Transmitting
+    RH_ISR_STATS_END(this)
 }
 
 #endif //_SAMD51__
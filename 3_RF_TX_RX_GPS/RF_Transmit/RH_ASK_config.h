@@ -0,0 +1,13 @@
+// RH_ASK_config.h
+// RH_ASK settings for the transmitter sketch. See RH_ASK.h
+
+// Queue the repeated copies of each message, so sending them does not block loop()
+// long enough for the GPS SoftwareSerial buffer to overflow. loop() queues each copy as the
+// previous one finishes, so 2 slots are enough. Each slot costs about 150 octets of SRAM
+#define RH_ASK_TX_QUEUE_LEN 2
+
+#if defined(__AVR__)
+// The sketch sends forward error correction parity with each message.
+// Forward error correction is left out by default on AVR to save flash and SRAM
+ #define RH_ASK_FEC 1
+#endif
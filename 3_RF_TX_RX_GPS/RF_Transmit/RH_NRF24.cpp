@@ -193,13 +193,14 @@ bool RH_NRF24::send(const uint8_t* data, uint8_t len)
     if (!waitCAD()) 
 	return false;  // Check channel activity
 
-    // Set up the headers
-    _buf[0] = _txHeaderTo;
-    _buf[1] = _txHeaderFrom;
-    _buf[2] = _txHeaderId;
-    _buf[3] = _txHeaderFlags;
-    memcpy(_buf+RH_NRF24_HEADER_LEN, data, len);
-    spiBurstWrite(RH_NRF24_COMMAND_W_TX_PAYLOAD_NOACK, _buf, len + RH_NRF24_HEADER_LEN);
+    // Set up the headers. The data goes straight to the radio, so _buf, which may hold a
+    // received message lent out by recvView(), is left alone
+    uint8_t headers[RH_NRF24_HEADER_LEN];
+    headers[0] = _txHeaderTo;
+    headers[1] = _txHeaderFrom;
+    headers[2] = _txHeaderId;
+    headers[3] = _txHeaderFlags;
+    spiBurstWrite(RH_NRF24_COMMAND_W_TX_PAYLOAD_NOACK, headers, RH_NRF24_HEADER_LEN, data, len);
     setModeTx();
     // Radio will return to Standby II mode after transmission is complete
     _txGood++;
@@ -339,10 +340,32 @@ bool RH_NRF24::recv(uint8_t* buf, uint8_t* len)
 	    *len = _bufLen-RH_NRF24_HEADER_LEN;
 	memcpy(buf, _buf+RH_NRF24_HEADER_LEN, *len);
     }
+    _rxView = false;
     clearRxBuf(); // This message accepted and cleared
     return true;
 }
 
+bool RH_NRF24::recvView(const uint8_t** buf, uint8_t* len, uint8_t* copy, uint8_t copyLen)
+{
+    (void)copy; // _buf can always be lent out
+    (void)copyLen;
+    if (!available())
+	return false;
+    // available() reads nothing more from the radio while _rxBufValid
+    *buf = _buf+RH_NRF24_HEADER_LEN;
+    *len = _bufLen-RH_NRF24_HEADER_LEN;
+    _rxView = true;
+    return true;
+}
+
+void RH_NRF24::release()
+{
+    if (!_rxView)
+	return;
+    _rxView = false;
+    clearRxBuf();
+}
+
 uint8_t RH_NRF24::maxMessageLength()
 {
     return RH_NRF24_MAX_MESSAGE_LEN;
@@ -587,6 +587,19 @@ public:
     /// \return true if a valid message was copied to buf
     bool        recv(uint8_t* buf, uint8_t* len);
 
+    /// Returns a pointer to the received message in the driver's buffer, without copying it.
+    /// No more messages are read from the radio's RX FIFO until release().
+    /// See RHGenericDriver::recvView()
+    /// \param[out] buf Set to point to the message
+    /// \param[out] len Set to the length of the message
+    /// \param[in] copy Not used
+    /// \param[in] copyLen Not used
+    /// \return true if there was a valid message
+    bool        recvView(const uint8_t** buf, uint8_t* len, uint8_t* copy = NULL, uint8_t copyLen = 0);
+
+    /// Frees the driver's buffer after recvView(), so the next message can be read from the RX FIFO
+    void        release();
+
     /// The maximum message length supported by this driver
     /// \return The maximum message length supported by this driver
     uint8_t maxMessageLength();
@@ -88,6 +88,8 @@ bool RH_RF95::init()
 	attachInterrupt(interruptNumber, isr2, RISING);
     else
 	return false; // Too many devices, not enough interrupt vectors
+    _eventDriven = true; // handleInterrupt() wakes up the wait functions
+    _asyncSend = true; // and sees the end of each transmission
 
     // Set up FIFO
     // We configure so that we can use the entire 256 byte FIFO for either receive
@@ -173,6 +175,7 @@ void RH_RF95::handleInterrupt()
     else if (_mode == RHModeTx && irq_flags & RH_RF95_TX_DONE)
     {
 	_txGood++;
+	statsTxDone();
 	setModeIdle();
     }
     else if (_mode == RHModeCad && irq_flags & RH_RF95_CAD_DONE)
@@ -184,6 +187,7 @@ void RH_RF95::handleInterrupt()
     // clear the radio's interrupt flag. So we do it twice. Why?
     spiWrite(RH_RF95_REG_12_IRQ_FLAGS, 0xff); // Clear all IRQ flags
     spiWrite(RH_RF95_REG_12_IRQ_FLAGS, 0xff); // Clear all IRQ flags
+    notifyEvent();
 }
 
 // These are low level functions that call the interrupt handler for the correct
@@ -192,17 +196,29 @@ void RH_RF95::handleInterrupt()
 void RH_INTERRUPT_ATTR RH_RF95::isr0()
 {
     if (_deviceForInterrupt[0])
+    {
+	RH_ISR_STATS_START
 	_deviceForInterrupt[0]->handleInterrupt();
+	RH_ISR_STATS_END(_deviceForInterrupt[0])
+    }
 }
 void RH_INTERRUPT_ATTR RH_RF95::isr1()
 {
     if (_deviceForInterrupt[1])
+    {
+	RH_ISR_STATS_START
 	_deviceForInterrupt[1]->handleInterrupt();
+	RH_ISR_STATS_END(_deviceForInterrupt[1])
+    }
 }
 void RH_INTERRUPT_ATTR RH_RF95::isr2()
 {
     if (_deviceForInterrupt[2])
+    {
+	RH_ISR_STATS_START
 	_deviceForInterrupt[2]->handleInterrupt();
+	RH_ISR_STATS_END(_deviceForInterrupt[2])
+    }
 }
 
 // Check whether the latest received message is complete and uncorrupted
@@ -220,6 +236,7 @@ void RH_RF95::validateRxBuf()
 	_rxHeaderTo == RH_BROADCAST_ADDRESS)
     {
 	_rxGood++;
+	statsRxDone();
 	_rxBufValid = true;
     }
 }
@@ -228,7 +245,8 @@ bool RH_RF95::available()
 {
     if (_mode == RHModeTx)
 	return false;
-    setModeRx();
+    if (!_rxView)
+	setModeRx(); // Not while recvView() has lent out _buf
     return _rxBufValid; // Will be set by the interrupt handler when a good message is received
 }
 
@@ -253,10 +271,40 @@ bool RH_RF95::recv(uint8_t* buf, uint8_t* len)
 	memcpy(buf, _buf+RH_RF95_HEADER_LEN, *len);
 	ATOMIC_BLOCK_END;
     }
+    if (!_rxView)
+	statsRecv();
+    _rxView = false;
     clearRxBuf(); // This message accepted and cleared
     return true;
 }
 
+bool RH_RF95::recvView(const uint8_t** buf, uint8_t* len, uint8_t* copy, uint8_t copyLen)
+{
+    (void)copy; // _buf can always be lent out
+    (void)copyLen;
+    if (!available())
+	return false;
+    if (!_rxView)
+    {
+	// available() may have restarted the receiver, which would overwrite _buf
+	setModeIdle();
+	statsRecv();
+	_rxView = true;
+    }
+    // Skip the 4 headers that are at the beginning of the rxBuf
+    *buf = _buf+RH_RF95_HEADER_LEN;
+    *len = _bufLen-RH_RF95_HEADER_LEN;
+    return true;
+}
+
+void RH_RF95::release()
+{
+    if (!_rxView)
+	return;
+    _rxView = false;
+    clearRxBuf();
+}
+
 bool RH_RF95::send(const uint8_t* data, uint8_t len)
 {
     if (len > RH_RF95_MAX_MESSAGE_LEN)
@@ -279,6 +327,7 @@ bool RH_RF95::send(const uint8_t* data, uint8_t len)
     spiBurstWrite(RH_RF95_REG_00_FIFO, data, len);
     spiWrite(RH_RF95_REG_22_PAYLOAD_LENGTH, len + RH_RF95_HEADER_LEN);
 
+    statsTxStart();
     setModeTx(); // Start the transmitter
     // when Tx is done, interruptHandler will fire and radio mode will return to STANDBY
     return true;
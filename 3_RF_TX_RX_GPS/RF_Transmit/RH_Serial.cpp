@@ -106,16 +106,11 @@ void  RH_Serial::handleRx(uint8_t ch)
 	case RxStateEscape:
 	{
 	    if (ch == ETX)
-	    {
-		// add fcs for DLE, ETX
-		_rxFcs = RHcrc_ccitt_update(_rxFcs, DLE);
-		_rxFcs = RHcrc_ccitt_update(_rxFcs, ETX);
 		_rxState = RxStateWaitFCS1; // End frame
-	    }
 	    else if (ch == DLE)
 	    {
-		appendRxBuf(ch);
 		_rxState = RxStateData;
+		appendRxBuf(ch);
 	    }
 	    else
 		_rxState = RxStateIdle; // Unexpected
@@ -152,18 +147,22 @@ void RH_Serial::clearRxBuf()
 void RH_Serial::appendRxBuf(uint8_t ch)
 {
     if (_rxBufLen < RH_SERIAL_MAX_PAYLOAD_LEN)
+	_rxBuf[_rxBufLen++] = ch; // Normal data, save. FCS is calculated when the frame is complete
+    else
     {
-	// Normal data, save and add to FCS
-	_rxBuf[_rxBufLen++] = ch;
-	_rxFcs = RHcrc_ccitt_update(_rxFcs, ch);
+	// If the buffer overflows, the message can never be valid, so drop it
+	_rxBad++;
+	_rxState = RxStateIdle;
     }
-    // If the buffer overflows, we dont record the trailing data, and the FCS will be wrong,
-    // causing the message to be dropped when the FCS is received
 }
 
 // Check whether the latest received message is complete and uncorrupted
 void RH_Serial::validateRxBuf()
 {
+    // The FCS covers the (unstuffed) headers and payload, then DLE, ETX
+    static const uint8_t trailer[] = { DLE, ETX };
+    _rxFcs = RHcrc_ccitt_block(0xffff, _rxBuf, _rxBufLen);
+    _rxFcs = RHcrc_ccitt_block(_rxFcs, trailer, sizeof(trailer));
     if (_rxRecdFcs != _rxFcs)
     {
 	_rxBad++;
@@ -195,10 +194,32 @@ bool RH_Serial::recv(uint8_t* buf, uint8_t* len)
 	    *len = _rxBufLen-RH_SERIAL_HEADER_LEN;
 	memcpy(buf, _rxBuf+RH_SERIAL_HEADER_LEN, *len);
     }
+    _rxView = false;
     clearRxBuf(); // This message accepted and cleared
     return true;
 }
 
+bool RH_Serial::recvView(const uint8_t** buf, uint8_t* len, uint8_t* copy, uint8_t copyLen)
+{
+    (void)copy; // _rxBuf can always be lent out
+    (void)copyLen;
+    if (!available())
+	return false;
+    // available() reads nothing more from the port while _rxBufValid
+    *buf = _rxBuf+RH_SERIAL_HEADER_LEN;
+    *len = _rxBufLen-RH_SERIAL_HEADER_LEN;
+    _rxView = true;
+    return true;
+}
+
+void RH_Serial::release()
+{
+    if (!_rxView)
+	return;
+    _rxView = false;
+    clearRxBuf();
+}
+
 // Caution: this may block
 bool RH_Serial::send(const uint8_t* data, uint8_t len)
 {
@@ -208,22 +229,24 @@ bool RH_Serial::send(const uint8_t* data, uint8_t len)
     if (!waitCAD()) 
 	return false;  // Check channel activity
 
-    _txFcs = 0xffff;    // Initial value
+    // The FCS covers the 4 headers, the payload and the DLE, ETX at the end
+    uint8_t header[RH_SERIAL_HEADER_LEN] = { _txHeaderTo, _txHeaderFrom, _txHeaderId, _txHeaderFlags };
+    static const uint8_t trailer[] = { DLE, ETX };
+    _txFcs = RHcrc_ccitt_block(0xffff, header, sizeof(header));
+    _txFcs = RHcrc_ccitt_block(_txFcs, data, len);
+    _txFcs = RHcrc_ccitt_block(_txFcs, trailer, sizeof(trailer));
+
     _serial.write(DLE); // Not in FCS
     _serial.write(STX); // Not in FCS
     // First the 4 headers
-    txData(_txHeaderTo);
-    txData(_txHeaderFrom);
-    txData(_txHeaderId);
-    txData(_txHeaderFlags);
+    for (uint8_t i = 0; i < sizeof(header); i++)
+	txData(header[i]);
     // Now the payload
     while (len--)
 	txData(*data++);
     // End of message
     _serial.write(DLE);
-    _txFcs = RHcrc_ccitt_update(_txFcs, DLE);
     _serial.write(ETX);
-    _txFcs = RHcrc_ccitt_update(_txFcs, ETX);
 
     // Now send the calculated FCS for this message
     _serial.write((_txFcs >> 8) & 0xff);
@@ -236,7 +259,6 @@ void  RH_Serial::txData(uint8_t ch)
     if (ch == DLE)    // DLE stuffing required?
 	_serial.write(DLE); // Not in FCS
     _serial.write(ch);
-    _txFcs = RHcrc_ccitt_update(_txFcs, ch);
 }
 
 uint8_t RH_Serial::maxMessageLength()
@@ -109,6 +109,19 @@ public:
     /// \return true if a valid message was copied to buf
     virtual bool recv(uint8_t* buf, uint8_t* len);
 
+    /// Returns a pointer to the received message in the driver's buffer, without copying it.
+    /// No more packets are read from the socket until release().
+    /// See RHGenericDriver::recvView()
+    /// \param[out] buf Set to point to the message
+    /// \param[out] len Set to the length of the message
+    /// \param[in] copy Not used
+    /// \param[in] copyLen Not used
+    /// \return true if there was a valid message
+    virtual bool recvView(const uint8_t** buf, uint8_t* len, uint8_t* copy = NULL, uint8_t copyLen = 0);
+
+    /// Frees the driver's buffer after recvView(), so the next packet can be received
+    virtual void release();
+
     /// Waits until any previous transmit packet is finished being transmitted with waitPacketSent().
     /// Then loads a message into the transmitter and starts the transmitter. Note that a message length
     /// of 0 is NOT permitted. If the message is too long for the underlying radio technology, send() will
@@ -118,6 +131,15 @@ public:
     /// \return true if the message length was valid and it was correctly queued for transmit
     virtual bool send(const uint8_t* data, uint8_t len);
 
+    /// Writes a message to the simulator like send(), but without send()'s 10 ms wait for it to be transmitted.
+    /// service() calls callback the next time it is called.
+    /// \param[in] data Array of data to be sent
+    /// \param[in] len Number of bytes of data to send (> 0)
+    /// \param[in] callback Function to call when the message has been transmitted, or NULL
+    /// \param[in] context Passed to callback
+    /// \return true if the message was written to the simulator
+    virtual bool sendAsync(const uint8_t* data, uint8_t len, SendCallback callback = NULL, void* context = NULL);
+
     /// Returns the maximum message length 
     /// available in this Driver.
     /// \return The maximum legal message length
@@ -18,9 +18,14 @@
 extern int    _simulator_argc;
 extern char** _simulator_argv;
 
+// Digital pin levels
+#define HIGH 0x1
+#define LOW  0x0
+
 // Definitions for various Arduino functions
 extern void delay(unsigned long ms);
 extern unsigned long millis();
+extern unsigned long micros();
 extern long random(long to);
 extern long random(long from, long to);
 
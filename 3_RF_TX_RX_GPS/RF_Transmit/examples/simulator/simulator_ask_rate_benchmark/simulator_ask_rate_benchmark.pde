@@ -0,0 +1,184 @@
+// simulator_ask_rate_benchmark.pde
+// -*- mode: C++ -*-
+// Measures the goodput of an RH_ASK link at each fixed speed, and with rate adaptation (setRateAdaptation()),
+// over a range of link qualities, like moving the nodes further apart.
+// Node A sends a stream of messages to node B, with CSMA, as fast as it can. B sends nothing but the
+// rate adaptation reports and handshake. Both nodes run their timer interrupts in simulated time.
+// The channel inverts each bit sent with a probability that depends on the energy per bit:
+// for OOK with a noncoherent receiver, BER = 0.5 * exp(-Eb/N0 / 2), and Eb/N0 is inversely
+// proportional to the bit rate. The link quality is given as Eb/N0 at 1000 bps.
+// While neither node is transmitting, the channel carries random noise, as real ASK receivers output.
+// The report shows the goodput (user data received by B per second) for each, and for rate adaptation
+// the mean speed and the number of speed changes. Rate adaptation starts at the lowest speed, so its goodput
+// includes the time taken to climb the ladder.
+// Tested on Linux
+// Build with
+// cd whatever/RadioHead
+// tools/simBuild examples/simulator/simulator_ask_rate_benchmark/simulator_ask_rate_benchmark.pde
+// Run with ./simulator_ask_rate_benchmark
+
+#include <RH_ASK.h>
+
+#if !RH_ASK_RATE_ADAPTATION
+#error setRateAdaptation() needs RH_ASK_RATE_ADAPTATION, build with CPPFLAGS=-DRH_ASK_RATE_ADAPTATION=1
+#endif
+#include <math.h>
+
+#define SECONDS 300      // Simulated time for each run
+#define MESSAGE_LEN 20   // Like a GPS position
+#define GAP_BITS 20      // A waits this many bit periods after each message, so B can get a word in
+#define POLL_STEPS 64    // Nodes call available() every this many simulated clock steps (1ms)
+
+static const uint16_t speeds[] = { 1000, 2000, 4000, 8000 };
+#define NUM_SPEEDS (sizeof(speeds) / sizeof(speeds[0]))
+
+// The simulated clock runs at 8 samples per bit at the highest speed
+#define CLOCK_HZ (8UL * 8000)
+
+// Link quality: Eb/N0 in dB at 1000 bps
+static const double ebn0s[] = { 28, 24, 20, 17, 14, 11 };
+#define NUM_EBN0S (sizeof(ebn0s) / sizeof(ebn0s[0]))
+
+class SimASK : public RH_ASK
+{
+public:
+    SimASK() : RH_ASK(speeds[0]) {}
+    // Runs the timer interrupt with the rx pin at level, and returns the tx pin, and whether transmitting
+    bool tick(bool level, bool* transmitting)
+    {
+	_rxLevel = level;
+	handleTimerInterrupt();
+	*transmitting = _mode == RHModeTx;
+	return _txLevel;
+    }
+    uint8_t txSample() { return _txSample; }
+};
+
+static double berAt(double ebn0dB, uint16_t speed)
+{
+    double ebn0 = pow(10, ebn0dB / 10) * 1000 / speed;
+    return 0.5 * exp(-ebn0 / 2);
+}
+
+typedef struct
+{
+    double   goodput;   // Bits of user data received per second
+    double   meanSpeed; // Mean speed of A
+    uint16_t changes;   // Speed changes by A
+} Result;
+
+// Runs A and B for SECONDS at fixed speed, or with rate adaptation if speed is 0
+static Result run(double ebn0dB, uint16_t speed)
+{
+    SimASK a, b;
+    SimASK* nodes[2] = { &a, &b };
+    a.init();
+    b.init();
+    a.setThisAddress(1);
+    a.setHeaderFrom(1);
+    a.setHeaderTo(2);
+    b.setThisAddress(2);
+    b.setHeaderFrom(2);
+    b.setHeaderTo(1);
+    a.setCsma(true);
+    b.setCsma(true);
+    if (speed)
+    {
+	a.setSpeed(speed);
+	b.setSpeed(speed);
+    }
+    else
+    {
+	a.setRateAdaptation(speeds, NUM_SPEEDS);
+	b.setRateAdaptation(speeds, NUM_SPEEDS);
+    }
+    a.available(); // Start receiving
+    b.available();
+    srandom(1);
+
+    const uint32_t steps = SECONDS * CLOCK_HZ;
+    uint32_t nextSeq = 0, received = 0, lastSeq = 0xffffffff;
+    uint32_t gap = 0; // Steps until A sends again
+    double speedSum = 0;
+    bool flip[2] = { false, false };         // Each transmitter's current bit is inverted by noise
+    bool txOn[2] = { false, false };         // Each node is transmitting
+    bool txLevel[2] = { false, false };      // Each node's transmitter output
+    bool level = false;
+    uint8_t buf[RH_ASK_MAX_MESSAGE_LEN];
+    uint8_t len;
+    for (uint32_t step = 0; step < steps; step++)
+    {
+	for (uint8_t n = 0; n < 2; n++)
+	{
+	    SimASK* node = nodes[n];
+	    if (step % (CLOCK_HZ / 8 / node->speed()))
+		continue; // Not this node's timer interrupt
+	    if (node->txSample() == 0)
+		flip[n] = random() < berAt(ebn0dB, node->speed()) * RAND_MAX; // New bit: is it corrupted?
+	    txLevel[n] = node->tick(level, &txOn[n]) ^ flip[n];
+	}
+	if (txOn[0] || txOn[1])
+	    level = (txOn[0] && txLevel[0]) || (txOn[1] && txLevel[1]);
+	else if ((random() & 7) == 0)
+	    level = random() & 1; // Noise between transmissions
+
+	if (step % POLL_STEPS)
+	    continue;
+	speedSum += a.speed();
+	len = sizeof(buf);
+	while (a.recv(buf, &len)) // Only rate adaptation messages come this way
+	    len = sizeof(buf);
+	len = sizeof(buf);
+	while (b.recv(buf, &len))
+	{
+	    uint32_t seq;
+	    memcpy(&seq, buf, sizeof(seq));
+	    if (len == MESSAGE_LEN && seq != lastSeq)
+		received++;
+	    lastSeq = seq;
+	    len = sizeof(buf);
+	}
+	// A keeps one message in the transmit queue, with a short gap after each
+	if (a.txQueueDepth() == 0 && a.mode() != RHGenericDriver::RHModeTx)
+	{
+	    if (gap == 0)
+	    {
+		memset(buf, nextSeq, MESSAGE_LEN);
+		memcpy(buf, &nextSeq, sizeof(nextSeq));
+		nextSeq++;
+		a.send(buf, MESSAGE_LEN);
+		gap = GAP_BITS * (CLOCK_HZ / 8) / a.speed();
+	    }
+	    else
+		gap = gap > POLL_STEPS ? gap - POLL_STEPS : 0;
+	}
+    }
+    Result r;
+    r.goodput = (double)received * MESSAGE_LEN * 8 / SECONDS;
+    r.meanSpeed = speedSum / (steps / POLL_STEPS);
+    r.changes = a.rateChanges();
+    return r;
+}
+
+void setup()
+{
+    printf("RH_ASK goodput in bps against link quality, %d octet messages sent as fast as possible for %d s\n",
+	   MESSAGE_LEN, SECONDS);
+    printf("%-14s", "Eb/N0@1000bps");
+    for (uint8_t s = 0; s < NUM_SPEEDS; s++)
+	printf(" %6ubps", speeds[s]);
+    printf("   adaptive (mean speed, changes)\n");
+    for (uint8_t e = 0; e < NUM_EBN0S; e++)
+    {
+	printf("%9.0f dB  ", ebn0s[e]);
+	for (uint8_t s = 0; s < NUM_SPEEDS; s++)
+	    printf(" %9.0f", run(ebn0s[e], speeds[s]).goodput);
+	Result r = run(ebn0s[e], 0);
+	printf("   %7.0f (%4.0f, %u)\n", r.goodput, r.meanSpeed, r.changes);
+    }
+    exit(0);
+}
+
+void loop()
+{
+}
@@ -0,0 +1,138 @@
+// simulator_ask_send_async.pde
+// -*- mode: C++ -*-
+// Shows how much work the application gets done while it sends messages, first with send() and
+// waitPacketSent(), then with sendAsync() and a completion callback.
+// A timer thread plays the part of the timer interrupt, running the handler of an RH_ASK transmitter
+// at 8 times the bit rate. The main thread sends MESSAGES messages, and does a unit of work
+// (WORK_US of computation) whenever it is not blocked in the driver.
+// Tested on Linux
+// Build with
+// cd whatever/RadioHead
+// tools/simBuild examples/simulator/simulator_ask_send_async/simulator_ask_send_async.pde
+// Run with ./simulator_ask_send_async
+
+#include <RH_ASK.h>
+#include <pthread.h>
+#include <time.h>
+
+#define SPEED 2000
+#define MESSAGE_LEN 20   // Like a GPS position
+#define MESSAGES 10
+#define WORK_US 100
+
+// Drive the driver one timer tick at a time
+class SimASK : public RH_ASK
+{
+public:
+    SimASK() : RH_ASK(SPEED) {}
+    void tick() { handleTimerInterrupt(); }
+};
+
+static SimASK tx;
+static volatile bool running;
+static unsigned long sent;
+
+static uint64_t nanos()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void* timerThread(void*)
+{
+    uint64_t start = nanos();
+    uint64_t ticks = 0;
+    struct timespec until;
+    clock_gettime(CLOCK_MONOTONIC, &until);
+    while (running)
+    {
+	// Sleep until the next millisecond, then catch up with the ticks that are due
+	until.tv_nsec += 1000000L;
+	if (until.tv_nsec >= 1000000000L)
+	{
+	    until.tv_sec++;
+	    until.tv_nsec -= 1000000000L;
+	}
+	clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL);
+	uint64_t due = (nanos() - start) * 8 * SPEED / 1000000000ULL;
+	for (; ticks < due; ticks++)
+	    tx.tick();
+    }
+    return NULL;
+}
+
+// Something useful the application could be doing instead of waiting
+static void work()
+{
+    uint64_t until = nanos() + WORK_US * 1000ULL;
+    while (nanos() < until)
+	;
+}
+
+static void sendNext(void* context);
+
+static void sendMessage()
+{
+    uint8_t buf[MESSAGE_LEN];
+    memset(buf, sent, sizeof(buf));
+    tx.sendAsync(buf, sizeof(buf), sendNext, NULL);
+}
+
+// Called by service() when each message has been transmitted
+static void sendNext(void*)
+{
+    if (++sent < MESSAGES)
+	sendMessage();
+}
+
+static void report(const char* name, unsigned long works, uint64_t ns)
+{
+    printf("%-26s %8lu %10.0f %8.1f%%\n", name, works, ns / 1000000.0, works * WORK_US * 100000.0 / ns);
+}
+
+void setup()
+{
+    tx.init();
+    running = true;
+    pthread_t timer;
+    pthread_create(&timer, NULL, timerThread, NULL);
+
+    printf("%d messages of %d octets at %d bps\n", MESSAGES, MESSAGE_LEN, SPEED);
+    printf("%-26s %8s %10s %9s\n", "", "work", "ms", "cpu");
+
+    // Blocking: work only between messages
+    unsigned long works = 0;
+    uint64_t start = nanos();
+    uint8_t buf[MESSAGE_LEN];
+    for (sent = 0; sent < MESSAGES; sent++)
+    {
+	memset(buf, sent, sizeof(buf));
+	tx.send(buf, sizeof(buf));
+	tx.waitPacketSent();
+	work();
+	works++;
+    }
+    report("send() + waitPacketSent()", works, nanos() - start);
+
+    // Asynchronous: work all the time, and send the next message from the callback
+    works = 0;
+    sent = 0;
+    start = nanos();
+    sendMessage();
+    while (sent < MESSAGES)
+    {
+	tx.service();
+	work();
+	works++;
+    }
+    report("sendAsync() + service()", works, nanos() - start);
+
+    running = false;
+    pthread_join(timer, NULL);
+    exit(0);
+}
+
+void loop()
+{
+}
@@ -0,0 +1,147 @@
+// simulator_ask_stats.pde
+// -*- mode: C++ -*-
+// Shows the driver statistics (stats()) of an RH_ASK transmitter and receiver in real time.
+// A timer thread plays the part of the timer interrupt, running the handlers of both drivers at
+// 8 times the bit rate, with the transmitter output fed straight to the receiver.
+// The main thread sends messages back to back, and collects them as they arrive, except that out of
+// every CYCLE messages it leaves the first HOLD in the receive queue, so they wait there,
+// and some are lost when it fills. The stats show the airtime and duty cycle, the latency
+// histograms, and the overflow count.
+// Tested on Linux
+// Build with
+// cd whatever/RadioHead
+// tools/simBuild examples/simulator/simulator_ask_stats/simulator_ask_stats.pde
+// Run with ./simulator_ask_stats
+
+#include <RH_ASK.h>
+#include <pthread.h>
+#include <time.h>
+
+#if !RH_DRIVER_STATS
+ #error Build without CPPFLAGS=-DRH_DRIVER_STATS=0 to get the airtime and latency stats
+#endif
+
+#define SPEED 2000
+#define MESSAGE_LEN 20   // Like a GPS position
+#define CYCLE 10
+#define HOLD 6          // More than RH_ASK_RX_QUEUE_LEN
+#define RUN_MS 10000
+
+// Drive the drivers one timer tick at a time
+class SimASK : public RH_ASK
+{
+public:
+    SimASK() : RH_ASK(SPEED) {}
+    bool tick(bool level) { _rxLevel = level; handleTimerInterrupt(); return _txLevel; }
+};
+
+static SimASK tx, rx;
+static volatile bool running;
+
+static uint64_t nanos()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void* timerThread(void*)
+{
+    uint64_t start = nanos();
+    uint64_t ticks = 0;
+    struct timespec until;
+    clock_gettime(CLOCK_MONOTONIC, &until);
+    while (running)
+    {
+	// Sleep until the next millisecond, then catch up with the ticks that are due
+	until.tv_nsec += 1000000L;
+	if (until.tv_nsec >= 1000000000L)
+	{
+	    until.tv_sec++;
+	    until.tv_nsec -= 1000000000L;
+	}
+	clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL);
+	uint64_t due = (nanos() - start) * 8 * SPEED / 1000000000ULL;
+	for (; ticks < due; ticks++)
+	    rx.tick(tx.tick(false));
+    }
+    return NULL;
+}
+
+static void printHistogram(const char* name, const uint32_t* histogram)
+{
+    printf("  %-12s", name);
+    for (uint8_t i = 0; i < RH_DRIVER_STATS_BUCKETS; i++)
+	printf(" %5lu", (unsigned long)histogram[i]);
+    printf("\n");
+}
+
+static void report(const char* name, RHGenericDriver& driver, bool reset)
+{
+    RHGenericDriver::Stats stats;
+    driver.stats(&stats, reset);
+    printf("%s: after %lu ms\n", name, (unsigned long)stats.elapsed);
+    printf("  rxGood %lu rxBad %lu txGood %lu rxOverflow %lu rxDropped %lu\n",
+	   (unsigned long)stats.rxGood, (unsigned long)stats.rxBad, (unsigned long)stats.txGood,
+	   (unsigned long)stats.rxOverflow, (unsigned long)stats.rxDropped);
+    printf("  rxAirtime %llu ms (%.1f%%) txAirtime %llu ms (%.1f%%)\n",
+	   (unsigned long long)stats.rxAirtime / 1000, stats.elapsed ? stats.rxAirtime / 10.0 / stats.elapsed : 0.0,
+	   (unsigned long long)stats.txAirtime / 1000, stats.elapsed ? stats.txAirtime / 10.0 / stats.elapsed : 0.0);
+    printf("  rxLatencyMax %lu us txLatencyMax %lu us\n",
+	   (unsigned long)stats.rxLatencyMax, (unsigned long)stats.txLatencyMax);
+    printf("  %-12s", "< ms");
+    for (uint8_t i = 0; i < RH_DRIVER_STATS_BUCKETS - 1; i++)
+	printf(" %5.4g", (64UL << i) / 1000.0);
+    printf("  more\n");
+    printHistogram("rxLatency", stats.rxLatency);
+    printHistogram("txLatency", stats.txLatency);
+}
+
+void setup()
+{
+    tx.init();
+    rx.init();
+    rx.available(); // Start receiving
+
+    pthread_t timer;
+    running = true;
+    pthread_create(&timer, NULL, timerThread, NULL);
+
+    uint8_t buf[RH_ASK_MAX_MESSAGE_LEN];
+    uint8_t len;
+    unsigned long sent = 0, received = 0;
+    unsigned long start = millis();
+    while (millis() - start < RUN_MS)
+    {
+	memset(buf, sent, MESSAGE_LEN);
+	tx.send(buf, MESSAGE_LEN); // Waits for the previous message to finish
+	if (sent++ % CYCLE < HOLD)
+	    continue; // Not collecting
+	len = sizeof(buf);
+	while (rx.recv(buf, &len))
+	{
+	    received++;
+	    len = sizeof(buf);
+	}
+    }
+    tx.waitPacketSent();
+    delay(10);
+    len = sizeof(buf);
+    while (rx.recv(buf, &len))
+    {
+	received++;
+	len = sizeof(buf);
+    }
+    running = false;
+    pthread_join(timer, NULL);
+
+    printf("%d octet messages at %d bps: sent %lu, received %lu\n", MESSAGE_LEN, SPEED, sent, received);
+    report("Transmitter", tx, false);
+    report("Receiver", rx, true);
+    report("Receiver after reset", rx, false);
+    exit(0);
+}
+
+void loop()
+{
+}
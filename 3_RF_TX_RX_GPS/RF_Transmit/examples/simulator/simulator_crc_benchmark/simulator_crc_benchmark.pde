@@ -0,0 +1,144 @@
+// simulator_crc_benchmark.pde
+// -*- mode: C++ -*-
+// Benchmark of the RHCRC routines against the original bit-at-a-time implementations,
+// reporting CPU cycles (on x86) and nanoseconds per octet for each.
+// Also checks that the table driven and block routines agree with the originals.
+// Tested on Linux
+// Build with
+// cd whatever/RadioHead 
+// tools/simBuild examples/simulator/simulator_crc_benchmark/simulator_crc_benchmark.pde
+// Run with ./simulator_crc_benchmark [octets]
+
+#include <RHCRC.h>
+#include <time.h>
+#if defined(__i386__) || defined(__x86_64__)
+ #include <x86intrin.h>
+ #define HAVE_RDTSC
+#endif
+
+// The original bitwise routines, for comparison
+static uint16_t bitwise_crc16_update(uint16_t crc, uint8_t a)
+{
+    crc ^= a;
+    for (uint8_t i = 0; i < 8; ++i)
+	crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : (crc >> 1);
+    return crc;
+}
+
+static uint16_t bitwise_xmodem_update(uint16_t crc, uint8_t data)
+{
+    crc = crc ^ ((uint16_t)data << 8);
+    for (uint8_t i = 0; i < 8; i++)
+	crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+    return crc;
+}
+
+static uint16_t bitwise_ccitt_update(uint16_t crc, uint8_t data)
+{
+    data ^= crc & 0xff;
+    data ^= data << 4;
+    return ((((uint16_t)data << 8) | (crc >> 8)) ^ (uint8_t)(data >> 4) ^ ((uint16_t)data << 3));
+}
+
+typedef uint16_t (*UpdateFn)(uint16_t, uint8_t);
+typedef uint16_t (*BlockFn)(uint16_t, const uint8_t*, uint16_t);
+
+#define BLOCK_LEN 60 // A typical RH_ASK message
+#define MAX_OCTETS 100000000
+static uint8_t* data;
+static unsigned long octets = 10000000;
+static volatile uint16_t sink; // Prevents the compiler optimising the work away
+
+static double nowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint64_t cycles()
+{
+#ifdef HAVE_RDTSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static void report(const char* name, double ns, uint64_t cyc)
+{
+    printf("%-28s %6.2f ns/octet", name, ns / octets);
+#ifdef HAVE_RDTSC
+    printf(" %6.2f cycles/octet", (double)cyc / octets);
+#endif
+    printf(" %8.1f MB/s\n", octets / ns * 1e3);
+}
+
+// Time the update routine, one octet at a time, in BLOCK_LEN sized messages
+static uint16_t benchUpdate(const char* name, UpdateFn fn, uint16_t init)
+{
+    uint16_t crc = 0;
+    double t = nowNs();
+    uint64_t c = cycles();
+    for (unsigned long i = 0; i + BLOCK_LEN <= octets; i += BLOCK_LEN)
+    {
+	crc = init;
+	for (uint8_t j = 0; j < BLOCK_LEN; j++)
+	    crc = fn(crc, data[i + j]);
+	sink = crc;
+    }
+    report(name, nowNs() - t, cycles() - c);
+    return crc;
+}
+
+// Time the block routine, once per BLOCK_LEN sized message
+static uint16_t benchBlock(const char* name, BlockFn fn, uint16_t init)
+{
+    uint16_t crc = 0;
+    double t = nowNs();
+    uint64_t c = cycles();
+    for (unsigned long i = 0; i + BLOCK_LEN <= octets; i += BLOCK_LEN)
+    {
+	crc = fn(init, data + i, BLOCK_LEN);
+	sink = crc;
+    }
+    report(name, nowNs() - t, cycles() - c);
+    return crc;
+}
+
+static void compare(const char* name, uint16_t a, uint16_t b, uint16_t c)
+{
+    if (a != b || a != c)
+	printf("MISMATCH in %s: %04x %04x %04x\n", name, a, b, c);
+}
+
+void setup() 
+{
+    if (_simulator_argc >= 2)
+	octets = atol(_simulator_argv[1]);
+    if (octets < BLOCK_LEN || octets > MAX_OCTETS)
+	octets = BLOCK_LEN;
+    data = (uint8_t*)malloc(octets);
+    for (unsigned long i = 0; i < octets; i++)
+	data[i] = random(256);
+
+    printf("RHCRC benchmark, %lu octets in %d octet messages, RH_CRC_SLICES %d\n", octets, BLOCK_LEN, RH_CRC_SLICES);
+    uint16_t a, b, c;
+    a = benchUpdate("ccitt bitwise", bitwise_ccitt_update, 0xffff);
+    b = benchUpdate("RHcrc_ccitt_update", RHcrc_ccitt_update, 0xffff);
+    c = benchBlock("RHcrc_ccitt_block", RHcrc_ccitt_block, 0xffff);
+    compare("ccitt", a, b, c);
+    a = benchUpdate("crc16 bitwise", bitwise_crc16_update, 0xffff);
+    b = benchUpdate("RHcrc16_update", RHcrc16_update, 0xffff);
+    c = benchBlock("RHcrc16_block", RHcrc16_block, 0xffff);
+    compare("crc16", a, b, c);
+    a = benchUpdate("xmodem bitwise", bitwise_xmodem_update, 0);
+    b = benchUpdate("RHcrc_xmodem_update", RHcrc_xmodem_update, 0);
+    c = benchBlock("RHcrc_xmodem_block", RHcrc_xmodem_block, 0);
+    compare("xmodem", a, b, c);
+    exit(0);
+}
+
+void loop()
+{
+}
@@ -0,0 +1,271 @@
+// simulator_fragmented_benchmark.pde
+// -*- mode: C++ -*-
+// Measures how many kilobytes per second of TRANSFER_LEN octet transfers get through, for several
+// message loss rates:
+//  - chunked by the application into messages sent with RHReliableDatagram::sendtoWait()
+//  - the same, sent with RHReliableDatagram::sendtoWindow()
+//  - with RHFragmentedDatagram, reassembled in a buffer big enough for the whole transfer
+//  - with RHFragmentedDatagram, read from a SourceCallback and streamed through the built in
+//    reassembly buffer to a StreamCallback
+// Every transfer received is checked against what was sent.
+// The two nodes are connected by the in process ether in simulator_ether.h, with LATENCY_MS latency.
+// The messages are at most MESSAGE_LEN octets, like RH_ASK.
+// Tested on Linux
+// Build with
+// cd whatever/RadioHead
+// CPPFLAGS=-DRH_RELIABLE_WINDOW=8 tools/simBuild examples/simulator/simulator_fragmented_benchmark/simulator_fragmented_benchmark.pde
+// Run with ./simulator_fragmented_benchmark
+
+#include <RHReliableDatagram.h>
+
+#if !RH_RELIABLE_WINDOW
+#error sendtoWindow() needs RH_RELIABLE_WINDOW, build with CPPFLAGS=-DRH_RELIABLE_WINDOW=8
+#endif
+#include <RHFragmentedDatagram.h>
+
+#define BPS 50000
+#define LATENCY_MS 10
+#define MESSAGE_LEN 60
+#define TRANSFER_LEN 4096
+#define TIMEOUT 100
+#define RUN_MS 10000
+#define WINDOW 8
+
+#define SENDER_ADDRESS 1
+#define RECEIVER_ADDRESS 2
+
+// Application chunk header: transfer number and offset
+#define CHUNK_HEADER_LEN 3
+
+#define ETHER_MESSAGE_LEN MESSAGE_LEN
+#define ETHER_FLIGHTS 80
+
+#include "../simulator_ether.h"
+
+static SimNode senderNode, receiverNode;
+static RHReliableDatagram sender(senderNode, SENDER_ADDRESS);
+static RHReliableDatagram receiver(receiverNode, RECEIVER_ADDRESS);
+static RHFragmentedDatagram fragSender(senderNode, SENDER_ADDRESS);
+static RHFragmentedDatagram fragReceiver(receiverNode, RECEIVER_ADDRESS);
+
+typedef enum
+{
+    Chunked = 0,
+    ChunkedWindow,
+    Fragmented,
+    FragmentedStream
+} Method;
+
+static volatile Method method;
+static volatile bool receiving;
+static volatile uint32_t received, corrupt;
+
+// The data of every transfer is a pattern that depends on the transfer number
+static uint8_t pattern(uint8_t transfer, uint16_t offset)
+{
+    return (offset * 7 + (offset >> 8) + transfer) & 0xff;
+}
+
+static bool check(uint8_t transfer, uint16_t offset, const uint8_t* buf, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++)
+	if (buf[i] != pattern(transfer, offset + i))
+	    return false;
+    return true;
+}
+
+static void source(void* context, uint16_t offset, uint8_t* buf, uint8_t len)
+{
+    uint8_t transfer = *(uint8_t*)context;
+    for (uint8_t i = 0; i < len; i++)
+	buf[i] = pattern(transfer, offset + i);
+}
+
+// Checks streamed data as it arrives. It must arrive in order
+static uint8_t streamTransfer;
+static uint16_t streamNext;
+static bool streamBad;
+static void stream(void* context, uint8_t from, uint16_t offset, const uint8_t* buf, uint16_t len, uint16_t total)
+{
+    (void)context;
+    (void)from;
+    (void)total;
+    if (offset == 0)
+    {
+	streamTransfer = buf[0]; // pattern(transfer, 0)
+	streamNext = 0;
+	streamBad = false;
+    }
+    if (offset != streamNext || !check(streamTransfer, offset, buf, len))
+	streamBad = true;
+    streamNext = offset + len;
+}
+
+// The receiving node. Counts the octets of good transfers received
+static void* receiverThread(void*)
+{
+    static uint8_t whole[TRANSFER_LEN];
+    static bool chunkGot[TRANSFER_LEN / (MESSAGE_LEN - CHUNK_HEADER_LEN) + 1];
+    uint16_t chunksGot = 0;
+    uint8_t chunkTransfer = 0;
+    while (true)
+    {
+	bool got = false;
+	if (method == Chunked || method == ChunkedWindow)
+	{
+	    // Reassemble chunks from the application headers
+	    uint8_t buf[MESSAGE_LEN];
+	    uint8_t len = sizeof(buf);
+	    if (receiver.recvfromAckTimeout(buf, &len, 10) && len > CHUNK_HEADER_LEN)
+	    {
+		got = true;
+		uint16_t offset = buf[1] | (buf[2] << 8);
+		uint8_t chunk = MESSAGE_LEN - CHUNK_HEADER_LEN;
+		uint8_t dataLen = len - CHUNK_HEADER_LEN;
+		if (buf[0] != chunkTransfer)
+		{
+		    chunkTransfer = buf[0];
+		    chunksGot = 0;
+		    memset(chunkGot, 0, sizeof(chunkGot));
+		}
+		if (offset + dataLen <= TRANSFER_LEN && !chunkGot[offset / chunk])
+		{
+		    memcpy(whole + offset, buf + CHUNK_HEADER_LEN, dataLen);
+		    chunkGot[offset / chunk] = true;
+		    chunksGot++;
+		}
+		else
+		    continue; // Seen it before
+		if (chunksGot == (TRANSFER_LEN + chunk - 1) / chunk)
+		{
+		    if (check(chunkTransfer, 0, whole, TRANSFER_LEN))
+			received += TRANSFER_LEN;
+		    else
+			corrupt++;
+		}
+	    }
+	}
+	else
+	{
+	    const uint8_t* buf;
+	    uint16_t len;
+	    if (fragReceiver.recvfromTransferTimeout(&buf, &len, 10))
+	    {
+		got = true;
+		bool good = buf ? check(buf[0], 0, buf, len) : !streamBad && streamNext == len;
+		if (good && len == TRANSFER_LEN)
+		    received += len;
+		else
+		    corrupt++;
+	    }
+	}
+	if (!got && !receiving)
+	    return NULL;
+    }
+}
+
+// Sends transfers for RUN_MS
+// Returns kilobytes delivered per second
+static float run(float lossRate, Method m)
+{
+    etherLoss = lossRate;
+    senderNode.reset();
+    receiverNode.reset();
+    received = corrupt = 0;
+    method = m;
+    sender.setWindow(m == ChunkedWindow ? WINDOW : 0);
+    receiving = true;
+    pthread_t thread;
+    pthread_create(&thread, NULL, receiverThread, NULL);
+
+    static uint8_t data[TRANSFER_LEN];
+    uint8_t transfer = 0;
+    uint32_t failed = 0;
+    unsigned long start = millis();
+    while (millis() - start < RUN_MS)
+    {
+	transfer++;
+	for (uint16_t i = 0; i < TRANSFER_LEN; i++)
+	    data[i] = pattern(transfer, i);
+	bool ok = true;
+	if (m == Chunked || m == ChunkedWindow)
+	{
+	    // The application splits it up
+	    uint8_t chunk = MESSAGE_LEN - CHUNK_HEADER_LEN;
+	    for (uint16_t offset = 0; offset < TRANSFER_LEN; offset += chunk)
+	    {
+		uint8_t buf[MESSAGE_LEN];
+		uint8_t len = (TRANSFER_LEN - offset) < chunk ? (TRANSFER_LEN - offset) : chunk;
+		buf[0] = transfer;
+		buf[1] = offset;
+		buf[2] = offset >> 8;
+		memcpy(buf + CHUNK_HEADER_LEN, data + offset, len);
+		if (m == Chunked)
+		    ok &= sender.sendtoWait(buf, CHUNK_HEADER_LEN + len, RECEIVER_ADDRESS);
+		else
+		    ok &= sender.sendtoWindow(buf, CHUNK_HEADER_LEN + len, RECEIVER_ADDRESS);
+	    }
+	    if (m == ChunkedWindow)
+		ok &= sender.waitWindow();
+	}
+	else if (m == Fragmented)
+	    ok = fragSender.sendtoWait(data, TRANSFER_LEN, RECEIVER_ADDRESS);
+	else
+	    ok = fragSender.sendtoWait(source, &transfer, TRANSFER_LEN, RECEIVER_ADDRESS);
+	if (!ok)
+	    failed++;
+    }
+    unsigned long elapsed = millis() - start;
+
+    // Let the last message arrive
+    delay(LATENCY_MS * 2 + TIMEOUT);
+    receiving = false;
+    pthread_join(thread, NULL);
+    if (failed || corrupt)
+	printf("(%lu failed %lu bad) ", (unsigned long)failed, (unsigned long)corrupt);
+    return received / 1024.0 * 1000.0 / elapsed;
+}
+
+void setup()
+{
+    etherLatencyMs = LATENCY_MS;
+    sender.init();
+    receiver.init();
+    fragSender.init();
+    fragReceiver.init();
+    sender.setTimeout(TIMEOUT);
+    fragSender.setTimeout(TIMEOUT);
+    static uint8_t reassembly[TRANSFER_LEN];
+
+    const float losses[] = { 0.0, 0.05, 0.2 };
+    printf("Kilobytes per second, %d octet transfers in %d octet messages at %d bps, %d ms latency\n",
+	   TRANSFER_LEN, MESSAGE_LEN, BPS, LATENCY_MS);
+    printf("loss   sendtoWait window %d fragmented streamed\n", WINDOW);
+    for (uint8_t l = 0; l < sizeof(losses) / sizeof(losses[0]); l++)
+    {
+	printf("%4.0f%%", losses[l] * 100);
+	fflush(stdout);
+	for (uint8_t m = Chunked; m <= FragmentedStream; m++)
+	{
+	    if (m == Fragmented)
+	    {
+		fragReceiver.setReceiveBuffer(reassembly, sizeof(reassembly));
+		fragReceiver.setStreamCallback(NULL);
+	    }
+	    else if (m == FragmentedStream)
+	    {
+		fragReceiver.setReceiveBuffer(NULL, 0); // The built in RH_FRAGMENT_POOL_SIZE octets
+		fragReceiver.setStreamCallback(stream);
+	    }
+	    printf(" %9.2f", run(losses[l], (Method)m));
+	    fflush(stdout);
+	}
+	printf("\n");
+    }
+    printf("fragments retransmitted: %lu\n", (unsigned long)fragSender.retransmissions());
+    exit(0);
+}
+
+void loop()
+{
+}
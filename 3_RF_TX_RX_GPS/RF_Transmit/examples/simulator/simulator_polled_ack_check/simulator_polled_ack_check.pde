@@ -0,0 +1,149 @@
+// simulator_polled_ack_check.pde
+// -*- mode: C++ -*-
+// Checks that a node that only receives and ACKs with RHReliableDatagram keeps receiving when its
+// driver is polled, like RH_NRF24, RH_NRF905, RH_NRF51 and RH_E32: such a driver only leaves
+// RHModeTx in waitPacketSent(), and available() is false while it is transmitting.
+// Each message is sent by one node and arrives at the other as soon as its airtime has passed.
+// Prints PASS and exits 0 if the receiving node gets and ACKs every message, else prints FAIL and exits 1.
+// Tested on Linux
+// Build with
+// cd whatever/RadioHead
+// tools/simBuild examples/simulator/simulator_polled_ack_check/simulator_polled_ack_check.pde
+// Run with ./simulator_polled_ack_check
+
+#include <RHReliableDatagram.h>
+
+#define MESSAGES 5
+#define AIRTIME_MS 2
+
+#define CLIENT_ADDRESS 1
+#define SERVER_ADDRESS 2
+
+// A driver that works like RH_NRF24: transmissions are only seen to finish in waitPacketSent()
+class PolledNode : public RHGenericDriver
+{
+public:
+    PolledNode() : _peer(NULL), _rxBufValid(false), _inFlight(false) {}
+    void connect(PolledNode* peer) { _peer = peer; }
+
+    bool available()
+    {
+	if (_mode == RHModeTx)
+	    return false;
+	if (_inFlight && millis() - _inFlightSent >= AIRTIME_MS)
+	{
+	    _inFlight = false;
+	    if (!_rxBufValid && (_inFlightHeaders[0] == _thisAddress || _inFlightHeaders[0] == RH_BROADCAST_ADDRESS))
+	    {
+		_rxHeaderTo = _inFlightHeaders[0];
+		_rxHeaderFrom = _inFlightHeaders[1];
+		_rxHeaderId = _inFlightHeaders[2];
+		_rxHeaderFlags = _inFlightHeaders[3];
+		memcpy(_rxBuf, _inFlightBuf, _inFlightLen);
+		_rxBufLen = _inFlightLen;
+		_rxBufValid = true;
+		_rxGood++;
+	    }
+	}
+	return _rxBufValid;
+    }
+
+    bool recv(uint8_t* buf, uint8_t* len)
+    {
+	if (!available())
+	    return false;
+	if (buf && len)
+	{
+	    if (*len > _rxBufLen)
+		*len = _rxBufLen;
+	    memcpy(buf, _rxBuf, *len);
+	}
+	_rxBufValid = false;
+	return true;
+    }
+
+    bool send(const uint8_t* data, uint8_t len)
+    {
+	waitPacketSent();
+	_mode = RHModeTx;
+	_peer->_inFlight = true;
+	_peer->_inFlightSent = millis();
+	_peer->_inFlightHeaders[0] = _txHeaderTo;
+	_peer->_inFlightHeaders[1] = _txHeaderFrom;
+	_peer->_inFlightHeaders[2] = _txHeaderId;
+	_peer->_inFlightHeaders[3] = _txHeaderFlags;
+	memcpy(_peer->_inFlightBuf, data, len);
+	_peer->_inFlightLen = len;
+	_txGood++;
+	return true;
+    }
+
+    bool waitPacketSent()
+    {
+	if (_mode == RHModeTx)
+	{
+	    delay(AIRTIME_MS);
+	    _mode = RHModeIdle;
+	}
+	return true;
+    }
+
+    uint8_t maxMessageLength() { return RH_MAX_MESSAGE_LEN; }
+
+private:
+    PolledNode*     _peer;
+    bool            _rxBufValid;
+    uint8_t         _rxBuf[RH_MAX_MESSAGE_LEN];
+    uint8_t         _rxBufLen;
+    bool            _inFlight;
+    unsigned long   _inFlightSent;
+    uint8_t         _inFlightHeaders[4];
+    uint8_t         _inFlightBuf[RH_MAX_MESSAGE_LEN];
+    uint8_t         _inFlightLen;
+};
+
+static PolledNode clientNode, serverNode;
+static RHReliableDatagram client(clientNode, CLIENT_ADDRESS);
+static RHReliableDatagram server(serverNode, SERVER_ADDRESS);
+
+void setup()
+{
+    clientNode.connect(&serverNode);
+    serverNode.connect(&clientNode);
+    client.init();
+    server.init();
+
+    // Both nodes run in this thread: the client sends, then the server receives and ACKs,
+    // then the client collects the ACK
+    uint8_t received = 0, acked = 0;
+    for (uint8_t i = 0; i < MESSAGES; i++)
+    {
+	uint8_t data[] = "Hello";
+	data[0] += i;
+	client.setHeaderId(i + 1);
+	client.setHeaderFlags(RH_FLAGS_NONE, RH_FLAGS_ACK | RH_FLAGS_RETRY);
+	client.sendto(data, sizeof(data), SERVER_ADDRESS);
+	client.waitPacketSent();
+
+	uint8_t buf[RH_MAX_MESSAGE_LEN];
+	uint8_t len = sizeof(buf);
+	if (server.recvfromAckTimeout(buf, &len, 100) && buf[0] == data[0])
+	    received++;
+
+	if (client.waitAvailableTimeout(100))
+	{
+	    uint8_t flags;
+	    len = sizeof(buf);
+	    if (client.recvfrom(buf, &len, NULL, NULL, NULL, &flags) && (flags & RH_FLAGS_ACK))
+		acked++;
+	}
+    }
+    printf("server received %d of %d, client got %d ACKs\n", received, MESSAGES, acked);
+    bool pass = received == MESSAGES && acked == MESSAGES;
+    printf("%s\n", pass ? "PASS" : "FAIL");
+    exit(pass ? 0 : 1);
+}
+
+void loop()
+{
+}
@@ -0,0 +1,177 @@
+// simulator_reliable_window_benchmark.pde
+// -*- mode: C++ -*-
+// Measures how many messages per second RHReliableDatagram delivers with sendtoWait() (stop and wait)
+// and with sendtoWindow() at several window sizes, for several message loss rates.
+// The two nodes are connected by the in process ether in simulator_ether.h, with LATENCY_MS latency.
+// Add -DHALF_DUPLEX=1 to CPPFLAGS to also lose messages that arrive while the node is transmitting, like a radio.
+// Then the sender leaves a gap of GAP_MS after each message for its ACK (setWindowGap()).
+// The last row is a receiver using the RadioHead 1.92 ACK, to show sendtoWindow() falling back to one
+// message at a time with older nodes.
+// Tested on Linux
+// Build with
+// cd whatever/RadioHead
+// CPPFLAGS=-DRH_RELIABLE_WINDOW=8 tools/simBuild examples/simulator/simulator_reliable_window_benchmark/simulator_reliable_window_benchmark.pde
+// Run with ./simulator_reliable_window_benchmark
+
+#include <RHReliableDatagram.h>
+
+#if !RH_RELIABLE_WINDOW
+#error sendtoWindow() needs RH_RELIABLE_WINDOW, build with CPPFLAGS=-DRH_RELIABLE_WINDOW=8
+#endif
+
+#define BPS 10000        // Like etherSimulator.pl
+#define LATENCY_MS 10
+#define MESSAGE_LEN 32
+#define TIMEOUT 100
+#define RUN_MS 4000
+#ifndef HALF_DUPLEX
+ #define HALF_DUPLEX 0
+#endif
+#define GAP_MS (LATENCY_MS * 2 + 15) // Time for the receiver to notice a message and ACK it
+
+#define SENDER_ADDRESS 1
+#define RECEIVER_ADDRESS 2
+#define LEGACY_ADDRESS 3 // The sender remembers which nodes send window ACKs
+
+#include "../simulator_ether.h"
+
+static SimNode senderNode, receiverNode;
+static RHReliableDatagram sender(senderNode, SENDER_ADDRESS);
+static RHReliableDatagram receiver(receiverNode, RECEIVER_ADDRESS);
+
+static volatile bool receiving;
+static volatile bool legacyReceiver;
+static volatile uint32_t delivered, duplicates;
+static uint8_t seen[65536 / 8]; // Messages delivered, by sequence number
+
+// The receiving node. Counts the messages delivered, and any duplicates
+static void* receiverThread(void*)
+{
+    uint8_t lastId = 0;
+    while (true)
+    {
+	uint8_t buf[RH_MAX_MESSAGE_LEN];
+	uint8_t len = sizeof(buf);
+	uint8_t from, to, id, flags;
+	bool got;
+	if (legacyReceiver)
+	{
+	    // RHReliableDatagram before window ACKs: 1 octet ACK, and only the latest ID is recognised
+	    got = false;
+	    if (receiver.waitAvailableTimeout(10)
+		&& receiver.recvfrom(buf, &len, &from, &to, &id, &flags)
+		&& !(flags & RH_FLAGS_ACK))
+	    {
+		receiver.setHeaderId(id);
+		receiver.setHeaderFlags(RH_FLAGS_ACK);
+		uint8_t ack = '!';
+		receiver.sendto(&ack, sizeof(ack), from);
+		got = id != lastId;
+		lastId = id;
+	    }
+	}
+	else
+	    got = receiver.recvfromAckTimeout(buf, &len, 10);
+	if (got && len >= 2)
+	{
+	    uint16_t seq = buf[0] | (buf[1] << 8);
+	    if (seen[seq >> 3] & (1 << (seq & 7)))
+		duplicates++;
+	    else
+		delivered++;
+	    seen[seq >> 3] |= 1 << (seq & 7);
+	}
+	else if (!receiving)
+	    return NULL;
+    }
+}
+
+// Sends for RUN_MS, then waits for the rest to be acknowledged
+// Returns messages delivered per second
+static float run(float lossRate, uint8_t window, bool legacy)
+{
+    etherLoss = lossRate;
+    senderNode.reset();
+    receiverNode.reset();
+    sender.setWindow(window);
+    delivered = duplicates = 0;
+    memset(seen, 0, sizeof(seen));
+    legacyReceiver = legacy;
+    uint8_t address = legacy ? LEGACY_ADDRESS : RECEIVER_ADDRESS;
+    receiver.setThisAddress(address);
+    receiving = true;
+    pthread_t thread;
+    pthread_create(&thread, NULL, receiverThread, NULL);
+
+    uint8_t buf[MESSAGE_LEN];
+    memset(buf, 0, sizeof(buf));
+    uint16_t seq = 0;
+    uint32_t failed = 0;
+    unsigned long start = millis();
+    while (millis() - start < RUN_MS)
+    {
+	buf[0] = seq;
+	buf[1] = seq >> 8;
+	seq++;
+	if (window == 0)
+	{
+	    if (!sender.sendtoWait(buf, sizeof(buf), address))
+		failed++;
+	}
+	else
+	    sender.sendtoWindow(buf, sizeof(buf), address);
+    }
+    if (window && !sender.waitWindow())
+	failed++;
+    unsigned long elapsed = millis() - start;
+
+    // Let the last message arrive
+    delay(LATENCY_MS * 2 + TIMEOUT);
+    receiving = false;
+    pthread_join(thread, NULL);
+    if (duplicates)
+	printf("(%lu duplicates) ", (unsigned long)duplicates);
+    return delivered * 1000.0 / elapsed;
+}
+
+void setup()
+{
+    etherLatencyMs = LATENCY_MS;
+    etherHalfDuplex = HALF_DUPLEX;
+    sender.init();
+    receiver.init();
+    sender.setTimeout(TIMEOUT);
+#if HALF_DUPLEX
+    sender.setWindowGap(GAP_MS);
+#endif
+
+    const float losses[] = { 0.0, 0.05, 0.2 };
+    const uint8_t windows[] = { 0, 1, 2, 4, 8 };
+    printf("Messages per second, %d octets at %d bps, %d ms latency%s\n",
+	   MESSAGE_LEN, BPS, LATENCY_MS, HALF_DUPLEX ? ", half duplex with window gap" : "");
+    printf("loss   sendtoWait window 1  window 2  window 4  window 8\n");
+    for (uint8_t l = 0; l < sizeof(losses) / sizeof(losses[0]); l++)
+    {
+	printf("%4.0f%%", losses[l] * 100);
+	fflush(stdout);
+	for (uint8_t w = 0; w < sizeof(windows); w++)
+	{
+	    printf(" %9.1f", run(losses[l], windows[w], false));
+	    fflush(stdout);
+	}
+	printf("\n");
+    }
+    printf("legacy receiver, %.0f%% loss:\n", losses[1] * 100);
+    printf("     ");
+    for (uint8_t w = 0; w < sizeof(windows); w++)
+    {
+	printf(" %9.1f", run(losses[1], windows[w], true));
+	fflush(stdout);
+    }
+    printf("\nsender retransmissions: %lu\n", (unsigned long)sender.retransmissions());
+    exit(0);
+}
+
+void loop()
+{
+}
@@ -0,0 +1,142 @@
+// simulator_wait_events.pde
+// -*- mode: C++ -*-
+// Measures how much CPU the application thread uses while it waits in waitAvailableTimeout(),
+// and how long after the receiver queues a message the wait returns.
+// A timer thread plays the part of the timer interrupt: every millisecond it runs the handlers
+// of an RH_ASK transmitter and receiver for the timer ticks that are due, with the transmitter
+// output fed straight to the receiver, and the transmitter sends a message every GAP_MS.
+// The main thread collects the messages, first with the receiver waking it up (event driven),
+// then also waking every RH_WAIT_POLL_MS to poll, as it does for drivers without interrupts.
+// Build with CPPFLAGS=-DRH_WAIT_EVENTS=0 to see the old busy wait instead.
+// Tested on Linux
+// Build with
+// cd whatever/RadioHead
+// tools/simBuild examples/simulator/simulator_wait_events/simulator_wait_events.pde
+// Run with ./simulator_wait_events
+
+#include <RH_ASK.h>
+#include <pthread.h>
+#include <time.h>
+
+#define SPEED 2000
+#define MESSAGE_LEN 20   // Like a GPS position
+#define GAP_MS 250
+#define RUN_MS 5000
+
+static uint64_t nanos(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Drive the drivers one timer tick at a time
+class SimASK : public RH_ASK
+{
+public:
+    SimASK() : RH_ASK(SPEED) {}
+    bool tick(bool level) { _rxLevel = level; handleTimerInterrupt(); return _txLevel; }
+    uint8_t queued() { return _rxHead; }
+    void setEventDriven(bool eventDriven) { _eventDriven = eventDriven; }
+};
+
+static SimASK tx, rx;
+static volatile bool running;
+static volatile uint64_t queuedAt[256]; // When rx queued each message
+static volatile uint32_t queuedCount;
+static uint32_t takenCount;
+
+static void* timerThread(void*)
+{
+    uint64_t start = nanos(CLOCK_MONOTONIC);
+    uint64_t ticks = 0, sendAt = 0;
+    uint8_t buf[MESSAGE_LEN];
+    uint8_t seq = 0;
+    struct timespec until;
+    clock_gettime(CLOCK_MONOTONIC, &until);
+    while (running)
+    {
+	// Sleep until the next millisecond, then catch up with the ticks that are due
+	until.tv_nsec += 1000000L;
+	if (until.tv_nsec >= 1000000000L)
+	{
+	    until.tv_sec++;
+	    until.tv_nsec -= 1000000000L;
+	}
+	clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL);
+	uint64_t due = (nanos(CLOCK_MONOTONIC) - start) * 8 * SPEED / 1000000000ULL;
+	for (; ticks < due; ticks++)
+	{
+	    if (ticks >= sendAt && tx.mode() != RHGenericDriver::RHModeTx)
+	    {
+		memset(buf, seq++, sizeof(buf));
+		tx.send(buf, sizeof(buf));
+		sendAt = ticks + (uint64_t)GAP_MS * 8 * SPEED / 1000;
+	    }
+	    uint8_t head = rx.queued();
+	    rx.tick(tx.tick(false));
+	    if (rx.queued() != head)
+		queuedAt[queuedCount++ & 0xff] = nanos(CLOCK_MONOTONIC);
+	}
+    }
+    return NULL;
+}
+
+static void run(const char* name)
+{
+    uint8_t buf[RH_ASK_MAX_MESSAGE_LEN];
+    uint8_t len;
+    unsigned long received = 0;
+    uint64_t latency = 0, maxLatency = 0;
+
+    pthread_t timer;
+    running = true;
+    pthread_create(&timer, NULL, timerThread, NULL);
+    uint64_t cpu = nanos(CLOCK_THREAD_CPUTIME_ID);
+    unsigned long start = millis();
+    while (millis() - start < RUN_MS)
+    {
+	if (!rx.waitAvailableTimeout(100))
+	    continue;
+	uint64_t woke = nanos(CLOCK_MONOTONIC);
+	len = sizeof(buf);
+	if (rx.recv(buf, &len))
+	{
+	    // The timer thread notes the time just after the handler queues the message
+	    while (queuedCount <= takenCount)
+		;
+	    uint64_t at = queuedAt[takenCount++ & 0xff];
+	    uint64_t wait = woke > at ? woke - at : 0;
+	    received++;
+	    latency += wait;
+	    if (wait > maxLatency)
+		maxLatency = wait;
+	}
+    }
+    cpu = nanos(CLOCK_THREAD_CPUTIME_ID) - cpu;
+    running = false;
+    pthread_join(timer, NULL);
+
+    printf("%-14s %8lu %9.1f%% %12.1f %12.1f\n", name, received, cpu * 100.0 / (RUN_MS * 1000000.0),
+	   received ? latency / 1000.0 / received : 0.0, maxLatency / 1000.0);
+}
+
+void setup()
+{
+    tx.init();
+    rx.init();
+    printf("%d octet messages every %d ms at %d bps, for %d ms each\n", MESSAGE_LEN, GAP_MS, SPEED, RUN_MS);
+    printf("%-14s %8s %10s %12s %12s\n", "wait", "received", "cpu", "mean us", "max us");
+#if RH_WAIT_EVENTS
+    run("event driven");
+    rx.setEventDriven(false);
+    run("also polled");
+#else
+    run("busy wait");
+#endif
+    exit(0);
+}
+
+void loop()
+{
+}